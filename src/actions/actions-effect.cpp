@@ -104,8 +104,13 @@ void add_document_actions_effect(SPDocument *doc)
 {
     auto group = doc->getActionGroup();
 
-    for (auto mod : Inkscape::Extension::db.get_effect_list()) {
-        group->add_action( mod->get_sanitized_id(), [=]() { mod->effect(nullptr, doc); });
+    // By ID, so that effects which are not built yet are only built when they are run.
+    for (auto const &id : Inkscape::Extension::db.get_effect_ids()) {
+        group->add_action(Inkscape::Extension::Effect::sanitize_id(id), [=]() {
+            if (auto mod = dynamic_cast<Inkscape::Extension::Effect *>(Inkscape::Extension::db.get(id.c_str()))) {
+                mod->effect(nullptr, doc);
+            }
+        });
     }
 
     // No extra information required to be added to the app
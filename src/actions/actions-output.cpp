@@ -10,6 +10,8 @@
 
 #include "actions-output.h"
 
+#include <algorithm>
+
 #include <giomm.h>  // Not <gtkmm.h>! To eventually allow a headless version!
 #include <glibmm/i18n.h>
 
@@ -229,6 +231,13 @@ export_png_antialias(const Glib::VariantBase&  value, InkscapeApplication *app)
     app->file_export()->export_png_antialias = i.get();
 }
 
+void
+export_jobs(const Glib::VariantBase&  value, InkscapeApplication *app)
+{
+    Glib::Variant<int> i = Glib::VariantBase::cast_dynamic<Glib::Variant<int> >(value);
+    app->file_export()->export_jobs = std::max(i.get(), 1);
+}
+
 void
 export_do(InkscapeApplication *app)
 {
@@ -276,6 +285,7 @@ std::vector<std::vector<Glib::ustring>> raw_data_output =
     {"app.export-png-use-dithering",  N_("Export PNG Dithering"),      "Export",     N_("Set dithering for PNG export")                       },
     {"app.export-png-compression",    N_("Export PNG Compression"),    "Export",     N_("Set compression level for PNG export")               },
     {"app.export-png-antialias",      N_("Export PNG Antialiasing"),      "Export",     N_("Set antialiasing level for PNG export")                 },
+    {"app.export-jobs",               N_("Export Jobs"),               "Export",     N_("Set number of objects or pages to export to PNG concurrently")},
 
     {"app.export-do",                 N_("Do Export"),                 "Export",     N_("Do export")                                          }
     // clang-format on
@@ -312,7 +322,8 @@ std::vector<std::vector<Glib::ustring>> hint_data_output =
     {"app.export-png-color-mode",     N_("Enter string for PNG Color Mode, one of Gray_1/Gray_2/Gray_4/Gray_8/Gray_16/RGB_8/RGB_16/GrayAlpha_8/GrayAlpha_16/RGBA_8/RGBA_16")},
     {"app.export-png-use-dithering",  N_("Enter 1/0 for Yes/No to use dithering")          },
     {"app.export-png-compression",    N_("Enter integer for PNG compression level (0 (none) to 9 (max))")},
-    {"app.export-png-antialias",      N_("Enter integer for PNG antialiasing level (0 (none) to 3 (best))")}
+    {"app.export-png-antialias",      N_("Enter integer for PNG antialiasing level (0 (none) to 3 (best))")},
+    {"app.export-jobs",               N_("Enter integer for number of concurrent PNG exports")           }
     // clang-format on
 };
 
@@ -361,6 +372,7 @@ add_actions_output(InkscapeApplication* app)
     gapp->add_action_with_parameter( "export-png-use-dithering", Bool,   sigc::bind(sigc::ptr_fun(&export_png_use_dithering), app));
     gapp->add_action_with_parameter( "export-png-compression",   Int,    sigc::bind(sigc::ptr_fun(&export_png_compression),   app));
     gapp->add_action_with_parameter( "export-png-antialias",     Int,    sigc::bind(sigc::ptr_fun(&export_png_antialias),     app));
+    gapp->add_action_with_parameter( "export-jobs",              Int,    sigc::bind(sigc::ptr_fun(&export_jobs),              app));
 
     // Extra
     gapp->add_action(                "export-do",                        sigc::bind(sigc::ptr_fun(&export_do),           app));
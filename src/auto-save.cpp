@@ -26,10 +26,11 @@
 #include "document.h"
 #include "inkscape-application.h"
 #include "preferences.h"
-#include "extension/output.h"
+#include "async/async.h"
 #include "helper/auto-connection.h"
 #include "io/sys.h"
 #include "xml/repr.h"
+#include "xml/serialization-cache.h"
 
 #ifdef _WIN32
 #include <process.h>
@@ -67,10 +68,24 @@ AutoSave::start()
     }
 }
 
+/**
+ * Autosave all modified documents.
+ *
+ * The documents are serialized into snapshots on the main thread, which is cheap for subtrees
+ * that didn't change since the previous save, while writing the files happens in the background
+ * so that editing can go on. The oldest autosaves are deleted once some of the new files have
+ * been written.
+ */
 bool
 AutoSave::save()
 {
+    if (_writing) {
+        // The previous autosave is still being written; try again at the next interval.
+        return true;
+    }
+
     std::vector<SPDocument *> documents = _app->get_documents();
+
     if (documents.empty()) {
         // Nothing to save!
         return true;
@@ -102,79 +117,134 @@ AutoSave::save()
     std::stringstream datetime;
     datetime << std::put_time(&tm, "%Y_%m_%d_%H_%M_%S");
 
+    struct PendingWrite
+    {
+        SPDocument *document;
+        std::string path;
+        std::shared_ptr<Inkscape::XML::SerializedDocument const> snapshot;
+    };
+    std::vector<PendingWrite> writes;
+
+    std::string base_name = "automatic-save-" + std::to_string(uid);
     int docnum = 0;
-    int autosave_max = prefs->getInt("/options/autosave/max", 10);
     for (auto document : documents) {
 
         ++docnum; // Give each document a unique number.
 
-        if (document->isModifiedSinceAutoSave()) {
-            std::string base_name = "automatic-save-" + std::to_string(uid);
-
-            // The following we do for each document (rather wasteful...) so that
-            // we make room for each document that needs saving. We probably should
-            // be counting per document and not overall documents.
-
-            // Open directory
-            Glib::Dir directory(autosave_dir);
-            std::vector<std::string> file_names(directory.begin(), directory.end());
-
-            // Sort them so that oldest are last (file name encodes time).
-            std::sort(file_names.begin(), file_names.end(), std::greater<std::string>());
-
-            // Delete oldest files.
-            int count = 0;
-            for (auto &file_name : file_names) {
-                if (file_name.compare(0, base_name.size(), base_name) == 0) {
-                    ++count;
-                    if (count >= autosave_max) {
-                        // Delete (making room for one more).
-                        std::string path = Glib::build_filename(autosave_dir, file_name);
-                        if (unlink(path.c_str()) == -1) {
-                            std::cerr << "InkscapeApplication::document_autosave: Failed to unlink file: "
-                                      << path << ": " << strerror(errno) << std::endl;
-                        }
-                    }
-                }
-            }
-
+        if (document->isModifiedSinceAutoSave() || _retry.count(document)) {
             // Construct save file path
-            // datetime MUST happen first, otherwise the above sorting will fail
+            // datetime MUST happen first, otherwise the sorting in prune() will fail
             std::string filename = base_name + "-" + datetime.str() + "-" + std::to_string(pid) + "-" + std::to_string(docnum) + ".svg";
             std::string path = Glib::build_filename(autosave_dir, filename.c_str());
 
-            // Try to save the file
-            // Following code needs to be reviewed
-            FILE *file = Inkscape::IO::fopen_utf8name(path.c_str(), "w");
-            gchar *errortext = nullptr;
-            if (file) {
-                try {
-                    Inkscape::XML::Node *repr = document->getReprRoot();
-                    sp_repr_save_stream(repr->document(), file, SP_SVG_NS_URI);
-                } catch (Inkscape::Extension::Output::no_extension_found &e) {
-                    errortext = g_strdup(_("Autosave failed! Could not find inkscape extension to save document."));
-                } catch (Inkscape::Extension::Output::save_failed &e) {
-                    auto const safeUri = Inkscape::IO::sanitizeString(path.c_str());
-                    errortext = g_strdup_printf(_("Autosave failed! File %s could not be saved."), safeUri.c_str());
-                }
-                fclose(file);
-            } else {
-                auto const safeUri = Inkscape::IO::sanitizeString(path.c_str());
-                errortext = g_strdup_printf(_("Autosave failed! File %s could not be saved."), safeUri.c_str());
-            }
+            // Take the snapshot; later changes mark the document as modified again.
+            auto snapshot = sp_repr_save_snapshot(document->getReprDoc(), SP_SVG_NS_URI,
+                                                  document->getSerializationCache());
+            writes.push_back({document, std::move(path), std::move(snapshot)});
+            document->setModifiedSinceAutoSaveFalse();
+            _retry.erase(document);
+        }
+    } // Loop over documents
+
+    if (writes.empty()) {
+        return true;
+    }
+
+    auto [src, dst] = Async::Channel::create();
+    _channel = std::move(dst);
+    _writing = true;
 
-            if (errortext) {
-                g_warning("%s", errortext);
-                g_free(errortext);
-            } else {
-                document->setModifiedSinceAutoSaveFalse();
+    Async::fire_and_forget([src = std::move(src), writes = std::move(writes), autosave_dir, base_name] () mutable {
+        std::vector<SPDocument *> failed;
+        for (auto &write : writes) {
+            if (!sp_repr_save_snapshot_file(*write.snapshot, write.path.c_str())) {
+                auto const safeUri = Inkscape::IO::sanitizeString(write.path.c_str());
+                g_warning(_("Autosave failed! File %s could not be saved."), safeUri.c_str());
+                failed.push_back(write.document);
             }
+            write.snapshot.reset();
         }
-    } // Loop over documents
+        bool const written = failed.size() < writes.size();
+        src.run([failed = std::move(failed), written, autosave_dir = std::move(autosave_dir),
+                 base_name = std::move(base_name)] {
+            AutoSave::getInstance().finished(failed);
+            if (written) {
+                // Only make room once there is a newer file to replace the old ones.
+                AutoSave::prune(autosave_dir, base_name);
+            }
+        });
+    });
 
     return true;
 }
 
+/**
+ * Called on the main thread once the files of an autosave have been written.
+ *
+ * \param failed The documents whose file couldn't be written, to be saved again next time
+ *               even if they are not modified until then.
+ */
+void
+AutoSave::finished(std::vector<SPDocument *> const &failed)
+{
+    _writing = false;
+
+    // Skip the documents which have been closed while their files were being written.
+    auto const documents = _app->get_documents();
+    for (auto document : failed) {
+        if (std::find(documents.begin(), documents.end(), document) != documents.end()) {
+            _retry.insert(document);
+        }
+    }
+}
+
+/**
+ * Called when a document is closed, so that a failed autosave isn't retried for it.
+ */
+void
+AutoSave::forget(SPDocument *document)
+{
+    _retry.erase(document);
+}
+
+/**
+ * Delete the oldest autosave files in a directory, leaving as many as the preferences allow.
+ *
+ * \param base_name The start of the names of the files to consider.
+ */
+void
+AutoSave::prune(std::string const &autosave_dir, std::string const &base_name)
+{
+    int autosave_max = Inkscape::Preferences::get()->getInt("/options/autosave/max", 10);
+
+    // Open directory
+    std::vector<std::string> file_names;
+    try {
+        Glib::Dir directory(autosave_dir);
+        file_names.assign(directory.begin(), directory.end());
+    } catch (Glib::FileError const &) {
+        return; // Removed since the files were written.
+    }
+
+    // Sort them so that oldest are last (file name encodes time).
+    std::sort(file_names.begin(), file_names.end(), std::greater<std::string>());
+
+    // Delete oldest files.
+    int count = 0;
+    for (auto &file_name : file_names) {
+        if (file_name.compare(0, base_name.size(), base_name) == 0) {
+            ++count;
+            if (count > autosave_max) {
+                std::string path = Glib::build_filename(autosave_dir, file_name);
+                if (unlink(path.c_str()) == -1) {
+                    std::cerr << "InkscapeApplication::document_autosave: Failed to unlink file: "
+                              << path << ": " << strerror(errno) << std::endl;
+                }
+            }
+        }
+    }
+}
+
 void
 AutoSave::restart()
 {
@@ -13,7 +13,14 @@
 #ifndef INKSCAPE_AUTOSAVE_H
 #define INKSCAPE_AUTOSAVE_H
 
+#include <set>
+#include <string>
+#include <vector>
+
+#include "async/channel.h"
+
 class InkscapeApplication;
+class SPDocument;
 
 namespace Inkscape {
 
@@ -37,9 +44,16 @@ public:
     void init(InkscapeApplication *app);
     void start(); // Includes restarting.
     bool save();
+    void forget(SPDocument *document);
 
 private:
+    void finished(std::vector<SPDocument *> const &failed);
+    static void prune(std::string const &autosave_dir, std::string const &base_name);
+
     InkscapeApplication* _app = nullptr;
+    Async::Channel::Dest _channel; ///< Reports the completion of the files being written.
+    bool _writing = false;         ///< Whether files are being written in the background.
+    std::set<SPDocument *> _retry; ///< Documents to be saved again after a failed save.
 };
 
 } // namespace Inkscape
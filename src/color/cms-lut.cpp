@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * A 3D lookup table standing in for a colour transform of 8-bit pixels.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "cms-lut.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace Inkscape {
+
+CMSLut::CMSLut(Sampler const &sample, int points)
+    : _points(points)
+{
+    assert(points >= 2);
+
+    std::vector<std::uint16_t> in;
+    in.reserve(points * points * points * 3);
+    for (int i2 = 0; i2 < points; i2++) {
+        for (int i1 = 0; i1 < points; i1++) {
+            for (int i0 = 0; i0 < points; i0++) {
+                for (int i : {i0, i1, i2}) {
+                    in.push_back((i * 65535 + (points - 1) / 2) / (points - 1));
+                }
+            }
+        }
+    }
+
+    std::vector<std::uint16_t> out(in.size());
+    sample(in.data(), out.data(), in.size() / 3);
+
+    _nodes.resize(in.size() / 3 * 4);
+    for (std::size_t i = 0; i < in.size() / 3; i++) {
+        std::copy_n(&out[i * 3], 3, &_nodes[i * 4]);
+    }
+}
+
+void CMSLut::apply(unsigned char *px, unsigned count) const
+{
+    int const stride[3] = {4, 4 * _points, 4 * _points * _points};
+
+    for (unsigned n = 0; n < count; n++, px += 4) {
+        // Find the cell of the grid the colour is in, and where in the cell, in 255ths.
+        int base = 0;
+        int f[3];
+        for (int c = 0; c < 3; c++) {
+            int const t = px[c] * (_points - 1);
+            int i = t / 255;
+            f[c] = t % 255;
+            if (i == _points - 1) {
+                i--;
+                f[c] = 255;
+            }
+            base += i * stride[c];
+        }
+
+        // Tetrahedral interpolation: walk from the low corner of the cell to the high one along
+        // the axes in the order of decreasing fraction.
+        int a = 0, b = 1, c = 2;
+        if (f[a] < f[b]) std::swap(a, b);
+        if (f[b] < f[c]) std::swap(b, c);
+        if (f[a] < f[b]) std::swap(a, b);
+
+        auto const n0 = &_nodes[base];
+        auto const n1 = n0 + stride[a];
+        auto const n2 = n1 + stride[b];
+        auto const n3 = n2 + stride[c];
+        for (int k = 0; k < 3; k++) {
+            int const v = n0[k] * 255 + f[a] * (n1[k] - n0[k]) + f[b] * (n2[k] - n1[k]) + f[c] * (n3[k] - n2[k]);
+            px[k] = (v + 257 * 255 / 2) / (257 * 255);
+        }
+    }
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
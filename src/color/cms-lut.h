@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * A 3D lookup table standing in for a colour transform of 8-bit pixels.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef INKSCAPE_COLOR_CMS_LUT_H
+#define INKSCAPE_COLOR_CMS_LUT_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace Inkscape {
+
+/**
+ * The colours of a transform sampled on a grid, from which 8-bit pixels are transformed by
+ * tetrahedral interpolation.
+ *
+ * Used for the display transform, which runs on every tile drawn on the canvas: a lookup and a
+ * few integer operations per pixel are cheaper than LCMS' own pipeline, in particular for
+ * proofing transforms, which chain three profiles.
+ *
+ * Pixels have four bytes, of which the first three are colour channels; the fourth, usually
+ * alpha, is left alone.
+ */
+class CMSLut
+{
+public:
+    /// Transforms \a count colours of three 16-bit channels.
+    using Sampler = std::function<void(std::uint16_t const *in, std::uint16_t *out, unsigned count)>;
+
+    /// Sample the transform at \a points values of each channel, including 0 and the maximum.
+    explicit CMSLut(Sampler const &sample, int points = 33);
+
+    /// Transform \a count pixels in place.
+    void apply(unsigned char *px, unsigned count) const;
+
+private:
+    int _points;
+    std::vector<std::uint16_t> _nodes; ///< Three channels and padding per grid point
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_COLOR_CMS_LUT_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -13,8 +13,12 @@
 
 #include "cms-system.h"
 
+#include <algorithm>
+#include <future>
 #include <iomanip>
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <glibmm.h>
 
 #include "cms-util.h"
@@ -383,6 +387,101 @@ void CMSSystem::do_transform(cmsHTRANSFORM transform, unsigned char *inBuf, unsi
     cmsDoTransform(transform, inBuf, outBuf, size);
 }
 
+void CMSTransform::apply(unsigned char *px, int width, int height, int stride) const
+{
+    for (int y = 0; y < height; y++) {
+        auto row = px + y * stride;
+        if (_lut) {
+            _lut->apply(row, width);
+        } else {
+            cmsDoTransform(_handle, row, row, width);
+        }
+    }
+}
+
+/**
+ * Transform the pixels of an image in place. Large images are split into bands of rows which
+ * are transformed concurrently on up to \a numthreads threads; transforms of 8-bit pixels can be
+ * shared between threads.
+ */
+void CMSSystem::transform_image(CMSTransform const &transform, unsigned char *px, int width, int height, int stride,
+                                int numthreads)
+{
+    // Below this, starting the threads costs more than they save.
+    constexpr int min_band_pixels = 1 << 16;
+    int const band_height = std::max(min_band_pixels / std::max(width, 1), 1);
+    int const numbands = std::min((height + band_height - 1) / band_height, numthreads);
+    if (numbands <= 1) {
+        transform.apply(px, width, height, stride);
+        return;
+    }
+
+    auto pool = boost::asio::thread_pool(numbands);
+    std::vector<std::future<void>> bands;
+    bands.reserve(numbands);
+    for (int i = 0; i < numbands; i++) {
+        int const y0 = height * i / numbands;
+        int const y1 = height * (i + 1) / numbands;
+        auto task = std::make_shared<std::packaged_task<void()>>([&, y0, y1] {
+            transform.apply(px + y0 * stride, width, y1 - y0, stride);
+        });
+        bands.push_back(task->get_future());
+        boost::asio::post(pool, [task] { (*task)(); });
+    }
+    for (auto &band : bands) {
+        band.get(); // rethrows exceptions of the worker
+    }
+}
+
+/**
+ * Get a transform of RGBA pixels from \a profile to sRGB. Transforms are kept by the ID of the
+ * profile, so that images sharing a profile, or updated repeatedly, don't each rebuild one.
+ */
+std::shared_ptr<CMSTransform const> CMSSystem::get_image_transform(cmsHPROFILE profile, int intent)
+{
+    cmsUInt8Number id[16];
+    cmsGetHeaderProfileID(profile, id);
+    if (std::all_of(std::begin(id), std::end(id), [] (auto b) { return b == 0; })) {
+        // Most profiles leave the ID unset.
+        cmsMD5computeID(profile);
+        cmsGetHeaderProfileID(profile, id);
+    }
+
+    auto key = std::string(reinterpret_cast<char const *>(id), sizeof(id));
+    key += static_cast<char>(intent);
+
+    if (auto transform = image_transforms.get(key)) {
+        return *transform;
+    }
+
+    auto transform = std::shared_ptr<CMSTransform const>(
+        CMSTransform::create(cmsCreateTransform(profile, TYPE_RGBA_8, sRGB_profile, TYPE_RGBA_8, intent, 0)));
+    if (transform) {
+        image_transforms.insert(key, transform);
+    }
+    return transform;
+}
+
+namespace {
+
+/**
+ * Sample \a sampler, a 16-bit version of the display transform, into a lookup table, and
+ * delete it.
+ */
+std::unique_ptr<CMSLut const> sample_transform(cmsHTRANSFORM sampler)
+{
+    if (!sampler) {
+        return nullptr;
+    }
+    auto lut = std::make_unique<CMSLut const>([sampler] (std::uint16_t const *in, std::uint16_t *out, unsigned count) {
+        cmsDoTransform(sampler, in, out, count);
+    });
+    cmsDeleteTransform(sampler);
+    return lut;
+}
+
+} // namespace
+
 // Called by Canvas to obtain transform.
 // Currently there is one transform for all monitors.
 // Transform immutably shared between CMSSystem and Canvas.
@@ -441,13 +540,28 @@ std::shared_ptr<CMSTransform const> const &CMSSystem::get_cms_transform()
                 dwFlags |= cmsFLAGS_BLACKPOINTCOMPENSATION;
             }
 
-            current_transform = CMSTransform::create(
-                cmsCreateProofingTransform(sRGB_profile, TYPE_BGRA_8, monitor_profile, TYPE_BGRA_8,
-                                           proof_profile, intent, proofIntent, dwFlags));
+            auto handle = cmsCreateProofingTransform(sRGB_profile, TYPE_BGRA_8, monitor_profile, TYPE_BGRA_8,
+                                                     proof_profile, intent, proofIntent, dwFlags);
+
+            // The canvas is drawn through a lookup table, but not with gamut warnings, whose
+            // alarm colour would bleed into neighbouring colours when interpolated.
+            std::unique_ptr<CMSLut const> lut;
+            if (handle && !gamutWarn) {
+                lut = sample_transform(
+                    cmsCreateProofingTransform(sRGB_profile, TYPE_BGR_16, monitor_profile, TYPE_BGR_16,
+                                               proof_profile, intent, proofIntent, dwFlags));
+            }
+            current_transform = CMSTransform::create(handle, std::move(lut));
 
         } else if (monitor_profile) {
-            current_transform = CMSTransform::create(
-                cmsCreateTransform(sRGB_profile, TYPE_BGRA_8, monitor_profile, TYPE_BGRA_8, intent, 0));
+            auto handle = cmsCreateTransform(sRGB_profile, TYPE_BGRA_8, monitor_profile, TYPE_BGRA_8, intent, 0);
+
+            std::unique_ptr<CMSLut const> lut;
+            if (handle) {
+                lut = sample_transform(
+                    cmsCreateTransform(sRGB_profile, TYPE_BGR_16, monitor_profile, TYPE_BGR_16, intent, 0));
+            }
+            current_transform = CMSTransform::create(handle, std::move(lut));
         }
     }
 
@@ -19,6 +19,9 @@
 #include <vector>
 #include <memory>
 #include <cassert>
+#include <string>
+
+#include <boost/compute/detail/lru_cache.hpp>
 
 #include <glibmm/ustring.h>
 #include <gdkmm/rgba.h>
@@ -26,6 +29,7 @@
 #include <lcms2.h>  // cmsHTRANSFORM
 
 #include "cms-color-types.h" // cmsColorSpaceSignature, cmsProfileClassSignature
+#include "cms-lut.h"
 #include "cms-util.h"
 
 class SPDocument;
@@ -38,20 +42,29 @@ class ColorProfile;
 class CMSTransform
 {
 public:
-    explicit CMSTransform(cmsHTRANSFORM handle) : _handle(handle) { assert(_handle); }
+    explicit CMSTransform(cmsHTRANSFORM handle, std::unique_ptr<CMSLut const> lut = {})
+        : _handle(handle)
+        , _lut(std::move(lut))
+    {
+        assert(_handle);
+    }
     CMSTransform(CMSTransform const &) = delete;
     CMSTransform &operator=(CMSTransform const &) = delete;
     ~CMSTransform() { cmsDeleteTransform(_handle); }
 
     cmsHTRANSFORM getHandle() const { return _handle; }
 
-    static std::shared_ptr<CMSTransform> create(cmsHTRANSFORM handle)
+    /// Transform the pixels of a buffer in place, using the lookup table if there is one.
+    void apply(unsigned char *px, int width, int height, int stride) const;
+
+    static std::shared_ptr<CMSTransform> create(cmsHTRANSFORM handle, std::unique_ptr<CMSLut const> lut = {})
     {
-        return handle ? std::make_shared<CMSTransform>(handle) : nullptr;
+        return handle ? std::make_shared<CMSTransform>(handle, std::move(lut)) : nullptr;
     }
 
 private:
     cmsHTRANSFORM _handle;
+    std::unique_ptr<CMSLut const> _lut; ///< Same transform sampled on a grid, for 8-bit RGB
 };
 
 class CMSSystem
@@ -80,9 +93,12 @@ public:
     std::vector<Glib::ustring> get_softproof_profile_names() const;
     std::string get_path_for_profile(Glib::ustring const &name) const;
     std::shared_ptr<CMSTransform const> const &get_cms_transform();
+    std::shared_ptr<CMSTransform const> get_image_transform(cmsHPROFILE profile, int intent);
     static cmsHPROFILE get_document_profile(SPDocument *document, unsigned *intent, char const *name);
 
     static void do_transform(cmsHTRANSFORM transform, unsigned char *inBuf, unsigned char *outBuf, unsigned size);
+    static void transform_image(CMSTransform const &transform, unsigned char *px, int width, int height, int stride,
+                                int numthreads);
 
 private:
     CMSSystem();
@@ -110,6 +126,9 @@ private:
     // Shared immutably with all canvases.
     std::shared_ptr<CMSTransform const> current_transform;
 
+    // Transforms from the profiles of images to sRGB, by profile ID and intent.
+    boost::compute::detail::lru_cache<std::string, std::shared_ptr<CMSTransform const>> image_transforms{16};
+
     // So we can delete them later.
     cmsHPROFILE current_monitor_profile = nullptr;
     cmsHPROFILE current_proof_profile   = nullptr;
@@ -13,6 +13,7 @@
 #include "display/drawing-context.h"
 #include "display/drawing-surface.h"
 #include "display/cairo-utils.h"
+#include "libnrtype/font-glyph.h"
 
 namespace Inkscape {
 
@@ -121,6 +122,34 @@ void DrawingContext::path(Geom::PathVector const &pv) {
     feed_pathvector_to_cairo(_ct, pv);
 }
 
+void DrawingContext::path(GlyphOutline const &outline) {
+    // Fed straight from the packed outline, without building a path vector.
+    struct CairoSink
+    {
+        cairo_t *ct;
+        Geom::Point current;
+
+        void moveTo(Geom::Point const &p) { cairo_move_to(ct, p[Geom::X], p[Geom::Y]); current = p; }
+        void lineTo(Geom::Point const &p) { cairo_line_to(ct, p[Geom::X], p[Geom::Y]); current = p; }
+        void quadTo(Geom::Point const &c, Geom::Point const &p)
+        {
+            // degree-elevate to cubic Bezier, since Cairo doesn't do quadratic Beziers
+            Geom::Point const b1 = current + (2./3) * (c - current);
+            Geom::Point const b2 = b1 + (1./3) * (p - current);
+            curveTo(b1, b2, p);
+        }
+        void curveTo(Geom::Point const &c1, Geom::Point const &c2, Geom::Point const &p)
+        {
+            cairo_curve_to(ct, c1[Geom::X], c1[Geom::Y], c2[Geom::X], c2[Geom::Y], p[Geom::X], p[Geom::Y]);
+            current = p;
+        }
+        void closePath() { cairo_close_path(ct); }
+    };
+
+    auto sink = CairoSink{_ct};
+    outline.feed(sink);
+}
+
 void DrawingContext::paint(double alpha) {
     if (alpha == 1.0) cairo_paint(_ct);
     else cairo_paint_with_alpha(_ct, alpha);
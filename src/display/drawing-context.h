@@ -20,6 +20,8 @@
 
 typedef unsigned int guint32;
 
+class GlyphOutline;
+
 namespace Inkscape {
 
 class DrawingSurface;
@@ -88,6 +90,7 @@ public:
     void newPath() { cairo_new_path(_ct); }
     void newSubpath() { cairo_new_sub_path(_ct); }
     void path(Geom::PathVector const &pv);
+    void path(GlyphOutline const &outline);
 
     void paint(double alpha = 1.0);
     void fill() { cairo_fill(_ct); }
@@ -30,6 +30,7 @@ namespace Inkscape {
 DrawingGlyphs::DrawingGlyphs(Drawing &drawing)
     : DrawingItem(drawing)
     , _glyph(0)
+    , outlines_loaded(false)
 {
 }
 
@@ -41,19 +42,19 @@ void DrawingGlyphs::setGlyph(std::shared_ptr<FontInstance> font, int glyph, Geom
         assert(!_drawing.snapshotted());
         setTransform(trans);
 
-        _font_data = font->share_data();
+        _font = font;
         _glyph = glyph;
 
         design_units = 1.0;
-        pathvec = nullptr;
-        pathvec_ref  = nullptr;
+        outlines_loaded = false;
+        glyph_outline = nullptr;
+        ref_outline   = nullptr;
         pixbuf = nullptr;
 
-        // Load pathvectors and pixbufs in advance, as must be done on main thread.
+        // Load pixbufs in advance, as must be done on main thread. Outlines are loaded when the
+        // glyph is first updated.
         if (font) {
             design_units = font->GetDesignUnits();
-            pathvec      = font->PathVector(_glyph);
-            pathvec_ref  = font->PathVector(42);
 
             if (font->FontHasSVG()) {
                 pixbuf = font->PixBuf(_glyph);
@@ -64,6 +65,19 @@ void DrawingGlyphs::setGlyph(std::shared_ptr<FontInstance> font, int glyph, Geom
     });
 }
 
+void DrawingGlyphs::_loadOutlines()
+{
+    if (outlines_loaded) {
+        return;
+    }
+    outlines_loaded = true;
+
+    if (_font) {
+        glyph_outline = _font->Outline(_glyph);
+        ref_outline   = _font->Outline(42);
+    }
+}
+
 void DrawingGlyphs::setStyle(SPStyle const *, SPStyle const *)
 {
     std::cerr << "DrawingGlyphs: Use parent style" << std::endl;
@@ -76,7 +90,8 @@ unsigned DrawingGlyphs::_updateItem(Geom::IntRect const &/*area*/, UpdateContext
         throw InvalidItemException();
     }
 
-    if (!pathvec) {
+    _loadOutlines();
+    if (!glyph_outline) {
         return STATE_ALL;
     }
 
@@ -105,8 +120,8 @@ unsigned DrawingGlyphs::_updateItem(Geom::IntRect const &/*area*/, UpdateContext
     above and below the max/min y positions of the letters to place the text decorations.*/
 
     Geom::Rect b;
-    if (pathvec) {
-        Geom::OptRect tiltb = Geom::bounds_exact(*pathvec);
+    if (glyph_outline) {
+        Geom::OptRect tiltb = glyph_outline->bounds();
         if (tiltb) {
             Geom::Rect bigbox(Geom::Point(tiltb->left(), -_dsc * scale_bigbox * 1.1), Geom::Point(tiltb->right(), _asc * scale_bigbox * 1.1));
             b = bigbox * ctx.ctm;
@@ -119,20 +134,20 @@ unsigned DrawingGlyphs::_updateItem(Geom::IntRect const &/*area*/, UpdateContext
 
     /*
       The pick box matches the characters as best as it can, leaving no extra space above or below
-      for decorations.  The pathvector may include spaces, and spaces have no drawable glyph.
-      Catch those and do not pass them to bounds_exact_transformed(), which crashes Inkscape if it
-      sees a nondrawable glyph. Instead mock up a pickbox for them using font characteristics.
+      for decorations.  The outline may include spaces, and spaces have no drawable glyph.
+      Catch those, as they have no bounds, and instead mock up a pickbox for them using font
+      characteristics.
       There may also be some other similar white space characters in some other unforeseen context
       which should be handled by this code as well..
     */
 
     Geom::OptRect pb;
-    if (pathvec) {
-        if (!pathvec->empty()) {
-            pb = bounds_exact_transformed(*pathvec, ctx.ctm);
+    if (glyph_outline) {
+        if (!glyph_outline->empty()) {
+            pb = glyph_outline->bounds(ctx.ctm);
         }
-        if (pathvec_ref && !pathvec_ref->empty()) {
-            pb.unionWith(bounds_exact_transformed(*pathvec_ref, ctx.ctm));
+        if (ref_outline && !ref_outline->empty()) {
+            pb.unionWith(ref_outline->bounds(ctx.ctm));
             pb.expandTo(Geom::Point(pb->right() + (_width * ctx.ctm.descrim()), pb->bottom()));
         }
     }
@@ -200,7 +215,7 @@ DrawingItem *DrawingGlyphs::_pickItem(Geom::Point const &p, double /*delta*/, un
                      ggroup->_nrstyle.data.stroke.type == NRStyleData::PaintType::NONE;
     bool outline = flags & PICK_OUTLINE;
 
-    if (pathvec && _bbox && (outline || !invisible)) {
+    if (glyph_outline && _bbox && (outline || !invisible)) {
         // With text we take a simple approach: pick if the point is in a character bbox
         Geom::Rect expanded(_pick_bbox);
         // FIXME, why expand by delta?  When is the next line needed?
@@ -484,8 +499,8 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::I
             // skip glyphs with singular transforms
             if (g->_ctm.isSingular()) continue;
             dc.transform(g->_ctm);
-            if (g->pathvec){
-                dc.path(*g->pathvec);
+            if (g->glyph_outline){
+                dc.path(*g->glyph_outline);
                 dc.fill();
             }
         }
@@ -613,9 +628,9 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::I
             Inkscape::DrawingContext::Save save(dc);
             if (g->_ctm.isSingular()) continue;
             dc.transform(g->_ctm);
-            if (g->pathvec) {
+            if (g->glyph_outline) {
                 if (g->pixbuf) {
-                    // Geom::OptRect box = bounds_exact(*g->pathvec);
+                    // Geom::OptRect box = g->glyph_outline->bounds();
                     // if (box) {
                     //     Inkscape::DrawingContext::Save save(dc);
                     //     dc.newPath();
@@ -635,7 +650,7 @@ unsigned DrawingText::_renderItem(DrawingContext &dc, RenderContext &rc, Geom::I
                         dc.paint(1);
                     }
                 } else {
-                    dc.path(*g->pathvec);
+                    dc.path(*g->glyph_outline);
                 }
             }
         }
@@ -736,8 +751,8 @@ void DrawingText::_clipItem(DrawingContext &dc, RenderContext &rc, Geom::IntRect
 
         Inkscape::DrawingContext::Save save(dc);
         dc.transform(g->_ctm);
-        if (g->pathvec){
-            dc.path(*g->pathvec);
+        if (g->glyph_outline){
+            dc.path(*g->glyph_outline);
         }
     }
     dc.fill();
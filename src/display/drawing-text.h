@@ -19,6 +19,7 @@
 
 class SPStyle;
 class FontInstance;
+class GlyphOutline;
 
 namespace Inkscape {
 
@@ -41,7 +42,10 @@ protected:
     unsigned _updateItem(Geom::IntRect const &area, UpdateContext const &ctx, unsigned flags, unsigned reset) override;
     DrawingItem *_pickItem(Geom::Point const &p, double delta, unsigned flags) override;
 
-    std::shared_ptr<void const> _font_data; // keeps alive pathvec, pathvec_ref, and pixbuf
+    /// Loads the outlines when first needed; FontInstance allows this on any thread.
+    void _loadOutlines();
+
+    std::shared_ptr<FontInstance> _font; // keeps alive glyph_outline, ref_outline, and pixbuf
     int            _glyph;
     float          _width;          // These three are used to set up bounding box
     float          _asc;            //
@@ -50,8 +54,9 @@ protected:
     Geom::IntRect  _pick_bbox;
 
     double design_units;
-    Geom::PathVector const *pathvec; // pathvector of actual glyph
-    Geom::PathVector const *pathvec_ref; // pathvector of reference glyph 42
+    bool outlines_loaded;
+    GlyphOutline const *glyph_outline; // outline of actual glyph
+    GlyphOutline const *ref_outline; // outline of reference glyph 42
     Inkscape::Pixbuf const *pixbuf; // pixbuf, if SVG font
 
     friend class DrawingText;
@@ -14,13 +14,13 @@
 #include "drawing.h"
 
 #include <array>
-#include <thread>
 
 #include "cairo-utils.h"
 #include "drawing-context.h"
 #include "control/canvas-item-drawing.h"
 #include "nr-filter-gaussian.h"
 #include "nr-filter-types.h"
+#include "util/threading.h"
 
 namespace Inkscape {
 
@@ -42,12 +42,6 @@ static auto rendermode_to_renderflags(RenderMode mode)
     }
 }
 
-static auto default_numthreads()
-{
-    auto ret = std::thread::hardware_concurrency();
-    return ret == 0 ? 4 : ret; // Sensible fallback if not reported.
-}
-
 Drawing::Drawing(Inkscape::CanvasItemDrawing *canvas_item_drawing)
     : _canvas_item_drawing(canvas_item_drawing)
     , _grayscale_matrix(std::vector<double>(grayscale_matrix.begin(), grayscale_matrix.end()))
@@ -337,7 +331,7 @@ void Drawing::_loadPrefs()
     }
 
     // Set the global variable governing the number of filter threads, and track it too. (This is ugly, but hopefully transitional.)
-    set_num_filter_threads(prefs->getIntLimited("/options/threading/numthreads", default_numthreads(), 1, 256));
+    set_num_filter_threads(get_num_threads());
 
     // Similarly, enable preference tracking only for the Canvas's drawing.
     if (_canvas_item_drawing) {
@@ -354,7 +348,7 @@ void Drawing::_loadPrefs()
         actions.emplace("/options/cursortolerance/value",        [this] (auto &entry) { setCursorTolerance(entry.getDouble(1.0)); });
         actions.emplace("/options/selection/zeroopacity",        [this] (auto &entry) { setSelectZeroOpacity(entry.getBool(false)); });
         actions.emplace("/options/renderingcache/size",          [this] (auto &entry) { setCacheBudget((1 << 20) * entry.getIntLimited(64, 0, 4096)); });
-        actions.emplace("/options/threading/numthreads",         [this] (auto &entry) { set_num_filter_threads(entry.getIntLimited(default_numthreads(), 1, 256)); });
+        actions.emplace("/options/threading/numthreads",         [this] (auto &entry) { set_num_filter_threads(entry.getIntLimited(default_num_threads(), 1, 256)); });
 
         _pref_tracker = Inkscape::Preferences::PreferencesObserver::create("/options", [actions = std::move(actions)] (auto &entry) {
             auto it = actions.find(entry.getPath());
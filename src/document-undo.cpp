@@ -53,6 +53,7 @@
 #include "document.h"                       // for SPDocument
 #include "event.h"                          // for Event
 #include "inkscape.h"                       // for Application, INKSCAPE
+#include "preferences.h"                    // for Preferences
 #include "composite-undo-stack-observer.h"  // for CompositeUndoStackObserver
 
 #include "debug/event-tracker.h"            // for EventTracker
@@ -62,6 +63,7 @@
 #include "object/sp-lpe-item.h"             // for sp_lpe_item_update_pathef...
 #include "object/sp-root.h"                 // for SPRoot
 #include "xml/event-fns.h"                  // for sp_repr_begin_transaction
+#include "xml/packed-log.h"                 // for PackedLog, SpillFile
 
 namespace Inkscape::XML {
 class Event;
@@ -176,8 +178,8 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
 	}
 
 	if (key && !doc->actionkey.empty() && (doc->actionkey == key) && !doc->undo.empty()) {
-                (doc->undo.back())->event =
-                    sp_repr_coalesce_log ((doc->undo.back())->event, log);
+                auto undo_stack_top = DocumentUndo::undo_stack_top(*doc);
+                undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, log);
 	} else {
         Inkscape::Event *event = new Inkscape::Event(log, event_description, icon_name);
         doc->undo.push_back(event);
@@ -185,6 +187,8 @@ void Inkscape::DocumentUndo::maybeDone(SPDocument *doc,
 		doc->undoStackObservers.notifyUndoCommitEvent(event);
 	}
 
+    limit_undo_memory(*doc);
+
     if ( key ) {
         doc->actionkey = key;
     } else {
@@ -218,7 +222,7 @@ void Inkscape::DocumentUndo::finish_incomplete_transaction(SPDocument &doc) {
         g_warning ("Incomplete undo transaction (added to next undo):");
         doc.partial = sp_repr_coalesce_log(doc.partial, log);
         if (!doc.undo.empty()) {
-            Inkscape::Event* undo_stack_top = doc.undo.back();
+            Inkscape::Event* undo_stack_top = DocumentUndo::undo_stack_top(doc);
             undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, doc.partial);
         } else {
             sp_repr_free_log(doc.partial);
@@ -241,7 +245,7 @@ void Inkscape::DocumentUndo::perform_document_update(SPDocument &doc) {
 
         //Coalesce the update changes with the last action performed by user
         if (!doc.undo.empty()) {
-            Inkscape::Event* undo_stack_top = doc.undo.back();
+            Inkscape::Event* undo_stack_top = DocumentUndo::undo_stack_top(doc);
             undo_stack_top->event = sp_repr_coalesce_log(undo_stack_top->event, update_log);
         } else {
             sp_repr_free_log(update_log);
@@ -249,6 +253,66 @@ void Inkscape::DocumentUndo::perform_document_update(SPDocument &doc) {
     }
 }
 
+/**
+ * The last undo step, with its values unpacked so that it can be undone or added to.
+ */
+Inkscape::Event *Inkscape::DocumentUndo::undo_stack_top(SPDocument &doc)
+{
+    auto top = doc.undo.back();
+    if (top->packed) {
+        top->packed->unpack(top->event);
+        top->packed.reset();
+    }
+    top->size = 0;
+    return top;
+}
+
+/**
+ * Pack away the values of old undo steps while the undo history takes more memory than the
+ * preferences allow, oldest first. The latest steps are left alone, so that undoing them takes
+ * no longer than before.
+ */
+void Inkscape::DocumentUndo::limit_undo_memory(SPDocument &doc)
+{
+    auto prefs = Inkscape::Preferences::get();
+    std::size_t const limit = std::size_t(prefs->getIntLimited("/options/undo/memory-limit", 256, 0, 1 << 20)) << 20;
+    std::size_t const unpacked_steps = prefs->getIntLimited("/options/undo/unpacked-steps", 20, 1, 10000);
+    if (!limit || doc.undo.size() <= unpacked_steps) {
+        return;
+    }
+
+    // The last step may still be added to, so its size is measured again each time.
+    std::size_t total = 0;
+    for (auto event : doc.undo) {
+        if (event->packed) {
+            total += event->packed->size();
+            continue;
+        }
+        if (!event->size || event == doc.undo.back()) {
+            event->size = Inkscape::XML::PackedLog::valueSize(event->event);
+        }
+        total += event->size;
+    }
+
+    auto const packable = doc.undo.end() - unpacked_steps;
+    for (auto it = doc.undo.begin(); it != packable && total > limit; ++it) {
+        auto event = *it;
+        if (event->packed) {
+            continue;
+        }
+        Inkscape::XML::SpillFile *spill = nullptr;
+        if (prefs->getBool("/options/undo/spill-to-disk", false)) {
+            if (!doc.undo_spill) {
+                doc.undo_spill = std::make_unique<Inkscape::XML::SpillFile>();
+            }
+            spill = doc.undo_spill.get();
+        }
+        total -= event->size;
+        event->packed = std::make_unique<Inkscape::XML::PackedLog>(event->event, spill);
+        total += event->packed->size();
+    }
+}
+
 gboolean Inkscape::DocumentUndo::undo(SPDocument *doc)
 {
     using Inkscape::Debug::EventTracker;
@@ -267,7 +331,7 @@ gboolean Inkscape::DocumentUndo::undo(SPDocument *doc)
 
     finish_incomplete_transaction(*doc);
     if (! doc->undo.empty()) {
-        Inkscape::Event *log = doc->undo.back();
+        Inkscape::Event *log = undo_stack_top(*doc);
         doc->undo.pop_back();
         sp_repr_undo_log (log->event);
         perform_document_update(*doc);
@@ -47,6 +47,10 @@ private:
 
     static void perform_document_update(SPDocument &document);
 
+    static Inkscape::Event *undo_stack_top(SPDocument &document);
+
+    static void limit_undo_memory(SPDocument &document);
+
 public:
     static void resetKey(SPDocument *document);
 
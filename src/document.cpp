@@ -38,10 +38,16 @@
 
 #include "document.h"
 
+#include <algorithm>
 #include <vector>
+#include <sstream>
 #include <string>
 #include <cstring>
+#include <future>
+#include <utility>
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <boost/range/adaptor/reversed.hpp>
 #include <glibmm/main.h>
 #include <glibmm/miscutils.h>
@@ -82,11 +88,15 @@
 #include "object/sp-page.h"
 #include "object/sp-root.h"
 #include "object/sp-symbol.h"
+#include "object/sp-text.h"
 #include "ui/widget/canvas.h"
 #include "ui/widget/desktop-widget.h"
+#include "util/threading.h"
 #include "util/units.h"
 #include "xml/croco-node-iface.h"
+#include "xml/packed-log.h"
 #include "xml/rebase-hrefs.h"
+#include "xml/serialization-cache.h"
 #include "xml/simple-document.h"
 
 using Inkscape::DocumentUndo;
@@ -193,6 +203,8 @@ SPDocument::~SPDocument() {
         root = nullptr;
     }
 
+    // Stops observing rdoc, so must go before it.
+    _serialization_cache.reset();
     if (rdoc) Inkscape::GC::release(rdoc);
 
     /* Free resources */
@@ -240,6 +252,21 @@ Inkscape::XML::Node *SPDocument::getReprNamedView()
     return sp_repr_lookup_name (rroot, "sodipodi:namedview");
 }
 
+/**
+ * Get the serialization cache of this document, creating it on first use so that documents
+ * which are never saved don't pay for observing their XML tree.
+ */
+Inkscape::XML::SerializationCache *SPDocument::getSerializationCache()
+{
+    if (!rdoc) {
+        return nullptr;
+    }
+    if (!_serialization_cache) {
+        _serialization_cache = std::make_unique<Inkscape::XML::SerializationCache>(*rdoc);
+    }
+    return _serialization_cache.get();
+}
+
 /**
  * Get the namedview for this document, creates it if it's not found.
  *
@@ -332,6 +359,16 @@ void SPDocument::prunePages(const std::string &page_nums, bool invert)
     }    
 }
 
+void SPDocument::writeInBulk(std::unordered_set<SPObject const *> writers, std::function<void()> const &write)
+{
+    g_assert(_bulk_writers.empty());
+    _bulk_writers = std::move(writers);
+    rdoc->beginBulkAttributes();
+    write();
+    rdoc->endBulkAttributes();
+    _bulk_writers.clear();
+}
+
 void SPDocument::queueForOrphanCollection(SPObject *object) {
     g_return_if_fail(object != nullptr);
     g_return_if_fail(object->document == this);
@@ -1223,64 +1260,123 @@ SPObject *SPDocument::getObjectByHref(char const *href) const
     return getObjectById(id);
 }
 
-static void _getObjectsByClassRecursive(Glib::ustring const &klass, SPObject *parent, std::vector<SPObject*> &objects)
+/// Call \a f with the quark of each class name in a class attribute value.
+template <typename F>
+static void _forEachClass(char const *classes, F &&f)
 {
-    if (!parent) return;
+    if (!classes) return;
 
-    if (auto const temp = parent->getAttribute("class")) {
-        std::istringstream classes(temp);
-        Glib::ustring token;
-        while (classes >> token) {
-            // we can have multiple class
-            if (classes.str() == " ") {
-                token = "";
-                continue;
-            }
-            if (token == klass) {
-                objects.emplace_back(parent);
-                break;
+    std::istringstream tokens(classes);
+    std::string token;
+    while (tokens >> token) {
+        f(g_quark_from_string(token.c_str()));
+    }
+}
+
+/**
+ * Index \a object under the class names in \a classes, its current class attribute, instead of
+ * the ones it was indexed under so far. Null removes the object from the class index.
+ *
+ * The old names are remembered rather than taken from the attribute's previous value, so that
+ * they are removed exactly even if the attribute changed while the object wasn't observing it.
+ */
+void SPDocument::bindObjectToClasses(SPObject *object, char const *classes)
+{
+    if (auto it = objectclasses.find(object); it != objectclasses.end()) {
+        for (auto klass : it->second) {
+            if (auto jt = classdef.find(klass); jt != classdef.end()) {
+                jt->second.erase(object);
+                if (jt->second.empty()) {
+                    classdef.erase(jt);
+                }
             }
         }
+        objectclasses.erase(it);
     }
 
-    // Check children
-    for (auto &child : parent->children) {
-        _getObjectsByClassRecursive(klass, &child, objects);
+    std::vector<GQuark> indexed;
+    _forEachClass(classes, [&] (GQuark klass) {
+        classdef[klass].insert(object);
+        indexed.push_back(klass);
+    });
+    if (!indexed.empty()) {
+        objectclasses.emplace(object, std::move(indexed));
     }
 }
 
-std::vector<SPObject*> SPDocument::getObjectsByClass(Glib::ustring const &klass) const
+/**
+ * Update the element index after \a object changed its element name. Either name can be 0.
+ */
+void SPDocument::bindObjectToElement(SPObject *object, GQuark old_name, GQuark new_name)
 {
-    if (klass.empty()) return {};
-    std::vector<SPObject*> objects;
-    _getObjectsByClassRecursive(klass, root, objects);
-    return objects;
+    if (old_name) {
+        if (auto it = elementdef.find(old_name); it != elementdef.end()) {
+            it->second.erase(object);
+            if (it->second.empty()) {
+                elementdef.erase(it);
+            }
+        }
+    }
+    if (new_name) {
+        elementdef[new_name].insert(object);
+    }
 }
 
-static void _getObjectsByElementRecursive(Glib::ustring const &element,
-                                          SPObject *parent,
-                                          std::vector<SPObject*> &objects,
-                                          bool custom)
+/// Whether \a first comes before \a second in a depth-first walk of the object tree.
+static bool _precedesInDocument(SPObject const *first, SPObject const *second)
 {
-    if (!parent) return;
+    if (first == second) return false;
+    auto const ancestor = first->nearestCommonAncestor(second);
+    if (!ancestor || ancestor == second) return false;
+    if (ancestor == first) return true;
+    return sp_object_compare_position(first, second) < 0;
+}
 
-    Glib::ustring prefixed = custom ? "inkscape:" : "svg:";
-    prefixed += element;
-    if (parent->getRepr()->name() == prefixed) {
-        objects.emplace_back(parent);
-    }
+/// The objects of an index entry in document order.
+static std::vector<SPObject *> _sortedObjects(std::unordered_set<SPObject *> const &set)
+{
+    auto objects = std::vector<SPObject *>(set.begin(), set.end());
+    std::sort(objects.begin(), objects.end(), _precedesInDocument);
+    return objects;
+}
 
-    // Check children
-    for (auto &child : parent->children) {
-        _getObjectsByElementRecursive(element, &child, objects, custom);
-    }
+std::vector<SPObject*> SPDocument::getObjectsByClass(Glib::ustring const &klass) const
+{
+    if (klass.empty()) return {};
+    auto const quark = g_quark_try_string(klass.c_str());
+    if (!quark) return {};
+    auto it = classdef.find(quark);
+    return it == classdef.end() ? std::vector<SPObject *>{} : _sortedObjects(it->second);
 }
 
 std::vector<SPObject*> SPDocument::getObjectsByElement(Glib::ustring const &element, bool custom) const
 {
     if (element.empty()) return {};
-    std::vector<SPObject*> objects;
-    _getObjectsByElementRecursive(element, root, objects, custom);
+    Glib::ustring prefixed = custom ? "inkscape:" : "svg:";
+    prefixed += element;
+    auto const quark = g_quark_try_string(prefixed.c_str());
+    if (!quark) return {};
+    auto it = elementdef.find(quark);
+    return it == elementdef.end() ? std::vector<SPObject *>{} : _sortedObjects(it->second);
+}
+
+/**
+ * The objects whose element name without its namespace prefix is \a name, in document order,
+ * which are the objects a CSS type selector matches.
+ */
+std::vector<SPObject*> SPDocument::getObjectsByLocalName(char const *name) const
+{
+    if (!name || !*name) return {};
+
+    std::vector<SPObject *> objects;
+    for (auto const &[quark, set] : elementdef) {
+        auto const qname = g_quark_to_string(quark);
+        auto const colon = std::strrchr(qname, ':');
+        if (std::strcmp(colon ? colon + 1 : qname, name) == 0) {
+            objects.insert(objects.end(), set.begin(), set.end());
+        }
+    }
+    std::sort(objects.begin(), objects.end(), _precedesInDocument);
     return objects;
 }
 
@@ -1288,7 +1384,9 @@ static void _getObjectsBySelectorRecursive(SPObject *parent,
                                            CRSelEng *sel_eng, CRSimpleSel *simple_sel,
                                            std::vector<SPObject*> &objects)
 {
-    if (parent) {
+    // Clones share the repr of their original, but are left out like from the id and class
+    // lookups in _getSelectorCandidates().
+    if (parent && !parent->cloned) {
         gboolean result = false;
         cr_sel_eng_matches_node(sel_eng, simple_sel, parent->getRepr(), &result);
         if (result) {
@@ -1302,6 +1400,47 @@ static void _getObjectsBySelectorRecursive(SPObject *parent,
     }
 }
 
+/**
+ * Find the objects which may match a selector, from the id, class or element name of its subject
+ * (the last compound selector). Returns false if the selector has none of them, so that all
+ * objects must be tested.
+ */
+static bool _getSelectorCandidates(SPDocument const *document, CRSimpleSel const *simple_sel,
+                                   std::vector<SPObject *> &candidates)
+{
+    auto subject = simple_sel;
+    while (subject->next) {
+        subject = subject->next;
+    }
+
+    for (auto add_sel = subject->add_sel; add_sel; add_sel = add_sel->next) {
+        if (add_sel->type == ID_ADD_SELECTOR && add_sel->content.id_name && add_sel->content.id_name->stryng) {
+            auto const object = document->getObjectById(add_sel->content.id_name->stryng->str);
+            // Objects of a parent or reference document are not matched by the full walk either.
+            if (object && object->document == document) {
+                candidates.push_back(object);
+            }
+            return true;
+        }
+    }
+
+    for (auto add_sel = subject->add_sel; add_sel; add_sel = add_sel->next) {
+        if (add_sel->type == CLASS_ADD_SELECTOR && add_sel->content.class_name &&
+            add_sel->content.class_name->stryng) {
+            candidates = document->getObjectsByClass(add_sel->content.class_name->stryng->str);
+            return true;
+        }
+    }
+
+    if ((subject->type_mask & TYPE_SELECTOR) && subject->name && subject->name->stryng &&
+        subject->name->stryng->str) {
+        candidates = document->getObjectsByLocalName(subject->name->stryng->str);
+        return true;
+    }
+
+    return false;
+}
+
 std::vector<SPObject*> SPDocument::getObjectsBySelector(Glib::ustring const &selector) const
 {
     if (selector.empty()) return {};
@@ -1314,8 +1453,21 @@ std::vector<SPObject*> SPDocument::getObjectsBySelector(Glib::ustring const &sel
     auto cr_selector = cr_selector_parse_from_buf(reinterpret_cast<guchar const*>(selector.c_str()), CR_UTF_8);
 
     std::vector<SPObject*> objects;
+    std::vector<SPObject*> candidates;
     for (auto cur = cr_selector; cur; cur = cur->next) {
-        if (cur->simple_sel) {
+        if (!cur->simple_sel) {
+            continue;
+        }
+        candidates.clear();
+        if (_getSelectorCandidates(this, cur->simple_sel, candidates)) {
+            for (auto candidate : candidates) {
+                gboolean result = false;
+                cr_sel_eng_matches_node(sel_eng, cur->simple_sel, candidate->getRepr(), &result);
+                if (result) {
+                    objects.push_back(candidate);
+                }
+            }
+        } else {
             _getObjectsBySelectorRecursive(root, sel_eng, cur->simple_sel, objects);
         }
     }
@@ -1347,9 +1499,17 @@ void SPDocument::bindObjectToRepr(Inkscape::XML::Node *repr, SPObject *object)
     if (object) {
         auto ret = reprdef.emplace(repr, object);
         g_assert(ret.second);
+        if (repr->type() == Inkscape::XML::NodeType::ELEMENT_NODE) {
+            bindObjectToElement(object, 0, repr->code());
+            bindObjectToClasses(object, repr->attribute("class"));
+        }
     } else {
         auto it = reprdef.find(repr);
         g_assert(it != reprdef.end());
+        if (repr->type() == Inkscape::XML::NodeType::ELEMENT_NODE) {
+            bindObjectToElement(it->second, repr->code(), 0);
+            bindObjectToClasses(it->second, nullptr);
+        }
         reprdef.erase(it);
     }
     clearNodeCache();
@@ -1456,7 +1616,15 @@ SPDocument::_updateDocument(int update_flags)
 
             DocumentUndo::ScopedInsensitive _no_undo(this);
 
+            // Texts are only laid out on other threads if there are several to use.
+            _text_layout_threads = Inkscape::get_num_threads();
+            if (_text_layout_threads == 1) {
+                _text_layout_threads = 0;
+            }
+
             this->root->updateDisplay((SPCtx *)&ctx, update_flags);
+
+            _calculateQueuedTextLayouts(std::exchange(_text_layout_threads, 0));
         }
         this->_emitModified();
     }
@@ -1464,6 +1632,59 @@ SPDocument::_updateDocument(int update_flags)
     return !(this->root->uflags || this->root->mflags);
 }
 
+int SPDocument::queueTextLayout(SPText *text)
+{
+    if (_text_layout_threads == 0) {
+        return -1;
+    }
+    _queued_text_layouts.push_back(text);
+    return _queued_text_layouts.size() - 1;
+}
+
+void SPDocument::dequeueTextLayout(int index)
+{
+    _queued_text_layouts[index] = nullptr;
+}
+
+/**
+ * Calculate the flow of the texts queued while updating the document, then finish and show
+ * them in the order they were updated in.
+ *
+ * The input of each layout was built from its objects on this thread, which are not touched
+ * until all flows are calculated. Calculating a flow only reads that input and the fonts;
+ * the font factory serialises the use of Pango, so shaped paragraphs found in the shaping
+ * cache and line breaking run concurrently.
+ */
+void SPDocument::_calculateQueuedTextLayouts(int numthreads)
+{
+    auto texts = std::move(_queued_text_layouts);
+    _queued_text_layouts.clear();
+    std::erase(texts, nullptr);
+    if (texts.empty()) {
+        return;
+    }
+
+    if (texts.size() == 1) {
+        texts.front()->layout.calculateFlow();
+    } else {
+        auto pool = boost::asio::thread_pool(std::min<int>(numthreads, texts.size()));
+        std::vector<std::future<void>> flows;
+        flows.reserve(texts.size());
+        for (auto text : texts) {
+            auto task = std::make_shared<std::packaged_task<void()>>([text] { text->layout.calculateFlow(); });
+            flows.push_back(task->get_future());
+            boost::asio::post(pool, [task] { (*task)(); });
+        }
+        for (auto &flow : flows) {
+            flow.get(); // rethrows exceptions of the worker
+        }
+    }
+
+    for (auto text : texts) {
+        text->finishQueuedLayout();
+    }
+}
+
 /**
  * Repeatedly works on getting the document updated, since sometimes
  * it takes more than one pass to get the document updated.  But it
@@ -20,10 +20,13 @@
 
 #include <cstddef>                             // for size_t
 #include <deque>                               // for deque
+#include <functional>                          // for function
 #include <map>                                 // for map
 #include <memory>                              // for unique_ptr, default_de...
 #include <queue>                               // for queue
 #include <string>                              // for string
+#include <unordered_map>                       // for unordered_map
+#include <unordered_set>                       // for unordered_set
 #include <vector>                              // for vector
 
 #include <boost/ptr_container/ptr_list.hpp>    // for ptr_list
@@ -79,6 +82,7 @@ class SPItemCtx;
 class SPNamedView;
 class SPObject;
 class SPRoot;
+class SPText;
 
 namespace Inkscape {
     class DocumentUndo;
@@ -92,6 +96,8 @@ namespace Inkscape {
         struct Document;
         class Event;
         class Node;
+        class SerializationCache;
+        class SpillFile;
     } // namespace XML
     namespace Util {
         class Unit;
@@ -161,6 +167,17 @@ public:
     bool _updateDocument(int flags); // Used by stand-alone sp_document_idle_handler
     int ensureUpToDate();
 
+    /**
+     * Called by texts whose layout changed while the document is being updated. If an index
+     * is returned, the flow of the text is calculated once all objects are updated, on worker
+     * threads together with those of other texts, and SPText::finishQueuedLayout() is called;
+     * otherwise, i.e. for -1, the text should lay itself out. A queued text must be queued
+     * only once, and is taken out of the queue again by passing its index to
+     * dequeueTextLayout().
+     */
+    int queueTextLayout(SPText *text);
+    void dequeueTextLayout(int index);
+
     bool addResource(char const *key, SPObject *object);
     bool removeResource(char const *key, SPObject *object);
     std::vector<SPObject *> const getResourceList(char const *key);
@@ -188,6 +205,8 @@ private:
     // Find items by geometry --------------------
     std::deque<SPItem*> const &get_flat_item_list(unsigned int dkey, bool into_groups, bool active_only) const;
 
+    void _calculateQueuedTextLayouts(int numthreads);
+
 public:
     void clearNodeCache() { _node_cache.clear(); }
     void importDefs(SPDocument *source);
@@ -216,6 +235,9 @@ public:
     Inkscape::XML::Document *getReprDoc() { return rdoc; }
     Inkscape::XML::Document const *getReprDoc() const { return rdoc; }
 
+    /** Serialized form of unchanged subtrees, reused by subsequent saves. */
+    Inkscape::XML::SerializationCache *getSerializationCache();
+
 
     std::vector<Glib::ustring> getLanguages() const;
 
@@ -289,9 +311,12 @@ public:
 
     void bindObjectToRepr(Inkscape::XML::Node *repr, SPObject *object);
     SPObject *getObjectByRepr(Inkscape::XML::Node *repr) const;
+    void bindObjectToClasses(SPObject *object, char const *classes);
+    void bindObjectToElement(SPObject *object, GQuark old_name, GQuark new_name);
 
     std::vector<SPObject *> getObjectsByClass(Glib::ustring const &klass) const;
     std::vector<SPObject *> getObjectsByElement(Glib::ustring const &element, bool custom = false) const;
+    std::vector<SPObject *> getObjectsByLocalName(char const *name) const;
     std::vector<SPObject *> getObjectsBySelector(Glib::ustring const &selector) const;
 
     /**
@@ -361,6 +386,17 @@ public:
     void reset_key(void *dummy) { actionkey.clear(); }
     bool isSensitive() const { return sensitive; }
 
+    // Bulk writes -----------------------------
+    /**
+     * Call \a write with the attribute changes of the XML document held back, then log them as
+     * a single undo event and tell each changed node's observers about all of its changes at
+     * once. \a writers are the objects \a write changes the reprs of, and must change nothing
+     * but their own attributes. They don't read back what they wrote.
+     */
+    void writeInBulk(std::unordered_set<SPObject const *> writers, std::function<void()> const &write);
+    /// Whether \a object is writing its repr in writeInBulk(), so is up to date with it already.
+    bool isWritingInBulk(SPObject const *object) const { return _bulk_writers.contains(object); }
+
     // Garbage collecting ----------------------
     void queueForOrphanCollection(SPObject *object);
     void collectOrphans();
@@ -386,9 +422,16 @@ private:
     sigc::connection modified_connection;
     sigc::connection rerouting_connection;
 
+    std::unordered_set<SPObject const *> _bulk_writers; ///< Objects writing in writeInBulk()
+
+    // Text layout ----------------------------
+    std::vector<SPText *> _queued_text_layouts; ///< Texts to lay out at the end of the update, or null
+    int _text_layout_threads = 0;               ///< Threads to lay them out on, 0 if not queueing
+
     // Document structure --------------------
     Inkscape::XML::Document *rdoc; ///< Our Inkscape::XML::Document
     Inkscape::XML::Node *rroot; ///< Root element of Inkscape::XML::Document
+    std::unique_ptr<Inkscape::XML::SerializationCache> _serialization_cache;
 
     SPRoot *root;             ///< Our SPRoot
 
@@ -415,6 +458,9 @@ private:
     // Find items ----------------------------
     std::map<std::string, SPObject *> iddef;
     std::map<Inkscape::XML::Node *, SPObject *> reprdef;
+    std::map<GQuark, std::unordered_set<SPObject *>> classdef;   ///< Objects by class name
+    std::unordered_map<SPObject *, std::vector<GQuark>> objectclasses; ///< Class names by indexed object
+    std::map<GQuark, std::unordered_set<SPObject *>> elementdef; ///< Objects by qualified element name
 
     // Find items by geometry --------------------
     mutable std::map<unsigned long, std::deque<SPItem*>> _node_cache; // Used to speed up search.
@@ -433,6 +479,7 @@ private:
     int history_size;
     std::vector<Inkscape::Event *> undo; /* Undo stack of reprs */
     std::vector<Inkscape::Event *> redo; /* Redo stack of reprs */
+    std::unique_ptr<Inkscape::XML::SpillFile> undo_spill; /* Old undo steps moved out of memory */
     /* Undo listener */
     Inkscape::CompositeUndoStackObserver undoStackObservers;
 
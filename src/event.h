@@ -17,9 +17,11 @@
 
 #include <glibmm/ustring.h>
 
+#include <memory>
 #include <utility>
 
 #include "xml/event-fns.h"
+#include "xml/packed-log.h"
 
 namespace Inkscape {
 namespace XML {
@@ -42,6 +44,9 @@ public:
     unsigned int type = 0;
     Glib::ustring description; // The description to use in the Undo dialog.
     Glib::ustring icon_name;   // The icon to use in the Undo dialog.
+
+    std::unique_ptr<XML::PackedLog> packed; // The values of the events, if packed away.
+    std::size_t size = 0;                   // Memory taken by the values, 0 if not known yet.
 };
 
 } // namespace Inkscape
@@ -86,10 +86,77 @@ struct ModuleOutputCmp {
 void DB::take_ownership(std::unique_ptr<Extension> module)
 {
     if (module) {
+        // A module registered later replaces an earlier one, whether that was built or not.
+        _deferred.erase(module->get_id());
         moduledict[module->get_id()] = std::move(module);
     }
 }
 
+/**
+ * @brief Register a module without building it yet.
+ * @param id    The unique ID the module will have.
+ * @param type  What kind of module it is, so that it is built when a list of that kind is needed.
+ * @param build Builds the module and passes it to take_ownership().
+ *
+ * A deferred module replaces a module with the same ID once it is built, as if it had been built
+ * right away.
+ */
+void DB::defer(std::string id, ModuleFuncType type, std::function<void ()> build)
+{
+    _deferred.insert_or_assign(std::move(id), DeferredModule{type, std::move(build)});
+}
+
+/**
+ * @brief Build the deferred module with the given ID, if there is one, and check it.
+ *
+ * The check is what Inkscape::Extension::init() does for the modules it builds. Dependencies on
+ * other extensions are resolved through get(), so they are built on demand in turn.
+ */
+void DB::build_deferred_module(std::string const &id)
+{
+    assert(std::this_thread::get_id() == _thread);
+
+    auto node = _deferred.extract(id);
+    if (node.empty()) {
+        return;
+    }
+    node.mapped().build();
+
+    auto it = moduledict.find(id);
+    if (it == moduledict.end()) {
+        return; // Failed to build, or not compatible with this system.
+    }
+    auto module = it->second.get();
+
+    bool const open_log = !Extension::error_file_is_open();
+    if (open_log) {
+        Extension::error_file_open(true);
+    }
+    if (!module->deactivated() && !module->check()) {
+        module->deactivate();
+    }
+    if (open_log) {
+        Extension::error_file_close();
+    }
+}
+
+/**
+ * @brief Build the deferred modules of the given kind, or all of them.
+ */
+void DB::build_deferred_modules(std::optional<ModuleFuncType> type)
+{
+    std::vector<std::string> ids;
+    for (auto const &[id, deferred] : _deferred) {
+        if (!type || deferred.type == *type) {
+            ids.push_back(id);
+        }
+    }
+    // Building one module may build others which it depends on, hence by ID.
+    for (auto const &id : ids) {
+        build_deferred_module(id);
+    }
+}
+
 /**
 	\return    A reference to the Inkscape::Extension::Extension specified by the input key.
 	\brief     This function looks up a Inkscape::Extension::Extension by using its unique
@@ -98,10 +165,16 @@ void DB::take_ownership(std::unique_ptr<Extension> module)
 
     Retrieves a module by name or nullptr if not found.
 */
-Extension *DB::get(const gchar *key) const
+Extension *DB::get(const gchar *key)
 {
+    assert(std::this_thread::get_id() == _thread); // May build the module, see build_deferred_module().
+
     if (key == nullptr) return nullptr;
 
+    if (!_deferred.empty()) {
+        build_deferred_module(key);
+    }
+
 	auto it = moduledict.find(key);
 	if (it == moduledict.end())
 		return nullptr;
@@ -121,12 +194,16 @@ Extension *DB::get(const gchar *key) const
 	           in the database as a parameter.
 	\param     in_func  The function to execute for every module
 	\param     in_data  A data pointer that is also passed to in_func
+	\param     include_deferred  Whether to build the deferred modules first
 
  	Enumerates the modules currently in the database, calling a given
 	callback for each one.
 */
-void DB::foreach(void (*in_func)(Extension *, gpointer), gpointer in_data)
+void DB::foreach(void (*in_func)(Extension *, gpointer), gpointer in_data, bool include_deferred)
 {
+    if (include_deferred) {
+        build_deferred_modules();
+    }
     for (auto const &item : moduledict) {
         in_func(item.second.get(), in_data);
     }
@@ -227,7 +304,8 @@ DB::effect_internal (Extension * in_plug, gpointer data)
  */
 DB::TemplateList &DB::get_template_list(DB::TemplateList &ou_list)
 {
-    foreach (template_internal, (gpointer)&ou_list);
+    build_deferred_modules(MODULE_TEMPLATE);
+    foreach (template_internal, (gpointer)&ou_list, false);
     ou_list.sort(ModuleGenericCmp());
     return ou_list;
 }
@@ -241,7 +319,8 @@ DB::TemplateList &DB::get_template_list(DB::TemplateList &ou_list)
 DB::InputList &
 DB::get_input_list (DB::InputList &ou_list)
 {
-	foreach(input_internal, (gpointer)&ou_list);
+	build_deferred_modules(MODULE_INPUT);
+	foreach(input_internal, (gpointer)&ou_list, false);
 	ou_list.sort( ModuleInputCmp() );
 	return ou_list;
 }
@@ -255,7 +334,8 @@ DB::get_input_list (DB::InputList &ou_list)
 DB::OutputList &
 DB::get_output_list (DB::OutputList &ou_list)
 {
-	foreach(output_internal, (gpointer)&ou_list);
+	build_deferred_modules(MODULE_OUTPUT);
+	foreach(output_internal, (gpointer)&ou_list, false);
 	ou_list.sort( ModuleOutputCmp() );
 	return ou_list;
 }
@@ -264,6 +344,7 @@ DB::get_output_list (DB::OutputList &ou_list)
 	\brief  Creates a list of all the Effect extensions
 */
 std::vector<Effect*> DB::get_effect_list() {
+    build_deferred_modules(MODULE_FILTER);
     std::vector<Effect*> out;
     for (auto const &item : moduledict) {
         auto ex = item.second.get();
@@ -274,4 +355,22 @@ std::vector<Effect*> DB::get_effect_list() {
     return out;
 }
 
+/**
+	\brief  The IDs of all Effect extensions, without building the deferred ones
+*/
+std::vector<std::string> DB::get_effect_ids() const {
+    std::vector<std::string> out;
+    for (auto const &item : moduledict) {
+        if (dynamic_cast<Effect *>(item.second.get())) {
+            out.push_back(item.first);
+        }
+    }
+    for (auto const &[id, deferred] : _deferred) {
+        if (deferred.type == MODULE_FILTER) {
+            out.push_back(id);
+        }
+    }
+    return out;
+}
+
 } } /* namespace Extension, Inkscape */
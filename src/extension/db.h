@@ -16,8 +16,11 @@
 #ifndef SEEN_MODULES_DB_H
 #define SEEN_MODULES_DB_H
 
+#include <functional>
 #include <string>
 #include <memory>
+#include <optional>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -38,14 +41,32 @@ private:
         indexed by their ids.  It's a hash table for faster lookups */
     std::unordered_map<std::string, std::unique_ptr<Extension>> moduledict;
 
+    /** Modules that are registered but not built yet, also indexed by their ids. They are built
+        on first use: when looked up by id, or when a list of their kind is asked for. */
+    struct DeferredModule
+    {
+        ModuleFuncType type;
+        std::function<void ()> build;
+    };
+    std::unordered_map<std::string, DeferredModule> _deferred;
+
+    void build_deferred_module(std::string const &id);
+    void build_deferred_modules(std::optional<ModuleFuncType> type = {});
+
+    /** Building deferred modules changes the database, which is not locked. The database is
+        therefore only used on the thread that created it, the main thread. */
+    std::thread::id const _thread = std::this_thread::get_id();
+
 public:
     DB() = default;
     DB(DB &&)            = delete; // Database is non-movable, hence also non-copyable.
     DB &operator=(DB &&) = delete;
 
-    Extension *get(const gchar *key) const;
+    Extension *get(const gchar *key);
     void take_ownership(std::unique_ptr<Extension> module);
-    void foreach(void (*in_func)(Extension * in_plug, gpointer in_data), gpointer in_data);
+    void defer(std::string id, ModuleFuncType type, std::function<void ()> build);
+    void foreach(void (*in_func)(Extension * in_plug, gpointer in_data), gpointer in_data,
+                 bool include_deferred = true);
 
 private:
     static void template_internal(Extension *in_plug, gpointer data);
@@ -64,6 +85,7 @@ public:
     OutputList &get_output_list (OutputList &ou_list);
 
     std::vector<Effect*> get_effect_list();
+    std::vector<std::string> get_effect_ids() const;
 }; /* class DB */
 
 extern DB db;
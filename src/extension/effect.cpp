@@ -102,12 +102,19 @@ Effect::Effect(Inkscape::XML::Node *in_repr, ImplementationHolder implementation
     _filter_effect = dynamic_cast<Internal::Filter::Filter *>(imp.get()) != nullptr;
 }
 
-/** Sanitizes the id and returns. If an invalid character is found in the ID, a warning
- *  is printed to stderr. All invalid characters are replaced with an 'X'.
+/** Returns the id of this effect, sanitized with sanitize_id().
  */
 std::string Effect::get_sanitized_id() const
 {
-    std::string id = get_id();
+    return sanitize_id(get_id());
+}
+
+/** Sanitizes an effect id (also of an effect that is not built yet) and returns it. If an
+ *  invalid character is found in the ID, a warning is printed to stderr. All invalid characters
+ *  are replaced with an 'X'.
+ */
+std::string Effect::sanitize_id(std::string id)
+{
     auto allowed = [] (char ch) {
         // Note: std::isalnum() is locale-dependent
         if ('A' <= ch && ch <= 'Z') return true;
@@ -126,7 +133,7 @@ std::string Effect::get_sanitized_id() const
         if (!allowed(ch)) {
             if (!errored) {
                 auto message = std::string{"Invalid extension action ID found: \""} + id + "\".";
-                g_warn_message("Inkscape", __FILE__, __LINE__, "Effect::_sanitizeId()", message.c_str());
+                g_warn_message("Inkscape", __FILE__, __LINE__, "Effect::sanitize_id()", message.c_str());
                 errored = true;
             }
             ch = 'X';
@@ -99,6 +99,7 @@ public:
 
     // get effect's ID sanitized to alphanumeric ASCII charaters
     std::string get_sanitized_id() const;
+    static std::string sanitize_id(std::string id);
 
     // get local effect menu
     std::list<Glib::ustring> get_menu_list() const;
@@ -115,7 +116,6 @@ private:
     std::string _icon_path;
 
     static gchar *   remove_ (gchar * instr);
-    static void _sanitizeId(std::string &id);
 };
 
 } }  /* namespace Inkscape, Extension */
@@ -903,12 +903,13 @@ void Extension::set_param_hidden(char const *name, bool hidden)
     get_param(name)->set_hidden(hidden);
 }
 
-/** \brief A function to open the error log file. */
+/** \brief A function to open the error log file.
+    \param append  Keep what was logged before, for extensions that are checked after startup. */
 void
-Extension::error_file_open ()
+Extension::error_file_open (bool append)
 {
     auto ext_error_file = Inkscape::IO::Resource::log_path(EXTENSION_ERROR_LOG_FILENAME);
-    error_file = Inkscape::IO::fopen_utf8name(ext_error_file.c_str(), "w+");
+    error_file = Inkscape::IO::fopen_utf8name(ext_error_file.c_str(), append ? "a" : "w+");
     if (!error_file) {
         g_warning(_("Could not create extension error log file '%s'"), ext_error_file.c_str());
     }
@@ -920,6 +921,7 @@ Extension::error_file_close ()
 {
     if (error_file) {
         fclose(error_file);
+        error_file = nullptr;
     }
 };
 
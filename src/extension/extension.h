@@ -122,6 +122,9 @@ namespace Implementation {
 class Implementation;
 } // namespace Implementation
 
+/** The kind of module that an element of an extension description makes it, if any. */
+ModuleFuncType get_functional_type(char const *element_name);
+
 /** The object that is the basis for the Extension system.  This object
     contains all of the information that all Extension have.  The
     individual items are detailed within. This is the interface that
@@ -276,8 +279,9 @@ public:
     void set_param_hidden(char const *name, bool hidden);
 
     /* Error file handling */
-    static void      error_file_open ();
+    static void      error_file_open (bool append = false);
     static void      error_file_close();
+    static bool      error_file_is_open() { return error_file != nullptr; }
     static void      error_file_write(Glib::ustring const &text);
 
     Gtk::Widget *autogui (SPDocument *doc, Inkscape::XML::Node *node, sigc::signal<void ()> *changeSignal = nullptr);
@@ -36,6 +36,7 @@
 #include "internal/template-video.h"
 #include "internal/wmf-inout.h"
 #include "internal/wmf-print.h"
+#include "manifest.h"
 #include "system.h"
 
 #ifdef HAVE_POPPLER
@@ -146,6 +147,38 @@ update_pref(Glib::ustring const &pref_path,
 static std::vector<std::string> user_extensions;
 static std::vector<std::string> shared_extensions;
 
+#ifdef WITH_MAGICK
+/** Sets up ImageMagick when the first raster effect is built. */
+static void init_magick()
+{
+    static bool initialized = false;
+    if (!initialized) {
+        Magick::InitializeMagick(nullptr);
+        initialized = true;
+    }
+}
+#endif
+
+/** The IDs and kinds of the .inx files, kept for refreshing. */
+static Manifest &get_manifest()
+{
+    static Manifest manifest(Manifest::default_path());
+    return manifest;
+}
+
+/**
+ * Registers the extension described in an .inx file. It is only built, which means reading the
+ * file, when it is first used; only the manifest is read now.
+ */
+static void register_from_file(std::string const &filename)
+{
+    if (auto entry = get_manifest().lookup(filename)) {
+        db.defer(std::move(entry->id), entry->type, [filename] { build_from_file(filename.c_str()); });
+    } else {
+        build_from_file(filename.c_str()); // Reports what is wrong with it.
+    }
+}
+
 /**
  * Invokes the init routines for internal modules.
  *
@@ -200,45 +233,56 @@ init()
     Internal::GimpGrad::init();
     Internal::Grid::init();
 
-    /* Raster Effects */
+    /* Raster Effects: ImageMagick is only initialized once one of them is used. */
 #ifdef WITH_MAGICK
-    Magick::InitializeMagick(NULL);
-
-    Internal::Bitmap::AdaptiveThreshold::init();
-    Internal::Bitmap::AddNoise::init();
-    Internal::Bitmap::Blur::init();
-    Internal::Bitmap::Channel::init();
-    Internal::Bitmap::Charcoal::init();
-    Internal::Bitmap::Colorize::init();
-    Internal::Bitmap::Contrast::init();
-    Internal::Bitmap::Crop::init();
-    Internal::Bitmap::CycleColormap::init();
-    Internal::Bitmap::Edge::init();
-    Internal::Bitmap::Despeckle::init();
-    Internal::Bitmap::Emboss::init();
-    Internal::Bitmap::Enhance::init();
-    Internal::Bitmap::Equalize::init();
-    Internal::Bitmap::GaussianBlur::init();
-    Internal::Bitmap::Implode::init();
-    Internal::Bitmap::Level::init();
-    Internal::Bitmap::LevelChannel::init();
-    Internal::Bitmap::MedianFilter::init();
-    Internal::Bitmap::Modulate::init();
-    Internal::Bitmap::Negate::init();
-    Internal::Bitmap::Normalize::init();
-    Internal::Bitmap::OilPaint::init();
-    Internal::Bitmap::Opacity::init();
-    Internal::Bitmap::Raise::init();
-    Internal::Bitmap::ReduceNoise::init();
-    Internal::Bitmap::Sample::init();
-    Internal::Bitmap::Shade::init();
-    Internal::Bitmap::Sharpen::init();
-    Internal::Bitmap::Solarize::init();
-    Internal::Bitmap::Spread::init();
-    Internal::Bitmap::Swirl::init();
-    //Internal::Bitmap::Threshold::init();
-    Internal::Bitmap::Unsharpmask::init();
-    Internal::Bitmap::Wave::init();
+    struct BitmapEffect
+    {
+        char const *id;
+        void (*init)();
+    };
+    static BitmapEffect const bitmap_effects[] = {
+        {"org.inkscape.effect.bitmap.adaptiveThreshold", &Internal::Bitmap::AdaptiveThreshold::init},
+        {"org.inkscape.effect.bitmap.addNoise", &Internal::Bitmap::AddNoise::init},
+        {"org.inkscape.effect.bitmap.blur", &Internal::Bitmap::Blur::init},
+        {"org.inkscape.effect.bitmap.channel", &Internal::Bitmap::Channel::init},
+        {"org.inkscape.effect.bitmap.charcoal", &Internal::Bitmap::Charcoal::init},
+        {"org.inkscape.effect.bitmap.colorize", &Internal::Bitmap::Colorize::init},
+        {"org.inkscape.effect.bitmap.contrast", &Internal::Bitmap::Contrast::init},
+        {"org.inkscape.effect.bitmap.crop", &Internal::Bitmap::Crop::init},
+        {"org.inkscape.effect.bitmap.cycleColormap", &Internal::Bitmap::CycleColormap::init},
+        {"org.inkscape.effect.bitmap.edge", &Internal::Bitmap::Edge::init},
+        {"org.inkscape.effect.bitmap.despeckle", &Internal::Bitmap::Despeckle::init},
+        {"org.inkscape.effect.bitmap.emboss", &Internal::Bitmap::Emboss::init},
+        {"org.inkscape.effect.bitmap.enhance", &Internal::Bitmap::Enhance::init},
+        {"org.inkscape.effect.bitmap.equalize", &Internal::Bitmap::Equalize::init},
+        {"org.inkscape.effect.bitmap.gaussianBlur", &Internal::Bitmap::GaussianBlur::init},
+        {"org.inkscape.effect.bitmap.implode", &Internal::Bitmap::Implode::init},
+        {"org.inkscape.effect.bitmap.level", &Internal::Bitmap::Level::init},
+        {"org.inkscape.effect.bitmap.levelChannel", &Internal::Bitmap::LevelChannel::init},
+        {"org.inkscape.effect.bitmap.medianFilter", &Internal::Bitmap::MedianFilter::init},
+        {"org.inkscape.effect.bitmap.modulate", &Internal::Bitmap::Modulate::init},
+        {"org.inkscape.effect.bitmap.negate", &Internal::Bitmap::Negate::init},
+        {"org.inkscape.effect.bitmap.normalize", &Internal::Bitmap::Normalize::init},
+        {"org.inkscape.effect.bitmap.oilPaint", &Internal::Bitmap::OilPaint::init},
+        {"org.inkscape.effect.bitmap.opacity", &Internal::Bitmap::Opacity::init},
+        {"org.inkscape.effect.bitmap.raise", &Internal::Bitmap::Raise::init},
+        {"org.inkscape.effect.bitmap.reduceNoise", &Internal::Bitmap::ReduceNoise::init},
+        {"org.inkscape.effect.bitmap.sample", &Internal::Bitmap::Sample::init},
+        {"org.inkscape.effect.bitmap.shade", &Internal::Bitmap::Shade::init},
+        {"org.inkscape.effect.bitmap.sharpen", &Internal::Bitmap::Sharpen::init},
+        {"org.inkscape.effect.bitmap.solarize", &Internal::Bitmap::Solarize::init},
+        {"org.inkscape.effect.bitmap.spread", &Internal::Bitmap::Spread::init},
+        {"org.inkscape.effect.bitmap.swirl", &Internal::Bitmap::Swirl::init},
+        //{"org.inkscape.effect.bitmap.threshold", &Internal::Bitmap::Threshold::init},
+        {"org.inkscape.effect.bitmap.unsharpmask", &Internal::Bitmap::Unsharpmask::init},
+        {"org.inkscape.effect.bitmap.wave", &Internal::Bitmap::Wave::init},
+    };
+    for (auto const &effect : bitmap_effects) {
+        db.defer(effect.id, MODULE_FILTER, [init = effect.init] {
+            init_magick();
+            init();
+        });
+    }
 #endif /* WITH_MAGICK */
 
     Internal::Filter::Filter::filters_all();
@@ -248,8 +292,9 @@ init()
     load_shared_extensions();
 
     for(auto &filename: get_filenames(SYSTEM, EXTENSIONS, {SP_MODULE_EXTENSION})) {
-        build_from_file(filename.c_str());
+        register_from_file(filename);
     }
+    get_manifest().save();
 
     /* this is at the very end because it has several catch-alls
      * that are possibly over-ridden by other extensions (such as
@@ -286,7 +331,7 @@ load_user_extensions()
         bool const exist = contains(  user_extensions, filename) ||
                            contains(shared_extensions, filename);
         if (!exist) {
-            build_from_file(filename.c_str());
+            register_from_file(filename);
             user_extensions.push_back(std::move(filename));
         }
     }
@@ -300,7 +345,7 @@ load_shared_extensions()
         bool const exist = contains(shared_extensions, filename) ||
                            contains(  user_extensions, filename);
         if (!exist) {
-            build_from_file(filename.c_str());
+            register_from_file(filename);
             shared_extensions.push_back(std::move(filename));
         }
     }
@@ -318,6 +363,7 @@ void
 refresh_user_extensions()
 {
     load_user_extensions();
+    get_manifest().save();
     check_extensions();
 }
 
@@ -334,6 +380,9 @@ check_extensions_internal(Extension *in_plug, gpointer in_data)
     }
 }
 
+/**
+ * Checks the extensions that are built; deferred ones are checked when they are built.
+ */
 static void check_extensions()
 {
     int count = 1;
@@ -341,7 +390,7 @@ static void check_extensions()
     Inkscape::Extension::Extension::error_file_open();
     while (count != 0) {
         count = 0;
-        db.foreach(check_extensions_internal, (gpointer)&count);
+        db.foreach(check_extensions_internal, (gpointer)&count, false);
     }
     Inkscape::Extension::Extension::error_file_close();
 }
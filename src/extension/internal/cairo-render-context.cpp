@@ -1095,8 +1095,6 @@ CairoRenderContext::_createPatternPainter(SPPaintServer const *const paintserver
     double surface_width = MAX(ceil(SUBPIX_SCALE * bbox_width_scaler * width - 0.5), 1);
     double surface_height = MAX(ceil(SUBPIX_SCALE * bbox_height_scaler * height - 0.5), 1);
     TRACE(("pattern surface size: %f x %f\n", surface_width, surface_height));
-    // create new rendering context
-    CairoRenderContext pattern_ctx = createSimilar(surface_width, surface_height);
 
     // adjust the size of the painted pattern to fit exactly the created surface
     // this has to be done because of the rounding to obtain an integer pattern surface width/height
@@ -1112,6 +1110,34 @@ CairoRenderContext::_createPatternPainter(SPPaintServer const *const paintserver
     ps2user[4] = ori[Geom::X];
     ps2user[5] = ori[Geom::Y];
 
+    // setup a cairo_pattern_t
+    cairo_pattern_t *result = nullptr;
+    if (auto tile = _vector_based_target ? _renderer->getPatternTile(pat, pcs2dev, surface_width, surface_height) : nullptr) {
+        // Same contents as an earlier use; sharing the surface writes them out only once.
+        result = cairo_pattern_create_for_surface(tile);
+    } else {
+        result = _renderPatternTile(pat, pcs2dev, surface_width, surface_height);
+    }
+    cairo_pattern_set_extend(result, CAIRO_EXTEND_REPEAT);
+
+    // set pattern transformation
+    cairo_matrix_t pattern_matrix;
+    ink_matrix_to_cairo(pattern_matrix, ps2user);
+    cairo_matrix_invert(&pattern_matrix);
+    cairo_pattern_set_matrix(result, &pattern_matrix);
+
+    return result;
+}
+
+/**
+ * Render the contents of a pattern tile; see _createPatternPainter().
+ */
+cairo_pattern_t *CairoRenderContext::_renderPatternTile(SPPattern *pat, Geom::Affine const &pcs2dev,
+                                                        double surface_width, double surface_height)
+{
+    // create new rendering context
+    CairoRenderContext pattern_ctx = createSimilar(surface_width, surface_height);
+
     pattern_ctx.setTransform(pcs2dev);
     pattern_ctx.pushState();
 
@@ -1134,17 +1160,12 @@ CairoRenderContext::_createPatternPainter(SPPaintServer const *const paintserver
 
     pattern_ctx.popState();
 
-    // setup a cairo_pattern_t
     cairo_surface_t *pattern_surface = pattern_ctx.getSurface();
     TEST(pattern_ctx->saveAsPng("pattern.png"));
     cairo_pattern_t *result = cairo_pattern_create_for_surface(pattern_surface);
-    cairo_pattern_set_extend(result, CAIRO_EXTEND_REPEAT);
-
-    // set pattern transformation
-    cairo_matrix_t pattern_matrix;
-    ink_matrix_to_cairo(pattern_matrix, ps2user);
-    cairo_matrix_invert(&pattern_matrix);
-    cairo_pattern_set_matrix(result, &pattern_matrix);
+    if (_vector_based_target) {
+        _renderer->addPatternTile(pat, pcs2dev, surface_width, surface_height, pattern_surface);
+    }
 
     // hide all items
     for (SPPattern *pat_i = pat; pat_i != nullptr; pat_i = pat_i->ref.getObject()) {
@@ -1611,7 +1632,7 @@ bool CairoRenderContext::renderPathVector(Geom::PathVector const &pathv,
     return true;
 }
 
-bool CairoRenderContext::renderImage(Inkscape::Pixbuf const *pb,
+bool CairoRenderContext::renderImage(std::shared_ptr<Inkscape::Pixbuf const> const &pb,
                                      Geom::Affine const &image_transform, SPStyle const *style)
 {
     g_assert( _is_valid );
@@ -1638,8 +1659,15 @@ bool CairoRenderContext::renderImage(Inkscape::Pixbuf const *pb,
     // scaling by width & height is not needed because it will be done by Cairo
     transform(image_transform);
 
-    // cairo_set_source_surface only modifies refcount of 'image_surface', which is an implementation detail
-    cairo_set_source_surface(_cr, const_cast<cairo_surface_t*>(image_surface), 0.0, 0.0);
+    if (_vector_based_target) {
+        // Lets cairo write the same pixels once however often they are painted.
+        auto surface = _renderer->createImageSurface(pb);
+        cairo_set_source_surface(_cr, surface, 0.0, 0.0);
+        cairo_surface_destroy(surface);
+    } else {
+        // cairo_set_source_surface only modifies refcount of 'image_surface', which is an implementation detail
+        cairo_set_source_surface(_cr, const_cast<cairo_surface_t*>(image_surface), 0.0, 0.0);
+    }
 
     // set clip region so that the pattern will not be repeated (bug in Cairo-PDF)
     if (_vector_based_target) {
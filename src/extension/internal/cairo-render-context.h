@@ -15,6 +15,7 @@
  */
 
 #include "extension/extension.h"
+#include <memory>
 #include <set>
 #include <string>
 
@@ -27,6 +28,7 @@
 
 class SPClipPath;
 class SPMask;
+class SPPattern;
 
 typedef struct _PangoFont PangoFont;
 typedef struct _PangoLayout PangoLayout;
@@ -170,7 +172,7 @@ public:
     void addClippingRect(double x, double y, double width, double height);
 
     bool renderPathVector(Geom::PathVector const &pathv, SPStyle const *style, Geom::OptRect const &pbox, CairoPaintOrder order = STROKE_OVER_FILL);
-    bool renderImage(Inkscape::Pixbuf const *pb,
+    bool renderImage(std::shared_ptr<Inkscape::Pixbuf const> const &pb,
                      Geom::Affine const &image_transform, SPStyle const *style);
     bool renderGlyphtext(PangoFont *font, Geom::Affine const &font_matrix,
                          std::vector<CairoGlyphInfo> const &glyphtext, SPStyle const *style,
@@ -237,6 +239,8 @@ private:
     cairo_pattern_t *_createPatternForPaintServer(SPPaintServer const *const paintserver,
                                                   Geom::OptRect const &pbox, float alpha);
     cairo_pattern_t *_createPatternPainter(SPPaintServer const *const paintserver, Geom::OptRect const &pbox);
+    cairo_pattern_t *_renderPatternTile(SPPattern *pat, Geom::Affine const &pcs2dev, double surface_width,
+                                        double surface_height);
     cairo_pattern_t *_createHatchPainter(SPPaintServer const *const paintserver, Geom::OptRect const &pbox);
 
     unsigned int _showGlyphs(cairo_t *cr, PangoFont *font, std::vector<CairoGlyphInfo> const &glyphtext, bool is_stroke);
@@ -26,9 +26,16 @@
 #endif
 
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <csignal>
 #include <cerrno>
+#include <deque>
+#include <future>
 
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <2geom/transforms.h>
 #include <2geom/pathvector.h>
 #include <2geom/point.h>
@@ -74,6 +81,8 @@
 #include "object/sp-text.h"
 #include "object/sp-use.h"
 
+#include "util/scope_exit.h"
+#include "util/threading.h"
 #include "util/units.h"
 
 //#define TRACE(_args) g_printf _args
@@ -89,6 +98,10 @@ CairoRenderer::CairoRenderer() = default;
 
 CairoRenderer::~CairoRenderer()
 {
+    for (auto const &[key, tile] : _pattern_tiles) {
+        cairo_surface_destroy(tile);
+    }
+
     /* restore default signal handling for SIGPIPE */
 #if !defined(_WIN32) && !defined(__WIN32__)
     (void) signal(SIGPIPE, SIG_DFL);
@@ -100,6 +113,101 @@ CairoRenderContext CairoRenderer::createContext()
     return CairoRenderContext{this};
 }
 
+/**
+ * A digest of the pixels of \a surface and of the encoded image attached to it, if any.
+ */
+static std::string image_content_id(cairo_surface_t *surface)
+{
+    auto checksum = g_checksum_new(G_CHECKSUM_SHA256);
+
+    int const width = cairo_image_surface_get_width(surface);
+    int const height = cairo_image_surface_get_height(surface);
+    int const stride = cairo_image_surface_get_stride(surface);
+    int const header[] = {width, height, cairo_image_surface_get_format(surface)};
+    g_checksum_update(checksum, reinterpret_cast<guchar const *>(header), sizeof(header));
+
+    // Only the visible part of each row; the padding at the end may be anything.
+    auto const row_bytes = std::min(stride, cairo_format_stride_for_width(cairo_image_surface_get_format(surface), width));
+    auto const data = cairo_image_surface_get_data(surface);
+    for (int y = 0; y < height; ++y) {
+        g_checksum_update(checksum, data + y * stride, row_bytes);
+    }
+
+    for (auto mimetype : {CAIRO_MIME_TYPE_JPEG, CAIRO_MIME_TYPE_JP2, CAIRO_MIME_TYPE_PNG}) {
+        unsigned char const *mime_data = nullptr;
+        unsigned long mime_len = 0;
+        cairo_surface_get_mime_data(surface, mimetype, &mime_data, &mime_len);
+        if (mime_data) {
+            g_checksum_update(checksum, reinterpret_cast<guchar const *>(mimetype), -1);
+            g_checksum_update(checksum, mime_data, mime_len);
+        }
+    }
+
+    std::string id = "inkscape-image-";
+    id += g_checksum_get_string(checksum);
+    g_checksum_free(checksum);
+    return id;
+}
+
+cairo_surface_t *CairoRenderer::createImageSurface(std::shared_ptr<Inkscape::Pixbuf const> const &pb)
+{
+    auto source = pb->getSurfaceRaw();
+
+    // The same pixbuf is usually painted many times; only look at its pixels once.
+    auto &image_id = _image_ids[pb.get()];
+    if (image_id.id.empty() || image_id.pixbuf.expired()) {
+        image_id.pixbuf = pb;
+        image_id.id = image_content_id(source);
+    }
+
+    // Label a surface of our own rather than the pixbuf's, which lives on after the export. It
+    // holds a reference to the pixbuf's surface, as the pixels and encoded data stay there.
+    auto surface = cairo_image_surface_create_for_data(cairo_image_surface_get_data(source),
+                                                       cairo_image_surface_get_format(source),
+                                                       cairo_image_surface_get_width(source),
+                                                       cairo_image_surface_get_height(source),
+                                                       cairo_image_surface_get_stride(source));
+    static cairo_user_data_key_t source_key;
+    cairo_surface_set_user_data(surface, &source_key, cairo_surface_reference(source),
+                                reinterpret_cast<cairo_destroy_func_t>(cairo_surface_destroy));
+
+    for (auto mimetype : {CAIRO_MIME_TYPE_JPEG, CAIRO_MIME_TYPE_JP2, CAIRO_MIME_TYPE_PNG}) {
+        unsigned char const *mime_data = nullptr;
+        unsigned long mime_len = 0;
+        cairo_surface_get_mime_data(source, mimetype, &mime_data, &mime_len);
+        if (mime_data) {
+            cairo_surface_set_mime_data(surface, mimetype, mime_data, mime_len,
+                                        reinterpret_cast<cairo_destroy_func_t>(cairo_surface_destroy),
+                                        cairo_surface_reference(source));
+        }
+    }
+
+    auto id = g_strdup(image_id.id.c_str());
+    cairo_surface_set_mime_data(surface, CAIRO_MIME_TYPE_UNIQUE_ID, reinterpret_cast<unsigned char const *>(id),
+                                image_id.id.size(), g_free, id);
+    return surface;
+}
+
+cairo_surface_t *CairoRenderer::getPatternTile(SPPattern const *pattern, Geom::Affine const &transform,
+                                               double width, double height) const
+{
+    auto it = _pattern_tiles.find({pattern, width, height,
+                                   {transform[0], transform[1], transform[2], transform[3], transform[4], transform[5]}});
+    return it != _pattern_tiles.end() ? it->second : nullptr;
+}
+
+void CairoRenderer::addPatternTile(SPPattern const *pattern, Geom::Affine const &transform,
+                                   double width, double height, cairo_surface_t *tile)
+{
+    auto [it, inserted] = _pattern_tiles.try_emplace(
+        {pattern, width, height,
+         {transform[0], transform[1], transform[2], transform[3], transform[4], transform[5]}},
+        tile);
+    if (inserted) {
+        cairo_surface_reference(tile);
+    }
+}
+
 /* The below functions are copy&pasted plus slightly modified from *_invoke_print functions. */
 static void sp_item_invoke_render(SPItem const *item, CairoRenderContext *ctx, SPItem const *origin = nullptr, SPPage const *page = nullptr);
 static void sp_group_render(SPGroup const *group, CairoRenderContext *ctx, SPItem const *origin = nullptr, SPPage const *page = nullptr);
@@ -423,7 +531,7 @@ static void sp_image_render(SPImage const *image, CairoRenderContext *ctx)
     }
 
     Geom::Affine const transform = Geom::Scale(width / w, height / h) * Geom::Translate(x, y);
-    ctx->renderImage(image->pixbuf.get(), transform, image->style);
+    ctx->renderImage(image->pixbuf, transform, image->style);
 }
 
 static void sp_anchor_render(SPAnchor const *a, CairoRenderContext *ctx)
@@ -506,14 +614,32 @@ static void sp_root_render(SPRoot const *root, CairoRenderContext *ctx)
 }
 
 /**
-    This function converts the item to a raster image and includes the image into the cairo renderer.
-    It is only used for filters and then only when rendering filters as bitmaps is requested.
-*/
-static void sp_asbitmap_render(SPItem const *item, CairoRenderContext *ctx, SPPage const *page)
+ * The area of the document that sp_asbitmap_render() rasterises \a item from, or nothing if the
+ * bitmap would be empty.
+ */
+static Geom::OptRect sp_asbitmap_area(SPItem const *item, SPPage const *page, double res)
 {
+    // Get the bounding box of the selection in document coordinates.
+    Geom::OptRect bbox = item->documentVisualBounds();
 
-    // The code was adapted from sp_selection_create_bitmap_copy in selection-chemistry.cpp
+    bbox &= (page ? page->getDocumentRect() : item->document->preferredBounds());
 
+    // no bbox, e.g. empty group or item not overlapping its page
+    if (!bbox) {
+        return {};
+    }
+
+    // The width and height of the bitmap in pixels
+    unsigned width =  ceil(bbox->width() * Inkscape::Util::Quantity::convert(res, "px", "in"));
+    unsigned height = ceil(bbox->height() * Inkscape::Util::Quantity::convert(res, "px", "in"));
+
+    if (width == 0 || height == 0) return {};
+
+    return bbox;
+}
+
+static double sp_asbitmap_resolution(CairoRenderContext *ctx)
+{
     // Calculate resolution
     /** @TODO reimplement the resolution stuff   (WHY?)
     */
@@ -521,14 +647,22 @@ static void sp_asbitmap_render(SPItem const *item, CairoRenderContext *ctx, SPPa
     if (res == 0) {
         res = Inkscape::Util::Quantity::convert(1, "in", "px");
     }
-    TRACE(("sp_asbitmap_render: resolution: %f\n", res ));
+    return res;
+}
 
-    // Get the bounding box of the selection in document coordinates.
-    Geom::OptRect bbox = item->documentVisualBounds();
+/**
+    This function converts the item to a raster image and includes the image into the cairo renderer.
+    It is only used for filters and then only when rendering filters as bitmaps is requested.
+*/
+static void sp_asbitmap_render(SPItem const *item, CairoRenderContext *ctx, SPPage const *page)
+{
 
-    bbox &= (page ? page->getDocumentRect() : item->document->preferredBounds());
+    // The code was adapted from sp_selection_create_bitmap_copy in selection-chemistry.cpp
 
-    // no bbox, e.g. empty group or item not overlapping its page
+    double res = sp_asbitmap_resolution(ctx);
+    TRACE(("sp_asbitmap_render: resolution: %f\n", res ));
+
+    Geom::OptRect bbox = sp_asbitmap_area(item, page, res);
     if (!bbox) {
         return;
     }
@@ -537,8 +671,6 @@ static void sp_asbitmap_render(SPItem const *item, CairoRenderContext *ctx, SPPa
     unsigned width =  ceil(bbox->width() * Inkscape::Util::Quantity::convert(res, "px", "in"));
     unsigned height = ceil(bbox->height() * Inkscape::Util::Quantity::convert(res, "px", "in"));
 
-    if (width == 0 || height == 0) return;
-
     // Scale to exactly fit integer bitmap inside bounding box
     double scale_x = bbox->width() / width;
     double scale_y = bbox->height() / height;
@@ -562,12 +694,17 @@ static void sp_asbitmap_render(SPItem const *item, CairoRenderContext *ctx, SPPa
     Geom::Affine t_item =  item->i2doc_affine();
     Geom::Affine t = t_on_document * t_item.inverse();
 
-    // Do the export
-    std::unique_ptr<Inkscape::Pixbuf> pb(sp_generate_internal_bitmap(item->document, *bbox, res, {item}, true));
+    // Do the export, unless it was already done on a worker thread
+    std::shared_ptr<Inkscape::Pixbuf const> pb;
+    if (auto queued = ctx->getRenderer()->takeQueuedBitmap(item, page)) {
+        pb = std::move(*queued);
+    } else {
+        pb.reset(sp_generate_internal_bitmap(item->document, *bbox, res, {item}, true));
+    }
 
     if (pb) {
         //TEST(gdk_pixbuf_save( pb, "bitmap.png", "png", NULL, NULL ));
-        ctx->renderImage(pb.get(), t, item->style);
+        ctx->renderImage(pb, t, item->style);
     }
 }
 
@@ -722,13 +859,218 @@ bool CairoRenderer::setupDocument(CairoRenderContext *ctx, SPDocument *doc, SPIt
     return ctx->setupSurface(width, height);
 }
 
+/**
+ * Rasterises filtered items on a thread pool ahead of renderPages() reaching them.
+ *
+ * The items are found by walking the pages the way renderPage() and renderItem() do, a few pages
+ * ahead of the page being written. Their drawings are set up on the calling thread, as that
+ * touches the document, and only the rendering runs on the workers. sp_asbitmap_render() then
+ * takes the bitmaps in order; items it asks for that weren't foreseen, such as in masks or
+ * markers, are still rasterised on the spot.
+ *
+ * A drawing shows the whole document, so one is only kept while its bitmap is rendered, one
+ * per thread at most. Finished bitmaps wait to be taken up to a budget of memory.
+ */
+class CairoRenderer::BitmapQueue
+{
+public:
+    BitmapQueue(CairoRenderContext *ctx, std::vector<SPPage *> pages, SPItem const *root, int num_threads)
+        : _ctx(ctx)
+        , _pages(std::move(pages))
+        , _root(root)
+        , _max_jobs(num_threads)
+        , _pool(num_threads)
+    {
+        _fill();
+    }
+
+    ~BitmapQueue()
+    {
+        // Drop what wasn't started yet; the drawings must outlive the renders in progress.
+        _pool.stop();
+        _pool.join();
+    }
+
+    std::optional<std::unique_ptr<Inkscape::Pixbuf>> take(SPItem const *item, SPPage const *page)
+    {
+        auto it = std::find_if(_jobs.begin(), _jobs.end(), [&] (Job const &job) {
+            return job.item == item && job.page == page;
+        });
+        if (it == _jobs.end()) {
+            return {};
+        }
+
+        // Bitmaps queued before this one were skipped by the render, which only happens if
+        // _collect() doesn't match renderItem(); drop them once their drawings are done with.
+        auto bitmap = it->bitmap.get();
+        for (auto job = _jobs.begin(); job != it; ++job) {
+            job->bitmap.wait();
+            _queued_bytes -= job->bytes;
+        }
+        _queued_bytes -= it->bytes;
+        _jobs.erase(_jobs.begin(), it + 1);
+
+        _fill();
+        return bitmap;
+    }
+
+private:
+    struct Job
+    {
+        SPItem const *item;
+        SPPage const *page;
+        std::unique_ptr<InternalBitmapDrawing> drawing; ///< Reset once the bitmap is rendered
+        std::future<std::unique_ptr<Inkscape::Pixbuf>> bitmap;
+        std::size_t bytes = 0;
+    };
+
+    /// Memory that bitmaps may take while they are rendered or wait to be taken.
+    static constexpr std::size_t MAX_QUEUED_BYTES = 256 << 20;
+
+    /// Queue bitmaps until enough are being worked on, finding more items as needed.
+    void _fill()
+    {
+        // The drawings of finished bitmaps have to go on this thread, as they touch the document.
+        std::size_t rendering = 0;
+        for (auto &job : _jobs) {
+            if (job.drawing && job.bitmap.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                job.drawing.reset();
+            }
+            rendering += job.drawing != nullptr;
+        }
+
+        while (rendering < _max_jobs) {
+            if (_items.empty() && !_collectNextPage()) {
+                return;
+            }
+            auto [item, page] = _items.front();
+
+            double res = sp_asbitmap_resolution(_ctx);
+            auto bbox = sp_asbitmap_area(item, page, res);
+            if (!bbox) {
+                _items.pop_front();
+                continue;
+            }
+
+            double const scale = Inkscape::Util::Quantity::convert(res, "px", "in");
+            std::size_t const bytes = 4 * std::ceil(scale * bbox->width()) * std::ceil(scale * bbox->height());
+            if (!_jobs.empty() && _queued_bytes + bytes > MAX_QUEUED_BYTES) {
+                return; // Rasterised on the spot if it doesn't fit by the time it is rendered.
+            }
+            _items.pop_front();
+
+            auto &job = _jobs.emplace_back();
+            job.item = item;
+            job.page = page;
+            job.bytes = bytes;
+            _queued_bytes += bytes;
+            job.drawing = std::make_unique<InternalBitmapDrawing>(item->document, *bbox, res,
+                                                                  std::vector<SPItem const *>{item}, true);
+            auto task = std::make_shared<std::packaged_task<std::unique_ptr<Inkscape::Pixbuf>()>>(
+                [drawing = job.drawing.get()] { return std::unique_ptr<Inkscape::Pixbuf>(drawing->render()); });
+            job.bitmap = task->get_future();
+            boost::asio::post(_pool, [task] { (*task)(); });
+            rendering++;
+        }
+    }
+
+    bool _collectNextPage()
+    {
+        if (_root) {
+            // No pages, the whole document is rendered.
+            _collect(_root, nullptr);
+            _root = nullptr;
+            return true;
+        }
+        if (_next_page >= _pages.size()) {
+            return false;
+        }
+        auto page = _pages[_next_page++];
+        for (auto &child : page->getOverlappingItems(false, true, false)) {
+            _collect(child, page);
+        }
+        return true;
+    }
+
+    /// Find the items that _doRender() will rasterise when rendering \a item.
+    void _collect(SPItem const *item, SPPage const *page)
+    {
+        if (item->isHidden() || has_hidder_filter(item)) {
+            return;
+        }
+        if (_shouldRasterize(_ctx, item)) {
+            _items.emplace_back(item, page);
+            return;
+        }
+
+        // Mirrors sp_item_invoke_render().
+        if (auto root = cast<SPRoot>(item)) {
+            _collectChildren(root, nullptr);
+        } else if (auto symbol = cast<SPSymbol>(item)) {
+            if (symbol->cloned) {
+                _collectChildren(symbol, page);
+            }
+        } else if (auto anchor = cast<SPAnchor>(item)) {
+            _collectChildren(anchor, nullptr);
+        } else if (auto use = cast<SPUse>(item)) {
+            if (use->child) {
+                _collect(use->child, page);
+            }
+        } else if (is<SPMarker>(item)) {
+        } else if (auto group = cast<SPGroup>(item)) {
+            _collectChildren(group, page);
+        }
+    }
+
+    void _collectChildren(SPGroup const *group, SPPage const *page)
+    {
+        for (auto &obj : group->children) {
+            if (auto item = cast<SPItem>(&obj)) {
+                _collect(item, page);
+            }
+        }
+    }
+
+    CairoRenderContext *_ctx;
+    std::vector<SPPage *> _pages;
+    std::size_t _next_page = 0;
+    SPItem const *_root;
+    std::deque<std::pair<SPItem const *, SPPage const *>> _items;
+    std::deque<Job> _jobs;
+    std::size_t _max_jobs;
+    std::size_t _queued_bytes = 0;
+    boost::asio::thread_pool _pool;
+};
+
+std::optional<std::unique_ptr<Inkscape::Pixbuf>>
+CairoRenderer::takeQueuedBitmap(SPItem const *item, SPPage const *page)
+{
+    if (!_bitmap_queue) {
+        return {};
+    }
+    return _bitmap_queue->take(item, page);
+}
+
 /**
  * Handle multiple pages, pushing each out to cairo as needed using renderItem()
+ *
+ * Filtered items that are rasterised are rendered on worker threads, while the pages are
+ * written out in order.
  */
 bool
 CairoRenderer::renderPages(CairoRenderContext *ctx, SPDocument *doc, bool stretch_to_fit)
 {
     auto pages = doc->getPageManager().getPages();
+
+    if (ctx->getFilterToBitmap()) {
+        int const num_threads = Inkscape::get_num_threads();
+        if (num_threads > 1) {
+            _bitmap_queue = std::make_unique<BitmapQueue>(ctx, pages, pages.empty() ? doc->getRoot() : nullptr,
+                                                          num_threads);
+        }
+    }
+    auto queue_guard = scope_exit([this] { _bitmap_queue.reset(); });
+
     if (pages.size() == 0) {
         // Output the page bounding box as already set up in the initial setupDocument.
         renderItem(ctx, doc->getRoot());
@@ -16,8 +16,15 @@
  */
 
 #include "extension/extension.h"
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <2geom/forward.h>
 
 //#include "libnrtype/font-instance.h"
 #include <cairo.h>
@@ -27,6 +34,11 @@ class SPClipPath;
 class SPMask;
 class SPHatchPath;
 class SPPage;
+class SPPattern;
+
+namespace Inkscape {
+class Pixbuf;
+} // namespace Inkscape
 
 namespace Inkscape {
 namespace Extension {
@@ -57,7 +69,36 @@ public:
     bool renderPages(CairoRenderContext *ctx, SPDocument *doc, bool stretch_to_fit);
     bool renderPage(CairoRenderContext *ctx, SPDocument *doc, SPPage const *page, bool stretch_to_fit);
 
+    /** The bitmap of a filtered item that renderPages() had rasterised ahead of time, if any.
+    Returns nothing if the item wasn't queued; the bitmap itself may still be null. */
+    std::optional<std::unique_ptr<Inkscape::Pixbuf>> takeQueuedBitmap(SPItem const *item, SPPage const *page);
+
+    /** A surface with the pixels of \a pb for vector output, labelled with their content through
+    CAIRO_MIME_TYPE_UNIQUE_ID so that identical images are embedded only once. Returns a new
+    reference. */
+    cairo_surface_t *createImageSurface(std::shared_ptr<Inkscape::Pixbuf const> const &pb);
+
+    /** The tile of \a pattern rendered earlier in this export with the same transform and size,
+    or null. Reusing it makes every use of the pattern refer to a single object. */
+    cairo_surface_t *getPatternTile(SPPattern const *pattern, Geom::Affine const &transform,
+                                    double width, double height) const;
+    void addPatternTile(SPPattern const *pattern, Geom::Affine const &transform,
+                        double width, double height, cairo_surface_t *tile);
+
 private:
+    struct ImageId
+    {
+        std::weak_ptr<Inkscape::Pixbuf const> pixbuf; ///< To tell if the address was reused.
+        std::string id;
+    };
+    std::unordered_map<Inkscape::Pixbuf const *, ImageId> _image_ids;
+
+    using PatternTileKey = std::tuple<SPPattern const *, double, double, std::array<double, 6>>;
+    std::map<PatternTileKey, cairo_surface_t *> _pattern_tiles;
+
+    class BitmapQueue;
+    std::unique_ptr<BitmapQueue> _bitmap_queue;
+
     /** Decide whether the given item should be rendered as a bitmap. */
     static bool _shouldRasterize(CairoRenderContext *ctx, SPItem const *item);
 
@@ -21,6 +21,14 @@
 #include <string>
 #include <locale>
 #include <codecvt>
+#include <deque>
+#include <future>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 
 #ifdef HAVE_POPPLER
 
@@ -47,6 +55,7 @@
 #include "svg/css-ostringstream.h"
 #include "svg/path-string.h"
 #include "svg/svg.h"
+#include "util/threading.h"
 #include "util/units.h"
 #include "xml/document.h"
 #include "xml/node.h"
@@ -68,6 +77,328 @@ namespace Internal {
  *
  */
 
+/**
+ * Pixels of an image as rows for png_write_row(): 8-bit gray if alpha_only, otherwise 32-bit
+ * BGRA words in host order.
+ */
+struct DecodedImage
+{
+    int width = 0;
+    int height = 0;
+    bool alpha_only = false;
+    bool invert_alpha = false;
+    std::vector<unsigned char> pixels;
+
+    std::size_t rowBytes() const { return alpha_only ? width : width * sizeof(unsigned int); }
+};
+
+/**
+ * Helper functions for supporting direct PNG output into a base64 encoded stream
+ */
+void png_write_vector(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+    auto *v_ptr = reinterpret_cast<std::vector<guchar> *>(png_get_io_ptr(png_ptr)); // Get pointer to stream
+    v_ptr->insert(v_ptr->end(), data, data + length);
+}
+
+/**
+ * Compresses decoded pixels into PNG data. Only uses \a image, so it may run on any thread.
+ * @return The PNG data, or nothing if libpng failed.
+ */
+static std::optional<std::vector<guchar>> encode_png(DecodedImage const &image)
+{
+    // Create PNG write struct
+    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+    if ( png_ptr == nullptr ) {
+        return {};
+    }
+    // Create PNG info struct
+    png_infop info_ptr = png_create_info_struct(png_ptr);
+    if ( info_ptr == nullptr ) {
+        png_destroy_write_struct(&png_ptr, nullptr);
+        return {};
+    }
+    std::vector<guchar> png_buffer;
+    // Set error handler
+    if (setjmp(png_jmpbuf(png_ptr))) {
+        png_destroy_write_struct(&png_ptr, &info_ptr);
+        return {};
+    }
+    png_set_write_fn(png_ptr, &png_buffer, png_write_vector, nullptr);
+
+    // Set header data
+    if ( !image.invert_alpha && !image.alpha_only ) {
+        png_set_invert_alpha(png_ptr);
+    }
+    png_color_8 sig_bit;
+    if (image.alpha_only) {
+        png_set_IHDR(png_ptr, info_ptr,
+                     image.width,
+                     image.height,
+                     8, /* bit_depth */
+                     PNG_COLOR_TYPE_GRAY,
+                     PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_BASE,
+                     PNG_FILTER_TYPE_BASE);
+        sig_bit.red = 0;
+        sig_bit.green = 0;
+        sig_bit.blue = 0;
+        sig_bit.gray = 8;
+        sig_bit.alpha = 0;
+    } else {
+        png_set_IHDR(png_ptr, info_ptr,
+                     image.width,
+                     image.height,
+                     8, /* bit_depth */
+                     PNG_COLOR_TYPE_RGB_ALPHA,
+                     PNG_INTERLACE_NONE,
+                     PNG_COMPRESSION_TYPE_BASE,
+                     PNG_FILTER_TYPE_BASE);
+        sig_bit.red = 8;
+        sig_bit.green = 8;
+        sig_bit.blue = 8;
+        sig_bit.alpha = 8;
+    }
+    png_set_sBIT(png_ptr, info_ptr, &sig_bit);
+    png_set_bgr(png_ptr);
+    // Write the file header
+    png_write_info(png_ptr, info_ptr);
+
+    auto const row_bytes = image.rowBytes();
+    for (int y = 0; y < image.height; y++) {
+        png_write_row(png_ptr, const_cast<png_bytep>(image.pixels.data() + y * row_bytes));
+    }
+
+    // Close PNG
+    png_write_end(png_ptr, info_ptr);
+    png_destroy_write_struct(&png_ptr, &info_ptr);
+    return png_buffer;
+}
+
+static std::string png_data_uri(std::vector<guchar> const &png_buffer)
+{
+    // Append format specification to the URI
+    auto *base64String = g_base64_encode(png_buffer.data(), png_buffer.size());
+    auto png_data = std::string("data:image/png;base64,") + base64String;
+    g_free(base64String);
+    return png_data;
+}
+
+/**
+ * Turns decoded images into PNG data URIs on a thread pool, while the parser goes on with the
+ * page. The <image> elements are created straight away and get their xlink:href once it is
+ * ready, at the latest when the top-level builder is done.
+ */
+class SvgBuilder::ImageEncoder
+{
+public:
+    ImageEncoder()
+    {
+        int const num_threads = Inkscape::get_num_threads();
+        if (num_threads > 1) {
+            _pool.emplace(num_threads);
+            // Bounds the memory taken by decoded images waiting for their turn.
+            _max_jobs = 2 * num_threads;
+        }
+    }
+
+    ~ImageEncoder() { finish(); }
+
+    void add(Inkscape::XML::Node *image_node, DecodedImage image)
+    {
+        if (!_pool) {
+            _setHref(image_node, encode_png(image));
+            return;
+        }
+
+        while (_jobs.size() >= _max_jobs) {
+            _finishOldest();
+        }
+
+        auto task = std::make_shared<std::packaged_task<std::optional<std::vector<guchar>>()>>(
+            [image = std::move(image)] { return encode_png(image); });
+        // The node has to outlive the job, whatever the builder does with it meanwhile.
+        Inkscape::GC::anchor(image_node);
+        _jobs.push_back({image_node, task->get_future()});
+        boost::asio::post(*_pool, [task] { (*task)(); });
+    }
+
+    void finish()
+    {
+        while (!_jobs.empty()) {
+            _finishOldest();
+        }
+    }
+
+    /// Give the images within \a subtree their xlink:href now.
+    void finish(Inkscape::XML::Node const *subtree)
+    {
+        for (auto it = _jobs.begin(); it != _jobs.end();) {
+            auto node = it->node;
+            while (node && node != subtree) {
+                node = node->parent();
+            }
+            if (node) {
+                _finish(*it);
+                it = _jobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+private:
+    struct Job
+    {
+        Inkscape::XML::Node *node;
+        std::future<std::optional<std::vector<guchar>>> png;
+    };
+
+    void _finishOldest()
+    {
+        auto job = std::move(_jobs.front());
+        _jobs.pop_front();
+        _finish(job);
+    }
+
+    static void _finish(Job &job)
+    {
+        _setHref(job.node, job.png.get());
+        Inkscape::GC::release(job.node);
+    }
+
+    static void _setHref(Inkscape::XML::Node *node, std::optional<std::vector<guchar>> const &png)
+    {
+        if (png) {
+            node->setAttributeOrRemoveIfEmpty("xlink:href", png_data_uri(*png));
+        } else {
+            g_warning("SvgBuilder: could not encode an image as PNG");
+        }
+    }
+
+    std::deque<Job> _jobs;
+    std::size_t _max_jobs = 0;
+    std::optional<boost::asio::thread_pool> _pool;
+};
+
+/**
+ * Clip paths, gradients and patterns already in <defs>, by their content. PDFs, from CAD
+ * programs in particular, often set the same clip or shading over and over; each is only
+ * added once and then referred to again.
+ */
+class SvgBuilder::DefsCache
+{
+public:
+    std::unordered_multimap<std::size_t, std::string> ids; ///< Hash of the content to ids
+    std::unordered_map<std::string, std::size_t> hashes;   ///< Id to hash of its content
+    std::unordered_set<std::string> shared;                ///< Ids that were reused
+    int reused = 0;
+};
+
+/**
+ * Write out what defines \a node: its name, its attributes but the id, and its children.
+ */
+static void append_def_key(std::string &key, Inkscape::XML::Node const *node)
+{
+    if (auto content = node->content()) {
+        key += '"';
+        key += content;
+        key += '\0';
+        return;
+    }
+    key += '<';
+    key += node->name();
+    for (auto const &attr : node->attributeList()) {
+        if (attr.key == g_quark_from_static_string("id")) {
+            continue;
+        }
+        key += ' ';
+        key += g_quark_to_string(attr.key);
+        key += '=';
+        key += attr.value.pointer();
+        key += '\0';
+    }
+    key += '>';
+    for (auto child = node->firstChild(); child; child = child->next()) {
+        append_def_key(key, child);
+    }
+    key += '/';
+}
+
+/**
+ * Append a new clip path, gradient or pattern to <defs>, unless an identical one is there.
+ * Releases \a node.
+ * \return the node in <defs> to refer to.
+ */
+Inkscape::XML::Node *SvgBuilder::_addToDefs(Inkscape::XML::Node *node)
+{
+    auto &cache = *_defs_cache;
+
+    // Patterns are only comparable once their images are encoded.
+    _image_encoder->finish(node);
+
+    std::string key;
+    append_def_key(key, node);
+    auto const hash = std::hash<std::string>{}(key);
+
+    auto const [first, last] = cache.ids.equal_range(hash);
+    for (auto it = first; it != last;) {
+        // The document may have dropped it meanwhile.
+        auto existing = _doc->getObjectById(it->second);
+        if (!existing) {
+            cache.hashes.erase(it->second);
+            it = cache.ids.erase(it);
+            continue;
+        }
+        std::string existing_key;
+        append_def_key(existing_key, existing->getRepr());
+        if (existing_key == key) {
+            Inkscape::GC::release(node);
+            cache.shared.insert(it->second);
+            cache.reused++;
+            return existing->getRepr();
+        }
+        ++it;
+    }
+
+    _doc->getDefs()->getRepr()->appendChild(node);
+    Inkscape::GC::release(node);
+    if (auto id = node->attribute("id")) {
+        cache.hashes.emplace(id, hash);
+        cache.ids.emplace(hash, id);
+    }
+    return node;
+}
+
+/**
+ * Stop reusing \a node, before it is changed or removed.
+ */
+void SvgBuilder::_forgetDef(Inkscape::XML::Node *node)
+{
+    auto &cache = *_defs_cache;
+    if (auto id = node->attribute("id")) {
+        if (auto it = cache.hashes.find(id); it != cache.hashes.end()) {
+            auto const [first, last] = cache.ids.equal_range(it->second);
+            for (auto entry = first; entry != last; ++entry) {
+                if (entry->second == id) {
+                    cache.ids.erase(entry);
+                    break;
+                }
+            }
+            cache.hashes.erase(it);
+        }
+    }
+}
+
+/**
+ * Whether _addToDefs() handed out \a node more than once, so that it must not be changed.
+ */
+bool SvgBuilder::_isSharedDef(Inkscape::XML::Node *node) const
+{
+    auto id = node->attribute("id");
+    return id && _defs_cache->shared.count(id);
+}
+
 SvgBuilder::SvgBuilder(SPDocument *document, gchar *docname, XRef *xref)
 {
     _is_top_level = true;
@@ -81,6 +412,8 @@ SvgBuilder::SvgBuilder(SPDocument *document, gchar *docname, XRef *xref)
     // Set default preference settings
     _preferences = _xml_doc->createElement("svgbuilder:prefs");
     _preferences->setAttribute("embedImages", "1");
+    _image_encoder = std::make_shared<ImageEncoder>();
+    _defs_cache = std::make_shared<DefsCache>();
 }
 
 SvgBuilder::SvgBuilder(SvgBuilder *parent, Inkscape::XML::Node *root) {
@@ -90,12 +423,23 @@ SvgBuilder::SvgBuilder(SvgBuilder *parent, Inkscape::XML::Node *root) {
     _xref = parent->_xref;
     _xml_doc = parent->_xml_doc;
     _preferences = parent->_preferences;
+    _image_encoder = parent->_image_encoder;
+    _defs_cache = parent->_defs_cache;
     _container = this->_root = root;
     _init();
 }
 
 SvgBuilder::~SvgBuilder()
 {
+    if (_is_top_level) {
+        // All images have their data by the time the document is handed over.
+        _image_encoder->finish();
+
+        if (_defs_cache->reused) {
+            g_info("PDF import: %d clip paths, gradients and patterns were identical to earlier ones and reused.",
+                   _defs_cache->reused);
+        }
+    }
     if (_clip_history) {
         delete _clip_history;
         _clip_history = nullptr;
@@ -832,9 +1176,7 @@ Inkscape::XML::Node *SvgBuilder::_createClip(const std::string &d, const Geom::A
     Inkscape::GC::release(path);
 
     // Append clipPath to defs and get id
-    _doc->getDefs()->getRepr()->appendChild(clip_path);
-    Inkscape::GC::release(clip_path);
-    return clip_path;
+    return _addToDefs(clip_path);
 }
 
 void SvgBuilder::beginMarkedContent(const char *name, const char *group)
@@ -1053,11 +1395,8 @@ gchar *SvgBuilder::_createTilingPattern(GfxTilingPattern *tiling_pattern,
     delete pattern_builder;
 
     // Append the pattern to defs
-    _doc->getDefs()->getRepr()->appendChild(pattern_node);
-    gchar *id = g_strdup(pattern_node->attribute("id"));
-    Inkscape::GC::release(pattern_node);
-
-    return id;
+    pattern_node = _addToDefs(pattern_node);
+    return g_strdup(pattern_node->attribute("id"));
 }
 
 /**
@@ -1120,11 +1459,8 @@ gchar *SvgBuilder::_createGradient(GfxShading *shading, const Geom::Affine pat_m
         return nullptr;
     }
 
-    _doc->getDefs()->getRepr()->appendChild(gradient);
-    gchar *id = g_strdup(gradient->attribute("id"));
-    Inkscape::GC::release(gradient);
-
-    return id;
+    gradient = _addToDefs(gradient);
+    return g_strdup(gradient->attribute("id"));
 }
 
 #define EPSILON 0.0001
@@ -1802,100 +2138,26 @@ void SvgBuilder::endTextObject(GfxState *state)
     }
 }
 
-/**
- * Helper functions for supporting direct PNG output into a base64 encoded stream
- */
-void png_write_vector(png_structp png_ptr, png_bytep data, png_size_t length)
-{
-    auto *v_ptr = reinterpret_cast<std::vector<guchar> *>(png_get_io_ptr(png_ptr)); // Get pointer to stream
-    for ( unsigned i = 0 ; i < length ; i++ ) {
-        v_ptr->push_back(data[i]);
-    }
-}
-
 /**
  * \brief Creates an <image> element containing the given ImageStream as a PNG
  *
+ * The pixels are read from the stream here, but embedded images are compressed in the
+ * background; see ImageEncoder.
  */
 Inkscape::XML::Node *SvgBuilder::_createImage(Stream *str, int width, int height,
                                               GfxImageColorMap *color_map, bool interpolate,
                                               int *mask_colors, bool alpha_only,
                                               bool invert_alpha) {
 
-    // Create PNG write struct
-    png_structp png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
-    if ( png_ptr == nullptr ) {
-        return nullptr;
-    }
-    // Create PNG info struct
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if ( info_ptr == nullptr ) {
-        png_destroy_write_struct(&png_ptr, nullptr);
-        return nullptr;
-    }
-    // Set error handler
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        return nullptr;
-    }
     // Decide whether we should embed this image
     bool embed_image = _preferences->getAttributeBoolean("embedImages", true);
 
-    // Set read/write functions
-    std::vector<guchar> png_buffer;
-    FILE *fp = nullptr;
-    gchar *file_name = nullptr;
-    if (embed_image) {
-        png_set_write_fn(png_ptr, &png_buffer, png_write_vector, nullptr);
-    } else {
-        static int counter = 0;
-        file_name = g_strdup_printf("%s_img%d.png", _docname, counter++);
-        fp = fopen(file_name, "wb");
-        if ( fp == nullptr ) {
-            png_destroy_write_struct(&png_ptr, &info_ptr);
-            g_free(file_name);
-            return nullptr;
-        }
-        png_init_io(png_ptr, fp);
-    }
-
-    // Set header data
-    if ( !invert_alpha && !alpha_only ) {
-        png_set_invert_alpha(png_ptr);
-    }
-    png_color_8 sig_bit;
-    if (alpha_only) {
-        png_set_IHDR(png_ptr, info_ptr,
-                     width,
-                     height,
-                     8, /* bit_depth */
-                     PNG_COLOR_TYPE_GRAY,
-                     PNG_INTERLACE_NONE,
-                     PNG_COMPRESSION_TYPE_BASE,
-                     PNG_FILTER_TYPE_BASE);
-        sig_bit.red = 0;
-        sig_bit.green = 0;
-        sig_bit.blue = 0;
-        sig_bit.gray = 8;
-        sig_bit.alpha = 0;
-    } else {
-        png_set_IHDR(png_ptr, info_ptr,
-                     width,
-                     height,
-                     8, /* bit_depth */
-                     PNG_COLOR_TYPE_RGB_ALPHA,
-                     PNG_INTERLACE_NONE,
-                     PNG_COMPRESSION_TYPE_BASE,
-                     PNG_FILTER_TYPE_BASE);
-        sig_bit.red = 8;
-        sig_bit.green = 8;
-        sig_bit.blue = 8;
-        sig_bit.alpha = 8;
-    }
-    png_set_sBIT(png_ptr, info_ptr, &sig_bit);
-    png_set_bgr(png_ptr);
-    // Write the file header
-    png_write_info(png_ptr, info_ptr);
+    DecodedImage image;
+    image.width = width;
+    image.height = height;
+    image.alpha_only = alpha_only;
+    image.invert_alpha = invert_alpha;
+    auto const row_bytes = image.rowBytes();
 
     // Convert pixels
     ImageStream *image_stream;
@@ -1907,11 +2169,12 @@ Inkscape::XML::Node *SvgBuilder::_createImage(Stream *str, int width, int height
             image_stream = new ImageStream(str, width, 1, 1);
         }
         image_stream->reset();
+        image.pixels.resize(row_bytes * height);
 
         // Convert grayscale values
-        unsigned char *buffer = new unsigned char[width];
         int invert_bit = invert_alpha ? 1 : 0;
         for ( int y = 0 ; y < height ; y++ ) {
+            unsigned char *buffer = image.pixels.data() + y * row_bytes;
             unsigned char *row = image_stream->getLine();
             if (color_map) {
                 color_map->getGrayLine(row, buffer, width);
@@ -1925,14 +2188,13 @@ Inkscape::XML::Node *SvgBuilder::_createImage(Stream *str, int width, int height
                     }
                 }
             }
-            png_write_row(png_ptr, (png_bytep)buffer);
         }
-        delete [] buffer;
     } else if (color_map) {
         image_stream = new ImageStream(str, width,
                                        color_map->getNumPixelComps(),
                                        color_map->getBits());
         image_stream->reset();
+        image.pixels.resize(row_bytes * height);
 
         // Convert RGB values
         unsigned int *buffer = new unsigned int[width];
@@ -1955,32 +2217,40 @@ Inkscape::XML::Node *SvgBuilder::_createImage(Stream *str, int width, int height
                     row += color_map->getNumPixelComps();
                     dest++;
                 }
-                // Write it to the PNG
-                png_write_row(png_ptr, (png_bytep)buffer);
+                memcpy(image.pixels.data() + y * row_bytes, buffer, row_bytes);
             }
         } else {
             for ( int i = 0 ; i < height ; i++ ) {
                 unsigned char *row = image_stream->getLine();
                 memset((void*)buffer, 0xff, sizeof(int) * width);
                 color_map->getRGBLine(row, buffer, width);
-                png_write_row(png_ptr, (png_bytep)buffer);
+                memcpy(image.pixels.data() + i * row_bytes, buffer, row_bytes);
             }
         }
         delete [] buffer;
 
     } else {    // A colormap must be provided, so quit
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        if (!embed_image) {
-            fclose(fp);
-            g_free(file_name);
-        }
         return nullptr;
     }
     delete image_stream;
     str->close();
-    // Close PNG
-    png_write_end(png_ptr, info_ptr);
-    png_destroy_write_struct(&png_ptr, &info_ptr);
+
+    gchar *file_name = nullptr;
+    if (!embed_image) {
+        auto png_buffer = encode_png(image);
+        if (!png_buffer) {
+            return nullptr;
+        }
+        static int counter = 0;
+        file_name = g_strdup_printf("%s_img%d.png", _docname, counter++);
+        FILE *fp = fopen(file_name, "wb");
+        if ( fp == nullptr ) {
+            g_free(file_name);
+            return nullptr;
+        }
+        fwrite(png_buffer->data(), 1, png_buffer->size(), fp);
+        fclose(fp);
+    }
 
     // Create repr
     Inkscape::XML::Node *image_node = _xml_doc->createElement("svg:image");
@@ -1999,13 +2269,8 @@ Inkscape::XML::Node *SvgBuilder::_createImage(Stream *str, int width, int height
 
     // Create href
     if (embed_image) {
-        // Append format specification to the URI
-        auto *base64String = g_base64_encode(png_buffer.data(), png_buffer.size());
-        auto png_data = std::string("data:image/png;base64,") + base64String;
-        g_free(base64String);
-        image_node->setAttributeOrRemoveIfEmpty("xlink:href", png_data);
+        _image_encoder->add(image_node, std::move(image));
     } else {
-        fclose(fp);
         image_node->setAttribute("xlink:href", file_name);
         g_free(file_name);
     }
@@ -2180,8 +2445,9 @@ void SvgBuilder::applyOptionalMask(Inkscape::XML::Node *mask, Inkscape::XML::Nod
         auto source = mask->firstChild();
         auto source_gr = _getGradientNode(source, true);
         auto target_gr = _getGradientNode(target, true);
-        // Both objects have a gradient, try and merge them
-        if (source_gr && target_gr && source_gr->childCount() == target_gr->childCount()) {
+        // Both objects have a gradient, try and merge them, unless other objects use them too
+        if (source_gr && target_gr && source_gr->childCount() == target_gr->childCount() &&
+            !_isSharedDef(source_gr) && !_isSharedDef(target_gr)) {
             bool same_pos = _attrEqual(source_gr, target_gr, "x1") && _attrEqual(source_gr, target_gr, "x2")
                          && _attrEqual(source_gr, target_gr, "y1") && _attrEqual(source_gr, target_gr, "y2");
 
@@ -2196,6 +2462,9 @@ void SvgBuilder::applyOptionalMask(Inkscape::XML::Node *mask, Inkscape::XML::Nod
             }
 
             if (same_pos && white_mask) {
+                _forgetDef(source_gr);
+                _forgetDef(target_gr);
+
                 // We move the stop-opacity from the source to the target
                 auto target_st = target_gr->firstChild();
                 for (auto source_st = source_gr->firstChild(); source_st != nullptr; source_st = source_st->next()) {
@@ -177,6 +177,17 @@ public:
 private:
     void _init();
 
+    // Embedded images are compressed on a thread pool shared by all the builders of a document.
+    class ImageEncoder;
+    std::shared_ptr<ImageEncoder> _image_encoder;
+
+    // Definitions by content, shared by all the builders of a document.
+    class DefsCache;
+    std::shared_ptr<DefsCache> _defs_cache;
+    Inkscape::XML::Node *_addToDefs(Inkscape::XML::Node *node);
+    void _forgetDef(Inkscape::XML::Node *node);
+    bool _isSharedDef(Inkscape::XML::Node *node) const;
+
     // Pattern creation
     gchar *_createPattern(GfxPattern *pattern, GfxState *state, bool is_stroke=false);
     gchar *_createGradient(GfxShading *shading, const Geom::Affine pat_matrix, bool for_shading = false);
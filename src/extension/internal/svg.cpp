@@ -336,7 +336,8 @@ Svg::save(Inkscape::Extension::Output *mod, SPDocument *doc, gchar const *filena
 
     if (!sp_repr_save_rebased_file(doc->getReprDoc(), filename, SP_SVG_NS_URI,
                                    doc->getDocumentBase(),
-                                   m_detachbase ? nullptr : filename)) {
+                                   m_detachbase ? nullptr : filename,
+                                   doc->getSerializationCache())) {
         throw Inkscape::Extension::Output::save_failed();
     }
 }
@@ -0,0 +1,191 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Cache of what the .inx files found at startup describe, so that their extensions can be
+ * registered without reading them.
+ *
+ * Copyright (C) 2026 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "manifest.h"
+
+#include <cstring>
+#include <fstream>
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+
+#include "xml/repr.h"
+
+namespace Inkscape {
+namespace Extension {
+
+namespace {
+
+/// First line of the cache; change the version whenever the meaning of an entry changes.
+constexpr char const *MANIFEST_HEADER = "# Inkscape extension manifest 1";
+
+} // namespace
+
+Manifest::Manifest(std::string path)
+    : _path(std::move(path))
+{
+    std::ifstream file(_path);
+    std::string line;
+    if (!std::getline(file, line) || line != MANIFEST_HEADER) {
+        return;
+    }
+
+    // mtime, size, type, id and path, separated by tabs. The path comes last as it may contain
+    // anything but a line break.
+    while (std::getline(file, line)) {
+        std::string fields[4];
+        std::size_t start = 0;
+        bool valid = true;
+        for (auto &field : fields) {
+            auto const tab = line.find('\t', start);
+            if (tab == std::string::npos) {
+                valid = false;
+                break;
+            }
+            field = line.substr(start, tab - start);
+            start = tab + 1;
+        }
+        if (!valid) {
+            continue;
+        }
+
+        Record record;
+        record.mtime = g_ascii_strtoll(fields[0].c_str(), nullptr, 10);
+        record.size = g_ascii_strtoll(fields[1].c_str(), nullptr, 10);
+        auto const type = g_ascii_strtoll(fields[2].c_str(), nullptr, 10);
+        if (type < 0 || type >= MODULE_UNKNOWN_FUNC || fields[3].empty()) {
+            continue;
+        }
+        record.entry = {std::move(fields[3]), static_cast<ModuleFuncType>(type)};
+        _records.insert_or_assign(line.substr(start), std::move(record));
+    }
+}
+
+std::string Manifest::default_path()
+{
+    return Glib::build_filename(Glib::get_user_cache_dir(), "inkscape", "extension-manifest");
+}
+
+/**
+ * Read the ID and kind of module from an extension description, the same way that
+ * build_from_reprdoc() and the Extension constructor do.
+ */
+std::optional<Manifest::Entry> Manifest::read_entry(std::string const &filename)
+{
+    auto doc = sp_repr_read_file(filename.c_str(), INKSCAPE_EXTENSION_URI);
+    if (!doc) {
+        return {};
+    }
+
+    std::optional<Entry> entry;
+    auto repr = doc->root();
+    if (!strcmp(repr->name(), INKSCAPE_EXTENSION_NS "inkscape-extension")) {
+        Entry found{{}, MODULE_UNKNOWN_FUNC};
+        for (auto child = repr->firstChild(); child; child = child->next()) {
+            char const *name = child->name();
+            if (auto type = get_functional_type(name); type != MODULE_UNKNOWN_FUNC) {
+                found.type = type;
+            } else if (!strcmp(name, INKSCAPE_EXTENSION_NS "id") || !strcmp(name, INKSCAPE_EXTENSION_NS "_id")) {
+                if (child->firstChild() && child->firstChild()->content()) {
+                    found.id = child->firstChild()->content();
+                }
+            }
+        }
+        // Extensions of unknown kind are built right away, which warns about them.
+        if (!found.id.empty() && found.type != MODULE_UNKNOWN_FUNC) {
+            entry = std::move(found);
+        }
+    }
+
+    Inkscape::GC::release(doc);
+    return entry;
+}
+
+std::optional<Manifest::Entry> Manifest::lookup(std::string const &filename)
+{
+    GStatBuf st;
+    if (g_stat(filename.c_str(), &st) != 0) {
+        return {};
+    }
+
+    auto it = _records.find(filename);
+    if (it == _records.end() || it->second.mtime != st.st_mtime || it->second.size != st.st_size) {
+        auto entry = read_entry(filename);
+        if (!entry) {
+            if (it != _records.end()) {
+                _records.erase(it);
+                _modified = true;
+            }
+            return {};
+        }
+        Record record;
+        record.mtime = st.st_mtime;
+        record.size = st.st_size;
+        record.entry = std::move(*entry);
+        it = _records.insert_or_assign(filename, std::move(record)).first;
+        _modified = true;
+    }
+
+    it->second.used = true;
+    return it->second.entry;
+}
+
+void Manifest::save()
+{
+    for (auto it = _records.begin(); it != _records.end();) {
+        if (it->second.used) {
+            ++it;
+        } else {
+            // The file has gone, or is no longer searched for extensions.
+            it = _records.erase(it);
+            _modified = true;
+        }
+    }
+    if (!_modified) {
+        return;
+    }
+
+    g_mkdir_with_parents(Glib::path_get_dirname(_path).c_str(), 0755);
+    auto const tmp_path = _path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        file << MANIFEST_HEADER << '\n';
+        for (auto const &[filename, record] : _records) {
+            if (filename.find('\n') != std::string::npos || record.entry.id.find_first_of("\t\n") != std::string::npos) {
+                continue;
+            }
+            file << record.mtime << '\t' << record.size << '\t' << static_cast<int>(record.entry.type) << '\t'
+                 << record.entry.id << '\t' << filename << '\n';
+        }
+        if (!file.flush()) {
+            g_warning("Could not write the extension manifest '%s'", tmp_path.c_str());
+            return;
+        }
+    }
+    if (g_rename(tmp_path.c_str(), _path.c_str()) != 0) {
+        g_warning("Could not write the extension manifest '%s'", _path.c_str());
+        g_unlink(tmp_path.c_str());
+        return;
+    }
+    _modified = false;
+}
+
+} // namespace Extension
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
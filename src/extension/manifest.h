@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Cache of what the .inx files found at startup describe, so that their extensions can be
+ * registered without reading them.
+ *
+ * Copyright (C) 2026 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_EXTENSION_MANIFEST_H
+#define INKSCAPE_EXTENSION_MANIFEST_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "extension.h"
+
+namespace Inkscape {
+namespace Extension {
+
+/**
+ * The ID and kind of module of every extension description file, as needed to register the
+ * extension with DB::defer().
+ *
+ * Each entry is keyed by the modification time and size of its file, so editing, adding or
+ * removing a file only costs reading that file again. The cache is a small text file in the
+ * user's cache directory.
+ */
+class Manifest
+{
+public:
+    struct Entry
+    {
+        std::string id;
+        ModuleFuncType type;
+    };
+
+    /// Load the cache from \a path; a missing or unreadable cache starts out empty.
+    explicit Manifest(std::string path);
+
+    /**
+     * The ID and kind of the extension described in \a filename. The file is only read if the
+     * cache has no current entry for it.
+     *
+     * @return Nothing if the file doesn't describe a usable extension; building it reports why.
+     */
+    std::optional<Entry> lookup(std::string const &filename);
+
+    /// Write the cache back if it changed, keeping only the files that were looked up.
+    void save();
+
+    /// The cache in the user's cache directory.
+    static std::string default_path();
+
+private:
+    struct Record
+    {
+        std::int64_t mtime = 0;
+        std::int64_t size = 0;
+        Entry entry;
+        bool used = false;
+    };
+
+    static std::optional<Entry> read_entry(std::string const &filename);
+
+    std::string _path;
+    std::unordered_map<std::string, Record> _records;
+    bool _modified = false;
+};
+
+} // namespace Extension
+} // namespace Inkscape
+
+#endif // INKSCAPE_EXTENSION_MANIFEST_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -296,6 +296,30 @@ get_print(gchar const *key)
     return dynamic_cast<Print *>(db.get(key));
 }
 
+/**
+ * \return   The kind of module that an element of its XML description makes it, or
+ *           MODULE_UNKNOWN_FUNC if the element is about something else.
+ * \param    element_name  Qualified name of a child of the <inkscape-extension> element.
+ */
+ModuleFuncType
+get_functional_type(char const *element_name)
+{
+    if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "input")) {
+        return MODULE_INPUT;
+    } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "template")) {
+        return MODULE_TEMPLATE;
+    } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "output")) {
+        return MODULE_OUTPUT;
+    } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "effect")) {
+        return MODULE_FILTER;
+    } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "print")) {
+        return MODULE_PRINT;
+    } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "path-effect")) {
+        return MODULE_PATH_EFFECT;
+    }
+    return MODULE_UNKNOWN_FUNC;
+}
+
 /**
  * \return   true if extension successfully parsed, false otherwise
  *           A true return value does not guarantee an extension was actually registered,
@@ -332,18 +356,8 @@ build_from_reprdoc(Inkscape::XML::Document *doc, std::unique_ptr<Implementation:
     while (child_repr != nullptr) {
         char const *element_name = child_repr->name();
         /* printf("Child: %s\n", child_repr->name()); */
-        if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "input")) {
-            module_functional_type = MODULE_INPUT;
-        } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "template")) {
-            module_functional_type = MODULE_TEMPLATE;
-        } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "output")) {
-            module_functional_type = MODULE_OUTPUT;
-        } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "effect")) {
-            module_functional_type = MODULE_FILTER;
-        } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "print")) {
-            module_functional_type = MODULE_PRINT;
-        } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "path-effect")) {
-            module_functional_type = MODULE_PATH_EFFECT;
+        if (auto type = get_functional_type(element_name); type != MODULE_UNKNOWN_FUNC) {
+            module_functional_type = type;
         } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "script")) {
             module_implementation_type = MODULE_EXTENSION;
         } else if (!strcmp(element_name, INKSCAPE_EXTENSION_NS "xslt")) {
@@ -21,7 +21,6 @@
 #include "display/drawing.h"
 #include "helper/pixbuf-ops.h"
 #include "object/sp-root.h"
-#include "util/scope_exit.h"
 #include "util/units.h"
 
 /**
@@ -41,52 +40,72 @@ Inkscape::Pixbuf *sp_generate_internal_bitmap(SPDocument *document,
                                               uint32_t const *checkerboard_color,
                                               double device_scale)
 {
-    // Geometry
     if (area.hasZeroArea()) {
         return nullptr;
     }
 
+    return InternalBitmapDrawing(document, area, dpi, items, opaque).render(checkerboard_color, device_scale);
+}
+
+InternalBitmapDrawing::InternalBitmapDrawing(SPDocument *document, Geom::Rect const &area, double dpi,
+                                             std::vector<SPItem const *> const &items, bool opaque)
+    : _document(document)
+    , _drawing(std::make_unique<Inkscape::Drawing>()) // New drawing for offscreen rendering.
+{
+    // Geometry
     Geom::Point origin = area.min();
     double scale_factor = Inkscape::Util::Quantity::convert(dpi, "px", "in");
     Geom::Affine affine = Geom::Translate(-origin) * Geom::Scale (scale_factor, scale_factor);
 
     int width  = std::ceil(scale_factor * area.width());
     int height = std::ceil(scale_factor * area.height());
+    _area = Geom::IntRect::from_xywh(0, 0, width, height);
 
     // Document
     document->ensureUpToDate();
-    unsigned dkey = SPItem::display_key_new(1);
+    _dkey = SPItem::display_key_new(1);
 
     // Drawing
-    Inkscape::Drawing drawing; // New drawing for offscreen rendering.
-    drawing.setRoot(document->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
-    auto invoke_hide_guard = scope_exit([&] { document->getRoot()->invoke_hide(dkey); });
+    auto &drawing = *_drawing;
+    drawing.setRoot(document->getRoot()->invoke_show(drawing, _dkey, SP_ITEM_SHOW_DISPLAY));
     drawing.root()->setTransform(affine);
     drawing.setExact(); // Maximum quality for blurs.
 
     // Hide all items we don't want, instead of showing only requested items,
     // because that would not work if the shown item references something in defs.
     if (!items.empty()) {
-        document->getRoot()->invoke_hide_except(dkey, items);
+        document->getRoot()->invoke_hide_except(_dkey, items);
     }
 
-    auto final_area = Geom::IntRect::from_xywh(0, 0, width, height);
-    drawing.update(final_area);
+    drawing.update(_area);
 
     if (opaque) {
         // Required by sp_asbitmap_render().
         for (auto item : items) {
-            if (item->get_arenaitem(dkey)) {
-                item->get_arenaitem(dkey)->setOpacity(1.0);
+            if (item->get_arenaitem(_dkey)) {
+                item->get_arenaitem(_dkey)->setOpacity(1.0);
             }
         }
     }
 
+    // Changes to the document are held back until the drawing is gone, so that render() only
+    // ever sees this state.
+    drawing.snapshot();
+}
+
+InternalBitmapDrawing::~InternalBitmapDrawing()
+{
+    _drawing->unsnapshot();
+    _document->getRoot()->invoke_hide(_dkey);
+}
+
+Inkscape::Pixbuf *InternalBitmapDrawing::render(uint32_t const *checkerboard_color, double device_scale) const
+{
     // Rendering
-    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, _area.width(), _area.height());
 
     if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
-        long long size = (long long)height * (long long)cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, width);
+        long long size = (long long)_area.height() * (long long)cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, _area.width());
         g_warning("sp_generate_internal_bitmap: not enough memory to create pixel buffer. Need %lld.", size);
         cairo_surface_destroy(surface);
         return nullptr;
@@ -106,7 +125,7 @@ Inkscape::Pixbuf *sp_generate_internal_bitmap(SPDocument *document,
     }
 
     // render items
-    drawing.render(dc, final_area, Inkscape::DrawingItem::RENDER_BYPASS_CACHE);
+    _drawing->render(dc, _area, Inkscape::DrawingItem::RENDER_BYPASS_CACHE);
 
     if (device_scale != 1.0) {
         cairo_surface_set_device_scale(surface, device_scale, device_scale);
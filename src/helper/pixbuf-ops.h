@@ -13,13 +13,18 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <memory>
 #include <vector>
 #include <cstdint>
 #include <2geom/forward.h>
+#include <2geom/rect.h>
 
 class SPDocument;
 class SPItem;
-namespace Inkscape { class Pixbuf; }
+namespace Inkscape {
+class Drawing;
+class Pixbuf;
+} // namespace Inkscape
 
 Inkscape::Pixbuf *sp_generate_internal_bitmap(SPDocument *document,
                                               Geom::Rect const &area,
@@ -28,4 +33,30 @@ Inkscape::Pixbuf *sp_generate_internal_bitmap(SPDocument *document,
                                               bool set_opaque = false,
                                               uint32_t const *checkerboard_color = nullptr,
                                               double device_scale = 1.0);
+
+/**
+ * The drawing that sp_generate_internal_bitmap() renders, split off so that the rendering can
+ * run on another thread. Construction and destruction show and hide the document's items, so
+ * they belong on the thread that owns the document; render() may be called from any thread
+ * while the drawing is alive.
+ */
+class InternalBitmapDrawing
+{
+public:
+    InternalBitmapDrawing(SPDocument *document, Geom::Rect const &area, double dpi,
+                          std::vector<SPItem const *> const &items = {}, bool set_opaque = false);
+    ~InternalBitmapDrawing();
+    InternalBitmapDrawing(InternalBitmapDrawing const &) = delete;
+    InternalBitmapDrawing &operator=(InternalBitmapDrawing const &) = delete;
+
+    /// Render the bitmap; nullptr if there is not enough memory for it.
+    Inkscape::Pixbuf *render(uint32_t const *checkerboard_color = nullptr, double device_scale = 1.0) const;
+
+private:
+    SPDocument *_document;
+    unsigned _dkey = 0;
+    Geom::IntRect _area;
+    std::unique_ptr<Inkscape::Drawing> _drawing;
+};
+
 #endif // INKSCAPE_HELPER_PIXBUF_OPS_H
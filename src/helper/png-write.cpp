@@ -15,10 +15,23 @@
  */
 
 
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <2geom/rect.h>
 #include <2geom/transforms.h>
 
 #include <png.h>
+#include <zlib.h>
 
 #include "document.h"
 #include "png-write.h"
@@ -36,6 +49,8 @@
 
 #include "ui/interface.h"
 
+#include "util/threading.h"
+
 /* This is an example of how to use libpng to read and write PNG files.
  * The file libpng.txt is much more verbose then this.  If you have not
  * read it, do so first.  This was designed to be a starting point of an
@@ -52,9 +67,11 @@ struct SPEBP {
     unsigned long int width, height, sheight;
     guint32 background;
     Inkscape::Drawing *drawing; // it is assumed that all unneeded items are hidden
-    guchar *px;
     unsigned (*status)(float, void *);
     void *data;
+    boost::asio::thread_pool *pool; // renders and compresses stripes if set
+    int num_threads;
+    bool striped_deflate; // compress stripes independently, see sp_png_write_idat_striped()
 };
 
 /* write a png file */
@@ -120,96 +137,384 @@ void PngTextList::add(gchar const* key, gchar const* text)
     }
 }
 
-static bool
-sp_png_write_rgba_striped(SPDocument *doc,
-                          gchar const *filename, unsigned long int width, unsigned long int height, double xdpi, double ydpi,
-                          int (* get_rows)(guchar const **rows, void **to_free, int row, int num_rows, void *data, int color_type, int bit_depth),
-                          void *data, bool interlace, int color_type, int bit_depth, int zlib)
+namespace {
+
+/// The rows of a rendered stripe, in the pixel format of the PNG file.
+struct Stripe
 {
-    g_return_val_if_fail(filename != nullptr, false);
-    g_return_val_if_fail(data != nullptr, false);
+    Stripe() = default;
+    Stripe(Stripe const &) = delete;
+    Stripe &operator=(Stripe const &) = delete;
+    ~Stripe() { free(const_cast<guchar *>(data)); }
+
+    int row = 0;
+    guchar const *data = nullptr;
+    std::vector<guchar const *> rows;
+};
 
-    struct SPEBP *ebp = (struct SPEBP *) data;
-    FILE *fp;
-    png_structp png_ptr;
-    png_infop info_ptr;
-    png_color_8 sig_bit;
-    png_uint_32 r;
+/// A stripe compressed into a part of the zlib stream of the IDAT chunks.
+struct CompressedStripe
+{
+    std::vector<unsigned char> data;
+    uLong adler = 0;   ///< Adler-32 checksum of the uncompressed bytes.
+    uLong length = 0;  ///< Number of uncompressed bytes.
+    bool ok = true;
+};
 
-    /* open the file */
+/// Key and text of the text chunks of a PNG file.
+using PngText = std::vector<std::pair<std::string, std::string>>;
 
-    Inkscape::IO::dump_fopen_call(filename, "M");
-    fp = Inkscape::IO::fopen_utf8name(filename, "wb");
-    if(fp == nullptr) return false;
+/// Thrown by libpng errors, so that stripes being rendered are waited for while unwinding.
+struct PngError : std::runtime_error
+{
+    using std::runtime_error::runtime_error;
+};
 
-    /* Create and initialize the png_struct with the desired error handler
-     * functions.  If you want to use the default stderr and longjump method,
-     * you can supply NULL for the last three parameters.  We also check that
-     * the library version is compatible with the one used at compile time,
-     * in case we are using dynamically linked libraries.  REQUIRED.
-     */
-    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+[[noreturn]] void throw_png_error(png_structp, png_const_charp message)
+{
+    throw PngError(message);
+}
 
-    if (png_ptr == nullptr) {
-        fclose(fp);
-        return false;
+template <typename F>
+auto post_task(boost::asio::thread_pool &pool, F &&f)
+{
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(f));
+    auto future = task->get_future();
+    boost::asio::post(pool, [task] { (*task)(); });
+    return future;
+}
+
+} // namespace
+
+/**
+ * Render the rows starting at \a row. The drawing must be up to date and snapshotted, as this
+ * is called concurrently for different stripes when rendering on a thread pool.
+ */
+static std::unique_ptr<Stripe>
+sp_export_render_stripe(SPEBP const &ebp, int row, int num_rows, int color_type, int bit_depth)
+{
+    auto stripe = std::make_unique<Stripe>();
+    stripe->row = row;
+    stripe->rows.resize(num_rows);
+
+    /* Set area of interest */
+    // bbox is now set to the entire image to prevent discontinuities
+    // in the image when blur is used (the borders may still be a bit
+    // off, but that's less noticeable).
+    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp.width, num_rows);
+
+    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp.width);
+    unsigned char *px = g_new(guchar, num_rows * stride);
+
+    cairo_surface_t *s = cairo_image_surface_create_for_data(
+        px, CAIRO_FORMAT_ARGB32, ebp.width, num_rows, stride);
+    Inkscape::DrawingContext dc(s, bbox.min());
+    dc.setSource(ebp.background);
+    dc.setOperator(CAIRO_OPERATOR_SOURCE);
+    dc.paint();
+    dc.setOperator(CAIRO_OPERATOR_OVER);
+
+    /* Render */
+    ebp.drawing->render(dc, bbox, 0);
+    cairo_surface_destroy(s);
+
+    // PNG stores data as unpremultiplied big-endian RGBA, which means
+    // it's identical to the GdkPixbuf format.
+    convert_pixels_argb32_to_pixbuf(px, ebp.width, num_rows, stride,
+                                    /* RGBA to ARGB with A=0 */ ebp.background >> 8);
+
+    // If a custom bit depth or color type is asked, then convert rgb to grayscale, etc.
+    stripe->data = pixbuf_to_png(stripe->rows.data(), px, num_rows, ebp.width, stride, color_type, bit_depth);
+    g_free(px);
+
+    return stripe;
+}
+
+/**
+ * Hands out the rendered stripes of an export in order. With a thread pool, a bounded number
+ * of stripes ahead of the consumer is rendered concurrently; otherwise each stripe is rendered
+ * on demand.
+ */
+class StripeRenderer
+{
+public:
+    StripeRenderer(SPEBP &ebp, int color_type, int bit_depth)
+        : _ebp(ebp)
+        , _color_type(color_type)
+        , _bit_depth(bit_depth)
+    {}
+
+    ~StripeRenderer() { cancel(); }
+
+    /// The next stripe, or null once all rows were handed out or the export was cancelled.
+    std::unique_ptr<Stripe> next()
+    {
+        if (_next_row >= _ebp.height && _pending.empty()) {
+            return {};
+        }
+
+        if (_ebp.status && !_ebp.status(static_cast<float>(_consumed_row) / _ebp.height, _ebp.data)) {
+            cancel();
+            _cancelled = true;
+            return {};
+        }
+
+        std::unique_ptr<Stripe> stripe;
+        if (!_ebp.pool) {
+            auto const row = static_cast<int>(_next_row);
+            auto const num_rows = _advance();
+            stripe = sp_export_render_stripe(_ebp, row, num_rows, _color_type, _bit_depth);
+        } else {
+            // Keep every thread busy, plus one stripe of slack per thread.
+            while (_next_row < _ebp.height && _pending.size() < 2 * static_cast<std::size_t>(_ebp.num_threads)) {
+                auto const row = static_cast<int>(_next_row);
+                auto const num_rows = _advance();
+                _pending.push_back(post_task(*_ebp.pool, [this, row, num_rows] {
+                    return sp_export_render_stripe(_ebp, row, num_rows, _color_type, _bit_depth);
+                }));
+            }
+            stripe = _pending.front().get();
+            _pending.pop_front();
+        }
+
+        _consumed_row = stripe->row + stripe->rows.size();
+        return stripe;
     }
 
-    /* Allocate/initialize the image information data.  REQUIRED */
-    info_ptr = png_create_info_struct(png_ptr);
-    if (info_ptr == nullptr) {
-        fclose(fp);
-        png_destroy_write_struct(&png_ptr, nullptr);
-        return false;
+    bool cancelled() const { return _cancelled; }
+
+private:
+    int _advance()
+    {
+        auto const num_rows = std::min(_ebp.sheight, _ebp.height - _next_row);
+        _next_row += num_rows;
+        return static_cast<int>(num_rows);
     }
 
-    /* Set error handling.  REQUIRED if you aren't supplying your own
-     * error handling functions in the png_create_write_struct() call.
-     */
-    if (setjmp(png_jmpbuf(png_ptr))) {
-        // If we get here, we had a problem reading the file
-        fclose(fp);
-        png_destroy_write_struct(&png_ptr, &info_ptr);
-        return false;
+    void cancel()
+    {
+        // The tasks refer to this object and the drawing, so they must finish first.
+        for (auto &future : _pending) {
+            future.wait();
+        }
+        _pending.clear();
+        _next_row = _ebp.height;
     }
 
-    /* set up the output control if you are using standard C streams */
-    png_init_io(png_ptr, fp);
+    SPEBP &_ebp;
+    int _color_type;
+    int _bit_depth;
+    unsigned long _next_row = 0;
+    unsigned long _consumed_row = 0;
+    std::deque<std::future<std::unique_ptr<Stripe>>> _pending;
+    bool _cancelled = false;
+};
 
-    /* Set the image information here.  Width and height are up to 2^31,
-     * bit_depth is one of 1, 2, 4, 8, or 16, but valid values also depend on
-     * the color_type selected. color_type is one of PNG_COLOR_TYPE_GRAY,
-     * PNG_COLOR_TYPE_GRAY_ALPHA, PNG_COLOR_TYPE_PALETTE, PNG_COLOR_TYPE_RGB,
-     * or PNG_COLOR_TYPE_RGB_ALPHA.  interlace is either PNG_INTERLACE_NONE or
-     * PNG_INTERLACE_ADAM7, and the compression_type and filter_type MUST
-     * currently be PNG_COMPRESSION_TYPE_BASE and PNG_FILTER_TYPE_BASE. REQUIRED
-     */
+static int png_paeth_predictor(int a, int b, int c)
+{
+    int const p = a + b - c;
+    int const pa = std::abs(p - a);
+    int const pb = std::abs(p - b);
+    int const pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return a;
+    if (pb <= pc) return b;
+    return c;
+}
 
-    png_set_compression_level(png_ptr, zlib);
+/**
+ * Filter a row into \a out (filter type byte followed by the filtered bytes), choosing the
+ * filter with the smallest sum of absolute differences like libpng does by default.
+ *
+ * \param prev The previous row, or null for the first row of the image.
+ */
+static void png_filter_row(guchar const *row, guchar const *prev, std::size_t rowbytes, std::size_t bpp,
+                           bool adaptive, unsigned char *out)
+{
+    auto const filter = [&] (int type, unsigned char *dst) {
+        unsigned long sum = 0;
+        for (std::size_t i = 0; i < rowbytes; ++i) {
+            int const x = row[i];
+            int const a = i >= bpp ? row[i - bpp] : 0;
+            int const b = prev ? prev[i] : 0;
+            int const c = prev && i >= bpp ? prev[i - bpp] : 0;
+            int predictor = 0;
+            switch (type) {
+                case 1: predictor = a; break;
+                case 2: predictor = b; break;
+                case 3: predictor = (a + b) / 2; break;
+                case 4: predictor = png_paeth_predictor(a, b, c); break;
+                default: break;
+            }
+            auto const v = static_cast<unsigned char>(x - predictor);
+            dst[i] = v;
+            sum += v < 128 ? v : 256 - v;
+        }
+        return sum;
+    };
 
-    png_set_IHDR(png_ptr, info_ptr,
-                 width,
-                 height,
-                 bit_depth,
-                 color_type,
-                 interlace ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
-                 PNG_COMPRESSION_TYPE_BASE,
-                 PNG_FILTER_TYPE_BASE);
+    out[0] = 0;
+    if (!adaptive) {
+        filter(0, out + 1);
+        return;
+    }
 
-    if ((color_type&2) && bit_depth == 16) {
-        // otherwise, if we are dealing with a color image then
-        sig_bit.red = 8;
-        sig_bit.green = 8;
-        sig_bit.blue = 8;
-        // if the image has an alpha channel then
-        if (color_type&4)
-            sig_bit.alpha = 8;
-        png_set_sBIT(png_ptr, info_ptr, &sig_bit);
+    std::vector<unsigned char> candidate(rowbytes);
+    unsigned long best = filter(0, out + 1);
+    for (int type = 1; type <= 4; ++type) {
+        auto const sum = filter(type, candidate.data());
+        if (sum < best) {
+            best = sum;
+            out[0] = type;
+            std::copy(candidate.begin(), candidate.end(), out + 1);
+        }
     }
+}
 
-    PngTextList textList;
+/**
+ * Filter and deflate a stripe into an independent part of the image's zlib stream. All parts
+ * but the last end with a sync flush, so they can be concatenated into a single stream.
+ */
+static CompressedStripe png_compress_stripe(Stripe const &stripe, std::vector<guchar> const &prev_row,
+                                            std::size_t rowbytes, std::size_t bpp, bool adaptive, int level,
+                                            bool last)
+{
+    CompressedStripe result;
 
-    textList.add("Software", "www.inkscape.org"); // Made by Inkscape comment
+    std::vector<unsigned char> filtered((rowbytes + 1) * stripe.rows.size());
+    guchar const *prev = prev_row.empty() ? nullptr : prev_row.data();
+    for (std::size_t i = 0; i < stripe.rows.size(); ++i) {
+        png_filter_row(stripe.rows[i], prev, rowbytes, bpp, adaptive, filtered.data() + i * (rowbytes + 1));
+        prev = stripe.rows[i];
+    }
+    result.length = filtered.size();
+    result.adler = adler32(adler32(0, nullptr, 0), filtered.data(), filtered.size());
+
+    z_stream zs{};
+    if (deflateInit2(&zs, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        result.ok = false;
+        return result;
+    }
+    result.data.resize(deflateBound(&zs, filtered.size()) + 16);
+    zs.next_in = filtered.data();
+    zs.avail_in = filtered.size();
+    zs.next_out = result.data.data();
+    zs.avail_out = result.data.size();
+    int const flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true) {
+        int const ret = deflate(&zs, flush);
+        if (ret == Z_STREAM_END || ((ret == Z_OK || ret == Z_BUF_ERROR) && !last && zs.avail_out > 0)) {
+            break; // All input consumed and flushed.
+        }
+        if (ret != Z_OK && ret != Z_BUF_ERROR) {
+            result.ok = false;
+            break;
+        }
+        auto const used = result.data.size() - zs.avail_out;
+        result.data.resize(result.data.size() * 2);
+        zs.next_out = result.data.data() + used;
+        zs.avail_out = result.data.size() - used;
+    }
+    result.data.resize(zs.total_out);
+    deflateEnd(&zs);
+    return result;
+}
+
+/**
+ * Write the image data of a non-interlaced PNG as a zlib stream assembled from independently
+ * deflated stripes, so they can be rendered and compressed concurrently on the thread pool.
+ * The pixels are the same as with libpng, only the compressed bytes differ. Without a pool the
+ * stripes are compressed one after the other into the very same bytes.
+ *
+ * \return false if cancelled or on error.
+ */
+static bool sp_png_write_idat_striped(png_structp png_ptr, SPEBP &ebp, int color_type, int bit_depth, int zlib)
+{
+    int const channels = 1 + (color_type & 2) + (color_type & 4) / 4;
+    std::size_t const rowbytes = (channels * bit_depth * ebp.width + 7) / 8;
+    std::size_t const bpp = std::max(1, channels * bit_depth / 8);
+    // Like libpng, only filter images of at least 8 bits per sample.
+    bool const adaptive = bit_depth >= 8 && zlib > 0;
+
+    // zlib header (RFC 1950): deflate with a 32K window, then the compression level and check bits.
+    int const flevel = zlib < 2 ? 0 : zlib < 6 ? 1 : zlib == 6 ? 2 : 3;
+    unsigned const cmf = 0x78;
+    unsigned flg = flevel << 6;
+    flg += 31 - (cmf * 256 + flg) % 31;
+    unsigned char const header[2] = {static_cast<unsigned char>(cmf), static_cast<unsigned char>(flg)};
+    png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IDAT"), header, sizeof(header));
+
+    StripeRenderer renderer(ebp, color_type, bit_depth);
+    std::deque<std::future<CompressedStripe>> pending;
+    std::vector<guchar> prev_row;
+    uLong adler = adler32(0, nullptr, 0);
+    bool ok = true;
+
+    auto const write_next = [&] {
+        auto block = pending.front().get();
+        pending.pop_front();
+        if (!block.ok) {
+            ok = false;
+            return;
+        }
+        adler = adler32_combine(adler, block.adler, block.length);
+        png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IDAT"), block.data.data(), block.data.size());
+    };
+
+    try {
+        while (auto stripe = renderer.next()) {
+            bool const last = stripe->row + stripe->rows.size() >= ebp.height;
+            auto prev = prev_row;
+            prev_row.assign(stripe->rows.back(), stripe->rows.back() + rowbytes);
+            if (!ebp.pool) {
+                std::promise<CompressedStripe> block;
+                block.set_value(png_compress_stripe(*stripe, prev, rowbytes, bpp, adaptive, zlib, last));
+                pending.push_back(block.get_future());
+            } else {
+                pending.push_back(post_task(*ebp.pool, [stripe = std::move(stripe), prev = std::move(prev),
+                                                         rowbytes, bpp, adaptive, zlib, last] {
+                    return png_compress_stripe(*stripe, prev, rowbytes, bpp, adaptive, zlib, last);
+                }));
+            }
+            while (ok && pending.size() > static_cast<std::size_t>(ebp.num_threads)) {
+                write_next();
+            }
+        }
+        while (!pending.empty()) {
+            if (ok) {
+                write_next();
+            } else {
+                pending.front().wait();
+                pending.pop_front();
+            }
+        }
+    } catch (...) {
+        // The renderer waits for its own stripes when destroyed; the compressed ones are drained here.
+        for (auto &block : pending) {
+            block.wait();
+        }
+        throw;
+    }
+
+    if (!ok || renderer.cancelled()) {
+        return false;
+    }
+
+    unsigned char const trailer[4] = {
+        static_cast<unsigned char>(adler >> 24), static_cast<unsigned char>(adler >> 16),
+        static_cast<unsigned char>(adler >> 8), static_cast<unsigned char>(adler)};
+    png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IDAT"), trailer, sizeof(trailer));
+    return true;
+}
+
+/**
+ * The text chunks of a PNG export of \a doc, taken from its metadata. Read on the main thread,
+ * as exports may be written while later ones of the same document are set up.
+ */
+static PngText sp_png_document_text(SPDocument *doc)
+{
+    PngText text;
+
+    text.emplace_back("Software", "www.inkscape.org"); // Made by Inkscape comment
     {
         const gchar* pngToDc[] = {"Title", "title",
                                "Author", "creator",
@@ -226,7 +531,7 @@ sp_png_write_rgba_striped(SPDocument *doc,
             if (entity) {
                 gchar const* data = rdf_get_work_entity(doc, entity);
                 if (data && *data) {
-                    textList.add(pngToDc[i], data);
+                    text.emplace_back(pngToDc[i], data);
                 }
             } else {
                 g_warning("Unable to find entity [%s]", pngToDc[i + 1]);
@@ -237,16 +542,68 @@ sp_png_write_rgba_striped(SPDocument *doc,
         struct rdf_license_t *license =  rdf_get_license(doc, true);
         if (license) {
             if (license->name && license->uri) {
-                gchar* tmp = g_strdup_printf("%s %s", license->name, license->uri);
-                textList.add("Copyright", tmp);
-                g_free(tmp);
+                text.emplace_back("Copyright", std::string(license->name) + " " + license->uri);
             } else if (license->name) {
-                textList.add("Copyright", license->name);
+                text.emplace_back("Copyright", license->name);
             } else if (license->uri) {
-                textList.add("Copyright", license->uri);
+                text.emplace_back("Copyright", license->uri);
             }
         }
     }
+
+    return text;
+}
+
+/**
+ * Write the chunks of the PNG file set up in \a png_ptr to \a fp. Errors of libpng are thrown as
+ * PngError.
+ */
+static bool
+sp_png_write_image(png_structp png_ptr, png_infop info_ptr, FILE *fp, PngText const &text,
+                   unsigned long int width, unsigned long int height, double xdpi, double ydpi,
+                   SPEBP &ebp, bool interlace, int color_type, int bit_depth, int zlib)
+{
+    png_color_8 sig_bit;
+    png_uint_32 r;
+
+    /* set up the output control if you are using standard C streams */
+    png_init_io(png_ptr, fp);
+
+    /* Set the image information here.  Width and height are up to 2^31,
+     * bit_depth is one of 1, 2, 4, 8, or 16, but valid values also depend on
+     * the color_type selected. color_type is one of PNG_COLOR_TYPE_GRAY,
+     * PNG_COLOR_TYPE_GRAY_ALPHA, PNG_COLOR_TYPE_PALETTE, PNG_COLOR_TYPE_RGB,
+     * or PNG_COLOR_TYPE_RGB_ALPHA.  interlace is either PNG_INTERLACE_NONE or
+     * PNG_INTERLACE_ADAM7, and the compression_type and filter_type MUST
+     * currently be PNG_COMPRESSION_TYPE_BASE and PNG_FILTER_TYPE_BASE. REQUIRED
+     */
+
+    png_set_compression_level(png_ptr, zlib);
+
+    png_set_IHDR(png_ptr, info_ptr,
+                 width,
+                 height,
+                 bit_depth,
+                 color_type,
+                 interlace ? PNG_INTERLACE_ADAM7 : PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_BASE,
+                 PNG_FILTER_TYPE_BASE);
+
+    if ((color_type&2) && bit_depth == 16) {
+        // otherwise, if we are dealing with a color image then
+        sig_bit.red = 8;
+        sig_bit.green = 8;
+        sig_bit.blue = 8;
+        // if the image has an alpha channel then
+        if (color_type&4)
+            sig_bit.alpha = 8;
+        png_set_sBIT(png_ptr, info_ptr, &sig_bit);
+    }
+
+    PngTextList textList;
+    for (auto const &[key, value] : text) {
+        textList.add(key.c_str(), value.c_str());
+    }
     if (textList.getCount() > 0) {
         png_set_text(png_ptr, info_ptr, textList.getPtext(), textList.getCount());
     }
@@ -279,95 +636,100 @@ sp_png_write_rgba_striped(SPDocument *doc,
      * use the first method if you aren't handling interlacing yourself.
      */
 
-    png_bytep* row_pointers = new png_bytep[ebp->sheight];
-    int number_of_passes = interlace ? png_set_interlace_handling(png_ptr) : 1;
-
-    for(int i=0;i<number_of_passes; ++i){
-        r = 0;
-        while (r < static_cast<png_uint_32>(height)) {
-            void *to_free;
-            int n = get_rows((unsigned char const **) row_pointers, &to_free, r, height-r, data, color_type, bit_depth);
-            if (!n) break;
-            png_write_rows(png_ptr, row_pointers, n);
-            g_free(to_free);
-            r += n;
-        }
-    }
+    bool complete = true;
+    if (ebp.striped_deflate && !interlace) {
+        complete = sp_png_write_idat_striped(png_ptr, ebp, color_type, bit_depth, zlib);
 
-    delete[] row_pointers;
+        // png_write_end() insists on IDATs written by libpng itself; nothing follows them anyway.
+        png_write_chunk(png_ptr, reinterpret_cast<png_const_bytep>("IEND"), nullptr, 0);
+    } else {
+        int number_of_passes = interlace ? png_set_interlace_handling(png_ptr) : 1;
+
+        for(int i=0;i<number_of_passes && complete; ++i){
+            r = 0;
+            StripeRenderer renderer(ebp, color_type, bit_depth);
+            while (auto stripe = renderer.next()) {
+                png_write_rows(png_ptr, const_cast<png_bytepp>(stripe->rows.data()), stripe->rows.size());
+                r += stripe->rows.size();
+            }
+            complete = r >= static_cast<png_uint_32>(height);
+        }
 
-    /* You can write optional chunks like tEXt, zTXt, and tIME at the end
-     * as well.
-     */
+        /* You can write optional chunks like tEXt, zTXt, and tIME at the end
+         * as well.
+         */
 
-    /* It is REQUIRED to call this to finish writing the rest of the file */
-    png_write_end(png_ptr, info_ptr);
+        /* It is REQUIRED to call this to finish writing the rest of the file */
+        if (complete) {
+            png_write_end(png_ptr, info_ptr);
+        }
+    }
 
-    /* if you allocated any text comments, free them here */
+    return complete;
+}
 
-    /* clean up after the write, and free any memory allocated */
-    png_destroy_write_struct(&png_ptr, &info_ptr);
+static bool
+sp_png_write_rgba_striped(PngText const &text,
+                          gchar const *filename, unsigned long int width, unsigned long int height, double xdpi, double ydpi,
+                          SPEBP &ebp, bool interlace, int color_type, int bit_depth, int zlib)
+{
+    g_return_val_if_fail(filename != nullptr, false);
 
-    /* close the file */
-    fclose(fp);
+    FILE *fp;
+    png_structp png_ptr;
+    png_infop info_ptr;
 
-    /* that's it */
-    return true;
-}
+    /* open the file */
 
+    Inkscape::IO::dump_fopen_call(filename, "M");
+    fp = Inkscape::IO::fopen_utf8name(filename, "wb");
+    if(fp == nullptr) return false;
 
-/**
- *
- */
-static int
-sp_export_get_rows(guchar const **rows, void **to_free, int row, int num_rows, void *data, int color_type, int bit_depth)
-{
-    struct SPEBP *ebp = (struct SPEBP *) data;
+    /* Create and initialize the png_struct with the desired error handler
+     * functions.  If you want to use the default stderr and longjump method,
+     * you can supply NULL for the last three parameters.  We also check that
+     * the library version is compatible with the one used at compile time,
+     * in case we are using dynamically linked libraries.  REQUIRED.
+     */
+    png_ptr = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, throw_png_error, nullptr);
 
-    if (ebp->status) {
-        if (!ebp->status((float) row / ebp->height, ebp->data)) return 0;
+    if (png_ptr == nullptr) {
+        fclose(fp);
+        return false;
     }
 
-    num_rows = MIN(num_rows, static_cast<int>(ebp->sheight));
-    num_rows = MIN(num_rows, static_cast<int>(ebp->height - row));
-
-    /* Set area of interest */
-    // bbox is now set to the entire image to prevent discontinuities
-    // in the image when blur is used (the borders may still be a bit
-    // off, but that's less noticeable).
-    Geom::IntRect bbox = Geom::IntRect::from_xywh(0, row, ebp->width, num_rows);
-
-    /* Update to renderable state */
-    ebp->drawing->update(bbox);
+    /* Allocate/initialize the image information data.  REQUIRED */
+    info_ptr = png_create_info_struct(png_ptr);
+    if (info_ptr == nullptr) {
+        fclose(fp);
+        png_destroy_write_struct(&png_ptr, nullptr);
+        return false;
+    }
 
-    int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, ebp->width);
-    unsigned char *px = g_new(guchar, num_rows * stride);
+    /* Errors are thrown as PngError instead of longjmp'ing, which would skip the destructors of
+     * the stripe renderers while their tasks still run.
+     */
+    bool complete = false;
+    try {
+        complete = sp_png_write_image(png_ptr, info_ptr, fp, text, width, height, xdpi, ydpi, ebp,
+                                      interlace, color_type, bit_depth, zlib);
+    } catch (PngError const &error) {
+        g_warning("Could not write PNG file %s: %s", filename, error.what());
+    }
 
-    cairo_surface_t *s = cairo_image_surface_create_for_data(
-        px, CAIRO_FORMAT_ARGB32, ebp->width, num_rows, stride);
-    Inkscape::DrawingContext dc(s, bbox.min());
-    dc.setSource(ebp->background);
-    dc.setOperator(CAIRO_OPERATOR_SOURCE);
-    dc.paint();
-    dc.setOperator(CAIRO_OPERATOR_OVER);
+    /* if you allocated any text comments, free them here */
 
-    /* Render */
-    ebp->drawing->render(dc, bbox, 0);
-    cairo_surface_destroy(s);
+    /* clean up after the write, and free any memory allocated */
+    png_destroy_write_struct(&png_ptr, &info_ptr);
 
-    // PNG stores data as unpremultiplied big-endian RGBA, which means
-    // it's identical to the GdkPixbuf format.
-    convert_pixels_argb32_to_pixbuf(px, ebp->width, num_rows, stride,
-                                    /* RGBA to ARGB with A=0 */ ebp->background >> 8);
-    
-    // If a custom bit depth or color type is asked, then convert rgb to grayscale, etc.
-    const guchar* new_data = pixbuf_to_png(rows, px, num_rows, ebp->width, stride, color_type, bit_depth);
-    *to_free = (void*) new_data;
-    free(px);
+    /* close the file */
+    fclose(fp);
 
-    return num_rows;
+    /* that's it */
+    return complete;
 }
 
+
 ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                                 double x0, double y0, double x1, double y1,
                                 unsigned long int width, unsigned long int height, double xdpi, double ydpi,
@@ -380,30 +742,28 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                               width, height, xdpi, ydpi, bgcolor, status, data, force_overwrite, items_only, interlace, color_type, bit_depth, zlib, antialiasing);
 }
 
+struct PngExport::Impl
+{
+    SPDocument *doc;
+    SPEBP ebp;
+    Inkscape::Drawing drawing;
+    unsigned dkey;
+    std::optional<boost::asio::thread_pool> pool;
+    PngText text;
+};
+
 /**
- * Export an area to a PNG file
+ * Set up the drawing of an export.
  *
  * @param area Area in document coordinates
+ * @param threaded Whether to render on a thread pool of its own, sized by the threading
+ *                 preference. The written files are the same either way.
  */
-ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
-                                Geom::Rect const &area,
-                                unsigned long width, unsigned long height, double xdpi, double ydpi,
-                                unsigned long bgcolor,
-                                unsigned (*status)(float, void *),
-                                void *data, bool force_overwrite,
-                                const std::vector<SPItem const *> &items_only, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing)
+PngExport::PngExport(SPDocument *doc, Geom::Rect const &area, unsigned long width, unsigned long height,
+                     unsigned long bgcolor, std::vector<SPItem const *> const &items_only, int antialiasing,
+                     bool threaded)
+    : _impl(std::make_unique<Impl>())
 {
-    g_return_val_if_fail(doc != nullptr, EXPORT_ERROR);
-    g_return_val_if_fail(filename != nullptr, EXPORT_ERROR);
-    g_return_val_if_fail(width >= 1, EXPORT_ERROR);
-    g_return_val_if_fail(height >= 1, EXPORT_ERROR);
-    g_return_val_if_fail(!area.hasZeroArea(), EXPORT_ERROR);
-
-    if (!force_overwrite && !sp_ui_overwrite_file(filename)) {
-        // aborted overwrite
-	return EXPORT_ABORTED;
-    }
-
     doc->ensureUpToDate();
 
     /* Calculate translation by transforming to document coordinates (flipping Y)*/
@@ -429,15 +789,17 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
                             * Geom::Scale(width / area.width(),
                                         height / area.height()));
 
-    struct SPEBP ebp;
+    _impl->doc = doc;
+    _impl->text = sp_png_document_text(doc);
+    auto &ebp = _impl->ebp;
     ebp.width  = width;
     ebp.height = height;
     ebp.background = bgcolor;
 
     /* Create new drawing */
-    Inkscape::Drawing drawing;
-    unsigned const dkey = SPItem::display_key_new(1);
-    drawing.setRoot(doc->getRoot()->invoke_show(drawing, dkey, SP_ITEM_SHOW_DISPLAY));
+    auto &drawing = _impl->drawing;
+    _impl->dkey = SPItem::display_key_new(1);
+    drawing.setRoot(doc->getRoot()->invoke_show(drawing, _impl->dkey, SP_ITEM_SHOW_DISPLAY));
     drawing.root()->setTransform(affine);
     drawing.setExact(); // export with maximum blur rendering quality
     drawing.setAntialiasingOverride(static_cast<Inkscape::Antialiasing>(antialiasing));
@@ -447,28 +809,91 @@ ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
     // We show all and then hide all items we don't want, instead of showing only requested items,
     // because that would not work if the shown item references something in defs
     if (!items_only.empty()) {
-        doc->getRoot()->invoke_hide_except(dkey, items_only);
+        doc->getRoot()->invoke_hide_except(_impl->dkey, items_only);
     }
 
-    ebp.status = status;
-    ebp.data   = data;
+    ebp.status = nullptr;
+    ebp.data   = nullptr;
+    ebp.sheight = 64;
 
-    bool write_status = false;;
+    int num_threads = Inkscape::get_num_threads();
+    ebp.striped_deflate = num_threads > 1;
 
-    ebp.sheight = 64;
-    ebp.px = g_try_new(guchar, 4 * ebp.sheight * width);
+    num_threads = std::min<unsigned long>(num_threads, (height + ebp.sheight - 1) / ebp.sheight);
+    if (threaded && num_threads > 1) {
+        _impl->pool.emplace(num_threads);
+        ebp.pool = &*_impl->pool;
+        ebp.num_threads = num_threads;
+    } else {
+        ebp.pool = nullptr;
+        ebp.num_threads = 1;
+    }
 
-    if (ebp.px) {
-        write_status = sp_png_write_rgba_striped(doc, filename, width, height, xdpi, ydpi, sp_export_get_rows, &ebp, interlace, color_type, bit_depth, zlib);
-        g_free(ebp.px);
+    // Rendering, possibly concurrently, needs an up to date drawing which doesn't change meanwhile.
+    drawing.update(Geom::IntRect::from_xywh(0, 0, width, height));
+    drawing.snapshot();
+}
+
+PngExport::~PngExport()
+{
+    if (_impl->pool) {
+        _impl->pool->join();
+        _impl->pool.reset();
     }
+    _impl->drawing.unsnapshot();
 
     // Hide items, this releases arenaitem
-    doc->getRoot()->invoke_hide(dkey);
+    _impl->doc->getRoot()->invoke_hide(_impl->dkey);
+}
+
+/**
+ * Render the drawing into a PNG file. Doesn't touch the document, whose metadata was read when
+ * setting up the export, so exports of the same document may be written concurrently.
+ */
+ExportResult PngExport::write(gchar const *filename, double xdpi, double ydpi,
+                              unsigned (*status)(float, void *), void *data,
+                              bool interlace, int color_type, int bit_depth, int zlib)
+{
+    g_return_val_if_fail(filename != nullptr, EXPORT_ERROR);
+
+    auto &ebp = _impl->ebp;
+    ebp.status = status;
+    ebp.data   = data;
+
+    bool write_status = sp_png_write_rgba_striped(_impl->text, filename, ebp.width, ebp.height, xdpi, ydpi, ebp,
+                                                  interlace, color_type, bit_depth, zlib);
 
     return write_status ? EXPORT_OK : EXPORT_ERROR;
 }
 
+/**
+ * Export an area to a PNG file
+ *
+ * @param area Area in document coordinates
+ */
+ExportResult sp_export_png_file(SPDocument *doc, gchar const *filename,
+                                Geom::Rect const &area,
+                                unsigned long width, unsigned long height, double xdpi, double ydpi,
+                                unsigned long bgcolor,
+                                unsigned (*status)(float, void *),
+                                void *data, bool force_overwrite,
+                                const std::vector<SPItem const *> &items_only, bool interlace, int color_type, int bit_depth, int zlib, int antialiasing)
+{
+    g_return_val_if_fail(doc != nullptr, EXPORT_ERROR);
+    g_return_val_if_fail(filename != nullptr, EXPORT_ERROR);
+    g_return_val_if_fail(width >= 1, EXPORT_ERROR);
+    g_return_val_if_fail(height >= 1, EXPORT_ERROR);
+    g_return_val_if_fail(!area.hasZeroArea(), EXPORT_ERROR);
+
+    if (!force_overwrite && !sp_ui_overwrite_file(filename)) {
+        // aborted overwrite
+	return EXPORT_ABORTED;
+    }
+
+    PngExport png(doc, area, width, height, bgcolor, items_only, antialiasing);
+    return png.write(filename, xdpi, ydpi, status, data, interlace, color_type, bit_depth, zlib);
+}
+
 
 /*
   Local Variables:
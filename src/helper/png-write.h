@@ -16,6 +16,7 @@
  */
 
 #include <glib.h> // Only for gchar.
+#include <memory>
 #include <vector>
 
 #include <2geom/forward.h>
@@ -70,4 +71,29 @@ ExportResult sp_export_png_file(SPDocument *doc,
                                 int zlib = 6,
                                 int antialiasing = 2);
 
+/**
+ * A PNG export in two steps: the constructor sets up the drawing of the document on the main
+ * thread, write() only renders it and may be called from another thread. This lets several
+ * areas or pages of one document be exported concurrently.
+ */
+class PngExport
+{
+public:
+    PngExport(SPDocument *doc, Geom::Rect const &area, unsigned long width, unsigned long height,
+              unsigned long bgcolor, std::vector<SPItem const *> const &items_only = {}, int antialiasing = 2,
+              bool threaded = true);
+    ~PngExport();
+
+    PngExport(PngExport const &) = delete;
+    PngExport &operator=(PngExport const &) = delete;
+
+    ExportResult write(gchar const *filename, double xdpi, double ydpi,
+                       unsigned int (*status) (float, void *) = nullptr, void *data = nullptr,
+                       bool interlace = false, int color_type = 6, int bit_depth = 8, int zlib = 6);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> _impl;
+};
+
 #endif // SEEN_SP_PNG_WRITE_H
@@ -47,6 +47,8 @@
 #include <cerrno>  // History file
 #include <regex>
 #include <numeric>
+#include <optional>
+#include <sstream>
 #include <unistd.h>
 #include <chrono>
 #include <thread>
@@ -94,6 +96,7 @@
 #include "include/glibmm_version.h"
 #include "inkgc/gc-core.h"          // Garbage Collecting init
 #include "io/file.h"                // File open (command line).
+#include "io/batch-server.h"       // Batch processing server.
 #include "io/fix-broken-links.h"    // Fix up references.
 #include "io/resource.h"            // TEMPLATE
 #include "object/sp-root.h"         // Inkscape version.
@@ -106,6 +109,7 @@
 #include "ui/widget/desktop-widget.h"
 #include "util/scope_exit.h"
 #include "util/statics.h"
+#include "util/json.h"
 #include "util/units.h"           // Redimension window
 
 #ifdef ENABLE_NLS
@@ -359,6 +363,8 @@ InkscapeApplication::document_close(SPDocument* document)
             std::cerr << "InkscapeApplication::close_document: Document not registered with application." << std::endl;
         }
 
+        Inkscape::AutoSave::getInstance().forget(document);
+
         Inkscape::GC::release(document);
         assert(document->_anchored_refcount() == 0);
         delete document;
@@ -772,6 +778,7 @@ InkscapeApplication::InkscapeApplication()
     gapp->add_main_option_entry(T::OptionType::STRING,   "export-png-compression", '\0', N_("Compression level for PNG export (0 to 9); default is 6"), N_("LEVEL"));
     // FIXME: Antialias should really be an INT, but an upstream bug means 0 is detected as NULL
     gapp->add_main_option_entry(T::OptionType::STRING,   "export-png-antialias",   '\0', N_("Antialias level for PNG export (0 to 3); default is 2"),   N_("LEVEL"));
+    gapp->add_main_option_entry(T::OptionType::INT,      "export-jobs",           '\0', N_("Number of objects or pages to export to PNG concurrently; reports the time taken for each file"), N_("JOBS")); // Bxx
 
     // Query - Geometry
     _start_main_option_section(_("Query object/document geometry"));
@@ -799,6 +806,8 @@ InkscapeApplication::InkscapeApplication()
     gapp->add_main_option_entry(T::OptionType::BOOL,     "batch-process",         '\0', N_("Close GUI after executing all actions"),                                    "");
     _start_main_option_section();
     gapp->add_main_option_entry(T::OptionType::BOOL,     "shell",                 '\0', N_("Start Inkscape in interactive shell mode"),                                 "");
+    gapp->add_main_option_entry(T::OptionType::BOOL,     "batch-server",          '\0', N_("Process newline-delimited JSON jobs from standard input, one at a time, until end of input"), "");
+    gapp->add_main_option_entry(T::OptionType::FILENAME, "batch-socket",          '\0', N_("Process newline-delimited JSON jobs from clients of a UNIX socket, one at a time"), N_("PATH"));
     gapp->add_main_option_entry(T::OptionType::BOOL,     "active-window",          'q', N_("Use active window from commandline"),                                       "");
     // clang-format on
 
@@ -1036,8 +1045,11 @@ InkscapeApplication::on_startup()
     // Extensions
     Inkscape::Extension::init();
 
-    // After extensions are loaded query effects to construct action data
-    init_extension_action_data();
+    // After extensions are loaded query effects to construct action data. This builds every
+    // effect, so on the command line it is only done if the actions are listed.
+    if (_with_gui) {
+        init_extension_action_data();
+    }
 
     // Command line execution. Must be after Extensions are initialized.
     parse_actions(_command_line_actions_input, _command_line_actions);
@@ -1066,6 +1078,11 @@ InkscapeApplication::on_activate()
 {
     std::string output;
 
+    if (_batch_server) {
+        batch_server();
+        return;
+    }
+
     // Create new document, either from pipe or from template.
     SPDocument *document = nullptr;
     auto prefs = Inkscape::Preferences::get();
@@ -1135,6 +1152,13 @@ InkscapeApplication::on_open(const Gio::Application::type_vec_files& files, cons
 
     INKSCAPE.set_pdf_font_strategy((int)_pdf_font_strategy);
 
+    if (_batch_server) {
+        std::cerr << "InkscapeApplication::on_open: Files are opened by the jobs in batch server mode; "
+                     "ignoring the files given on the command line." << std::endl;
+        batch_server();
+        return;
+    }
+
     if (files.size() > 1 && !_file_export.export_filename.empty()) {
         std::cerr << "ConcreteInkscapeApplication<Gtk::Application>::on_open: "
                      "Can't use '--export-filename' with multiple input files "
@@ -1164,9 +1188,15 @@ InkscapeApplication::on_open(const Gio::Application::type_vec_files& files, cons
     }
 }
 
-void
+/**
+ * Append the actions of a list such as "select-all;object-to-path" to \a action_vector.
+ *
+ * @return false if any action was skipped, see append_action().
+ */
+bool
 InkscapeApplication::parse_actions(const Glib::ustring& input, action_vector_t& action_vector)
 {
+    bool ok = true;
     const auto re_colon = Glib::Regex::create("\\s*:\\s*");
 
     // Split action list
@@ -1185,60 +1215,83 @@ InkscapeApplication::parse_actions(const Glib::ustring& input, action_vector_t&
         if (tokens2.size() > 1) {
             value = tokens2[1];
         }
+        ok = append_action(action, value, action_vector) && ok;
+    }
+    return ok;
+}
 
-        Glib::RefPtr<Gio::Action> action_ptr = _gio_application->lookup_action(action);
-        if (action_ptr) {
-            // Doesn't seem to be a way to test this using the C++ binding without Glib-CRITICAL errors.
-            const  GVariantType* gtype = g_action_get_parameter_type(action_ptr->gobj());
-            if (gtype) {
-                // With value.
-                Glib::VariantType type = action_ptr->get_parameter_type();
-                if (type.get_string() == "b") {
-                    bool b = false;
-                    if (value == "1" || value == "true" || value.empty()) {
-                        b = true;
-                    } else if (value == "0" || value == "false") {
-                        b = false;
+/**
+ * Append a single action with its argument, given as a string, to \a action_vector.
+ * Unlike parse_actions(), the value may contain any character.
+ *
+ * @return false if there is no such action or the value doesn't fit its parameter.
+ */
+bool
+InkscapeApplication::append_action(const Glib::ustring& action, const Glib::ustring& value, action_vector_t& action_vector)
+{
+    Glib::RefPtr<Gio::Action> action_ptr = _gio_application->lookup_action(action);
+    if (action_ptr) {
+        // Doesn't seem to be a way to test this using the C++ binding without Glib-CRITICAL errors.
+        const  GVariantType* gtype = g_action_get_parameter_type(action_ptr->gobj());
+        if (gtype) {
+            // With value.
+            Glib::VariantType type = action_ptr->get_parameter_type();
+            if (type.get_string() == "b") {
+                bool b = false;
+                if (value == "1" || value == "true" || value.empty()) {
+                    b = true;
+                } else if (value == "0" || value == "false") {
+                    b = false;
+                } else {
+                    std::cerr << "InkscapeApplication::parse_actions: Invalid boolean value: " << action << ":" << value << std::endl;
+                    return false;
+                }
+                action_vector.emplace_back(action, Glib::Variant<bool>::create(b));
+            } else if (type.get_string() == "i" || type.get_string() == "d") {
+                try {
+                    if (type.get_string() == "i") {
+                        action_vector.emplace_back(action, Glib::Variant<int>::create(std::stoi(value)));
                     } else {
-                        std::cerr << "InkscapeApplication::parse_actions: Invalid boolean value: " << action << ":" << value << std::endl;
-                    }
-                    action_vector.emplace_back(action, Glib::Variant<bool>::create(b));
-                } else if (type.get_string() == "i") {
-                    action_vector.emplace_back(action, Glib::Variant<int>::create(std::stoi(value)));
-                } else if (type.get_string() == "d") {
-                    action_vector.emplace_back(action, Glib::Variant<double>::create(std::stod(value)));
-                } else if (type.get_string() == "s") {
-                    action_vector.emplace_back(action, Glib::Variant<Glib::ustring>::create(value));
-                 } else if (type.get_string() == "(dd)") {
-                    std::vector<Glib::ustring> tokens3 = Glib::Regex::split_simple(",", value.c_str());
-                    if (tokens3.size() != 2) {
-                        std::cerr << "InkscapeApplication::parse_actions: " << action << " requires two comma separated numbers" << std::endl;
-                        continue;
-                    }
-
-                    double d0 = 0;
-                    double d1 = 0;
-                    try {
-                        d0 = std::stod(tokens3[0]);
-                        d1 = std::stod(tokens3[1]);
-                    } catch (...) {
-                        std::cerr << "InkscapeApplication::parse_actions: " << action << " requires two comma separated numbers" << std::endl;
-                        continue;
+                        action_vector.emplace_back(action, Glib::Variant<double>::create(std::stod(value)));
                     }
+                } catch (...) {
+                    std::cerr << "InkscapeApplication::parse_actions: " << action << " requires a number" << std::endl;
+                    return false;
+                }
+            } else if (type.get_string() == "s") {
+                action_vector.emplace_back(action, Glib::Variant<Glib::ustring>::create(value));
+             } else if (type.get_string() == "(dd)") {
+                std::vector<Glib::ustring> tokens3 = Glib::Regex::split_simple(",", value.c_str());
+                if (tokens3.size() != 2) {
+                    std::cerr << "InkscapeApplication::parse_actions: " << action << " requires two comma separated numbers" << std::endl;
+                    return false;
+                }
 
-                    action_vector.emplace_back(action, Glib::Variant<std::tuple<double, double>>::create({d0, d1}));
-               } else {
-                    std::cerr << "InkscapeApplication::parse_actions: unhandled action value: "
-                              << action << ": " << type.get_string() << std::endl;
+                double d0 = 0;
+                double d1 = 0;
+                try {
+                    d0 = std::stod(tokens3[0]);
+                    d1 = std::stod(tokens3[1]);
+                } catch (...) {
+                    std::cerr << "InkscapeApplication::parse_actions: " << action << " requires two comma separated numbers" << std::endl;
+                    return false;
                 }
-            } else {
-                // Stateless (i.e. no value).
-                action_vector.emplace_back(action, Glib::VariantBase());
+
+                action_vector.emplace_back(action, Glib::Variant<std::tuple<double, double>>::create({d0, d1}));
+           } else {
+                std::cerr << "InkscapeApplication::parse_actions: unhandled action value: "
+                          << action << ": " << type.get_string() << std::endl;
+                return false;
             }
         } else {
-            std::cerr << "InkscapeApplication::parse_actions: could not find action for: " << action << std::endl;
+            // Stateless (i.e. no value).
+            action_vector.emplace_back(action, Glib::VariantBase());
         }
+    } else {
+        std::cerr << "InkscapeApplication::parse_actions: could not find action for: " << action << std::endl;
+        return false;
     }
+    return true;
 }
 
 #ifdef WITH_GNU_READLINE
@@ -1389,6 +1442,223 @@ InkscapeApplication::shell(bool active_window)
     }
 }
 
+namespace {
+
+/**
+ * An action argument of a batch job in the form append_action() expects: strings as they are,
+ * numbers and booleans as written in JSON.
+ */
+std::optional<Glib::ustring> batch_action_value(Inkscape::Util::JsonValue const &value)
+{
+    if (auto str = value.getString()) {
+        return Glib::ustring(*str);
+    }
+    if (value.isBool() || value.isNumber()) {
+        return Glib::ustring(value.serialize());
+    }
+    if (value.isNull()) {
+        return Glib::ustring();
+    }
+    return {};
+}
+
+} // namespace
+
+/**
+ * Serve batch jobs until the input ends or a client asks to quit. The application, with its
+ * extensions, fonts and preferences, stays loaded between jobs; only documents come and go.
+ *
+ * A job is a JSON object on a single line:
+ *
+ *   {"id": 1, "open": "in.svg", "actions": "select-all;object-to-path",
+ *    "export": {"filename": "out.png", "dpi": 300}}
+ *
+ * - "id": copied to the response.
+ * - "open" (a file name) or "data" (SVG text): document to run the job on.
+ * - "document": keep the opened document under this name for later jobs, which then only give
+ *   the name; without a name, a document is closed after its job.
+ * - "close": close the named document after this job.
+ * - "actions": an action list like for --actions, or an array of "action:argument" strings.
+ * - "export": export options, named like the --export-* options without the prefix; the
+ *   export is done after the actions.
+ *
+ * The response is {"id": 1, "ok": true, "time_ms": 12.5, "output": "..."}, where output is
+ * what the actions printed, or {"id": 1, "ok": false, "error": "..."}.
+ */
+void
+InkscapeApplication::batch_server()
+{
+    // Options from the command line are the defaults of every job.
+    _batch_export_defaults = _file_export;
+
+    Inkscape::BatchServer server([this] (Inkscape::Util::JsonValue const &job) {
+        return batch_job(job);
+    });
+    if (_batch_socket.empty()) {
+        server.serveStdio();
+    } else {
+        server.serveSocket(_batch_socket);
+    }
+
+    while (!_batch_documents.empty()) {
+        batch_close_document(_batch_documents.begin()->second);
+    }
+}
+
+void
+InkscapeApplication::batch_close_document(SPDocument *document)
+{
+    for (auto it = _batch_documents.begin(); it != _batch_documents.end(); ) {
+        it = it->second == document ? _batch_documents.erase(it) : std::next(it);
+    }
+    if (_active_document == document) {
+        _active_document = nullptr;
+        _active_selection = nullptr;
+    }
+    INKSCAPE.remove_document(document);
+    document_close(document);
+}
+
+Inkscape::Util::JsonValue
+InkscapeApplication::batch_job(Inkscape::Util::JsonValue const &job)
+{
+    using Inkscape::Util::JsonValue;
+    auto const start = std::chrono::steady_clock::now();
+
+    JsonValue::Object response;
+    if (auto id = job.find("id")) {
+        response.emplace("id", *id);
+    }
+    auto fail = [&] (std::string message) {
+        response.insert_or_assign("ok", false);
+        response.insert_or_assign("error", std::move(message));
+        return JsonValue(std::move(response));
+    };
+
+    // Check the job before touching any document.
+    std::string name;
+    if (auto value = job.find("document")) {
+        if (!value->getString() || value->getString()->empty()) {
+            return fail("\"document\" must be a non-empty string");
+        }
+        name = *value->getString();
+    }
+    auto const open = job.find("open");
+    auto const data = job.find("data");
+    if (open && data) {
+        return fail("\"open\" and \"data\" are mutually exclusive");
+    }
+    if ((open && !open->getString()) || (data && !data->getString())) {
+        return fail(open ? "\"open\" must be a file name" : "\"data\" must be a string");
+    }
+    bool close = name.empty();
+    if (auto value = job.find("close")) {
+        if (!value->getBool()) {
+            return fail("\"close\" must be a boolean");
+        }
+        close = close || *value->getBool();
+    }
+    if (!open && !data && !name.empty() && !_batch_documents.count(name)) {
+        return fail("no open document called \"" + name + "\"");
+    }
+
+    // Every job starts from the export options of the command line.
+    _file_export = _batch_export_defaults;
+
+    action_vector_t actions;
+    if (auto value = job.find("actions")) {
+        if (auto list = value->getString()) {
+            if (!parse_actions(*list, actions)) {
+                return fail("invalid action in \"" + *list + "\"");
+            }
+        } else if (auto array = value->getArray()) {
+            for (auto const &entry : *array) {
+                auto const str = entry.getString();
+                if (!str) {
+                    return fail("\"actions\" must be a string or an array of strings");
+                }
+                auto const colon = str->find(':');
+                Glib::ustring const action = str->substr(0, colon);
+                Glib::ustring const argument = colon == std::string::npos ? "" : str->substr(colon + 1);
+                if (!append_action(action, argument, actions)) {
+                    return fail("invalid action \"" + *str + "\"");
+                }
+            }
+        } else {
+            return fail("\"actions\" must be a string or an array of strings");
+        }
+    }
+    if (auto value = job.find("export")) {
+        auto const options = value->getObject();
+        if (!options) {
+            return fail("\"export\" must be an object");
+        }
+        for (auto const &[option, argument] : *options) {
+            auto const str = batch_action_value(argument);
+            if (!str || !append_action("export-" + option, *str, actions)) {
+                return fail("invalid export option \"" + option + "\"");
+            }
+        }
+        actions.emplace_back("export-do", Glib::VariantBase());
+    }
+
+    // Find or open the document.
+    SPDocument *document = nullptr;
+    if (open || data) {
+        document = open ? document_open(Gio::File::create_for_path(*open->getString()))
+                        : document_open(*data->getString());
+        if (!document) {
+            return fail(open ? "cannot open \"" + *open->getString() + "\"" : "cannot read the SVG data");
+        }
+        INKSCAPE.add_document(document);
+        if (!name.empty()) {
+            if (auto it = _batch_documents.find(name); it != _batch_documents.end()) {
+                batch_close_document(it->second);
+            }
+            _batch_documents.emplace(name, document);
+        }
+    } else if (!name.empty()) {
+        document = _batch_documents[name];
+    }
+
+    auto cleanup = scope_exit([&] {
+        if (document && close) {
+            batch_close_document(document);
+        }
+    });
+
+    _active_document = document;
+    _active_selection = document ? document->getSelection() : nullptr;
+    _active_window = nullptr;
+    _active_desktop = nullptr;
+    if (document) {
+        document->ensureUpToDate(); // Or queries don't work!
+    }
+
+    // Whatever the actions print is part of the response, not of the protocol stream.
+    std::ostringstream output;
+    try {
+        auto const stdout_buf = std::cout.rdbuf(output.rdbuf());
+        auto restore = scope_exit([&] { std::cout.rdbuf(stdout_buf); });
+        activate_any_actions(actions, _gio_application, _active_window, _active_document);
+
+        auto context = Glib::MainContext::get_default();
+        while (context->iteration(false)) {};
+    } catch (std::exception const &e) {
+        return fail(e.what());
+    } catch (Glib::Error const &e) {
+        return fail(e.what());
+    }
+
+    std::chrono::duration<double, std::milli> const elapsed = std::chrono::steady_clock::now() - start;
+    response.insert_or_assign("ok", true);
+    response.insert_or_assign("time_ms", elapsed.count());
+    if (!output.str().empty()) {
+        response.insert_or_assign("output", output.str());
+    }
+    return response;
+}
+
 // Todo: Code can be improved by using proper IPC rather than temporary file polling.
 void InkscapeApplication::redirect_output()
 {
@@ -1549,6 +1819,7 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         options->contains("export-png-use-dithering") ||
         options->contains("export-png-compression") ||
         options->contains("export-png-antialias") ||
+        options->contains("export-jobs")           ||
 
         options->contains("query-id")              ||
         options->contains("query-x")               ||
@@ -1563,7 +1834,9 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
         options->contains("action-list")           ||
         options->contains("actions")               ||
         options->contains("actions-file")          ||
-        options->contains("shell")
+        options->contains("shell")                 ||
+        options->contains("batch-server")          ||
+        options->contains("batch-socket")
         ) {
         _with_gui = false;
     }
@@ -1579,6 +1852,11 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
     if (options->contains("batch-process"))  _batch_process = true;
     if (options->contains("shell"))          _use_shell = true;
     if (options->contains("pipe"))           _use_pipe  = true;
+    if (options->contains("batch-server"))   _batch_server = true;
+    if (options->contains("batch-socket")) {
+        options->lookup_value("batch-socket", _batch_socket);
+        _batch_server = true;
+    }
 
     // Enable auto-export
     if (options->contains("export-filename")  ||
@@ -1841,6 +2119,15 @@ InkscapeApplication::on_handle_local_options(const Glib::RefPtr<Glib::VariantDic
             _file_export.export_png_antialias = (int) ival;
         }
     }
+
+    if (options->contains("export-jobs")) {
+        options->lookup_value("export-jobs", _file_export.export_jobs);
+        if (_file_export.export_jobs < 1) {
+            std::cerr << "Invalid value " << _file_export.export_jobs
+                      << " for --export-jobs; exporting one file at a time" << std::endl;
+            _file_export.export_jobs = 1;
+        }
+    }
     
     if (use_active_window) {
         _gio_application->register_application();
@@ -1911,6 +2198,9 @@ InkscapeApplication::print_action_list()
 {
     auto const *gapp = gio_app();
 
+    // Describe the effects too, which are not built yet without a GUI.
+    init_extension_action_data();
+
     auto actions = gapp->list_actions();
     std::sort(actions.begin(), actions.end());
     for (auto const &action : actions) {
@@ -1975,6 +2265,11 @@ std::string action_menu_name(std::string menu) {
 }
 
 void InkscapeApplication::init_extension_action_data() {
+    if (_extension_action_data_done) {
+        return;
+    }
+    _extension_action_data_done = true;
+
     for (auto effect : Inkscape::Extension::db.get_effect_list()) {
 
         std::string aid = effect->get_sanitized_id();
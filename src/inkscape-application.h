@@ -36,6 +36,9 @@ class SPDesktop;
 
 namespace Inkscape {
 class Selection;
+namespace Util {
+class JsonValue;
+} // namespace Util
 } // namespace Inkscape
 
 class InkscapeApplication final
@@ -140,6 +143,8 @@ protected:
     bool _batch_process = false; // Temp
     bool _use_shell   = false;
     bool _use_pipe    = false;
+    bool _batch_server = false;
+    std::string _batch_socket; // Serve jobs on this UNIX socket instead of stdin.
     bool _auto_export = false;
     int _pdf_poppler  = false;
     FontStrategy _pdf_font_strategy = FontStrategy::RENDER_MISSING;
@@ -176,17 +181,26 @@ protected:
     void on_activate();
     void on_open(const Gio::Application::type_vec_files &files, const Glib::ustring &hint);
     void process_document(SPDocument* document, std::string output_path);
-    void parse_actions(const Glib::ustring& input, action_vector_t& action_vector);
+    bool parse_actions(const Glib::ustring& input, action_vector_t& action_vector);
+    bool append_action(const Glib::ustring& action, const Glib::ustring& value, action_vector_t& action_vector);
 
     void on_about();
     void redirect_output();
     void shell(bool active_window = false);
+    void batch_server();
+    Inkscape::Util::JsonValue batch_job(Inkscape::Util::JsonValue const &job);
+    void batch_close_document(SPDocument *document);
 
     void _start_main_option_section(const Glib::ustring& section_name = "");
     
 private:
     void init_extension_action_data();
     std::vector<Glib::RefPtr<Gio::SimpleAction>> _effect_actions;
+    bool _extension_action_data_done = false; // Built at startup with a GUI, else when listed.
+
+    // Documents kept open between batch server jobs, by name.
+    std::map<std::string, SPDocument *> _batch_documents;
+    InkFileExportCmd _batch_export_defaults;
 };
 
 #endif // INKSCAPE_APPLICATION_H
@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Transport of the batch processing server: newline-delimited JSON jobs read from standard
+ * input or from the clients of a UNIX socket.
+ *
+ * Copyright (C) 2026 Inkscape Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "batch-server.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <list>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace Inkscape {
+
+namespace {
+
+/// Longest accepted job, so that a client cannot make the server buffer without bound.
+constexpr std::size_t MAX_LINE_LENGTH = 256 * 1024 * 1024;
+
+Util::JsonValue error_response(std::string message)
+{
+    return Util::JsonValue::Object{{"ok", false}, {"error", std::move(message)}};
+}
+
+/**
+ * Keeps standard output for the responses while it lives. Meanwhile file descriptor 1 refers to
+ * standard error, so that whatever the jobs print, with std::cout as well as with printf() or
+ * g_print() from C code, cannot corrupt the responses.
+ */
+class ProtocolOutput
+{
+public:
+    ProtocolOutput()
+    {
+#ifndef _WIN32
+        std::cout.flush();
+        std::fflush(stdout);
+        _fd = ::dup(STDOUT_FILENO);
+        if (_fd >= 0) {
+            ::fcntl(_fd, F_SETFD, FD_CLOEXEC);
+            if (::dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+                ::close(_fd);
+                _fd = -1;
+            }
+        }
+#endif
+    }
+
+    ~ProtocolOutput()
+    {
+#ifndef _WIN32
+        if (_fd >= 0) {
+            std::cout.flush();
+            std::fflush(stdout);
+            ::dup2(_fd, STDOUT_FILENO);
+            ::close(_fd);
+        }
+#endif
+    }
+
+    ProtocolOutput(ProtocolOutput const &) = delete;
+    ProtocolOutput &operator=(ProtocolOutput const &) = delete;
+
+    /// Write a response to the original standard output; returns false if it is gone.
+    bool write(std::string const &data)
+    {
+#ifndef _WIN32
+        if (_fd >= 0) {
+            std::size_t written = 0;
+            while (written < data.size()) {
+                auto const n = ::write(_fd, data.data() + written, data.size() - written);
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return false;
+                }
+                written += n;
+            }
+            return true;
+        }
+#endif
+        // Without a separate descriptor, only what goes through std::cout can be captured.
+        std::cout << data << std::flush;
+        return bool(std::cout);
+    }
+
+private:
+    int _fd = -1;
+};
+
+} // namespace
+
+BatchServer::BatchServer(Handler handler)
+    : _handler(std::move(handler))
+{}
+
+std::string BatchServer::_process(std::string const &line)
+{
+    std::string error;
+    auto job = Util::JsonValue::parse(line, &error);
+
+    Util::JsonValue response;
+    if (!job) {
+        response = error_response("invalid JSON: " + error);
+    } else if (!job->isObject()) {
+        response = error_response("a job must be a JSON object");
+    } else if (auto quit = job->find("quit"); quit && quit->getBool() && *quit->getBool()) {
+        _quit = true;
+        response = Util::JsonValue::Object{{"ok", true}};
+        if (auto id = job->find("id")) {
+            response.getObject()->insert_or_assign("id", *id);
+        }
+    } else {
+        // A failing job must not take the server, and the jobs of other clients, down with it.
+        try {
+            response = _handler(*job);
+        } catch (std::exception const &e) {
+            response = error_response(std::string("job failed: ") + e.what());
+        } catch (...) {
+            response = error_response("job failed");
+        }
+    }
+
+    auto out = response.serialize();
+    out += '\n';
+    return out;
+}
+
+int BatchServer::serveStdio()
+{
+    ProtocolOutput output;
+    std::string line;
+    while (!_quit && std::getline(std::cin, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+        if (!output.write(_process(line))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+#ifdef _WIN32
+
+int BatchServer::serveSocket([[maybe_unused]] std::string const &path)
+{
+    std::cerr << "BatchServer::serveSocket: UNIX sockets are not supported on this platform." << std::endl;
+    return 1;
+}
+
+#else
+
+namespace {
+
+struct Client
+{
+    int fd;
+    std::string input;
+    bool eof = false; ///< Nothing more to read, but buffered jobs are still answered.
+};
+
+bool write_all(int fd, std::string const &data)
+{
+#ifdef MSG_NOSIGNAL
+    int const flags = MSG_NOSIGNAL; // A client going away must not kill the server.
+#else
+    int const flags = 0;
+#endif
+    std::size_t written = 0;
+    while (written < data.size()) {
+        auto const n = ::send(fd, data.data() + written, data.size() - written, flags);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+} // namespace
+
+int BatchServer::serveSocket(std::string const &path)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        std::cerr << "BatchServer::serveSocket: Socket path too long: " << path << std::endl;
+        return 1;
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int const listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "BatchServer::serveSocket: socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+    ::fcntl(listener, F_SETFD, FD_CLOEXEC);
+
+    // Replace a stale socket, but never one that another server is still listening on.
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        int const probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        bool const in_use = probe >= 0 && ::connect(probe, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            ::close(probe);
+        }
+        if (in_use) {
+            std::cerr << "BatchServer::serveSocket: Another server is listening on " << path << std::endl;
+            ::close(listener);
+            return 1;
+        }
+        ::unlink(path.c_str());
+    }
+
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+        ::listen(listener, SOMAXCONN) < 0) {
+        std::cerr << "BatchServer::serveSocket: Cannot listen on " << path << ": " << std::strerror(errno) << std::endl;
+        ::close(listener);
+        return 1;
+    }
+
+    std::list<Client> clients;
+    std::vector<pollfd> fds;
+    bool pending = false; // Whether a client has a complete job buffered.
+
+    while (!_quit) {
+        fds.clear();
+        fds.push_back({listener, POLLIN, 0});
+        for (auto const &client : clients) {
+            fds.push_back({client.fd, static_cast<short>(client.eof ? 0 : POLLIN), 0});
+        }
+
+        if (::poll(fds.data(), fds.size(), pending ? 0 : -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "BatchServer::serveSocket: poll: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        // Read what has arrived, then run at most one job per client so that no client can
+        // starve the others.
+        pending = false;
+        auto poll_fd = fds.begin() + 1;
+        for (auto it = clients.begin(); it != clients.end() && !_quit; ++poll_fd) {
+            auto &client = *it;
+            bool closed = false;
+
+            if (poll_fd != fds.end() && poll_fd->fd == client.fd && (poll_fd->revents & (POLLIN | POLLHUP | POLLERR))) {
+                char buffer[65536];
+                auto const n = ::recv(client.fd, buffer, sizeof(buffer), 0);
+                if (n > 0) {
+                    client.input.append(buffer, n);
+                } else if (n == 0) {
+                    client.eof = true;
+                } else if (errno != EINTR) {
+                    closed = true;
+                }
+            }
+
+            auto const eol = client.input.find('\n');
+            if (eol != std::string::npos) {
+                auto line = client.input.substr(0, eol);
+                client.input.erase(0, eol + 1);
+                if (!line.empty() && line.back() == '\r') {
+                    line.pop_back();
+                }
+                if (line.find_first_not_of(" \t") != std::string::npos && !write_all(client.fd, _process(line))) {
+                    closed = true;
+                }
+                pending = pending || client.input.find('\n') != std::string::npos;
+            } else if (client.input.size() > MAX_LINE_LENGTH) {
+                write_all(client.fd, error_response("job too long").serialize() + '\n');
+                closed = true;
+            } else if (client.eof) {
+                closed = true;
+            }
+
+            if (closed) {
+                ::close(client.fd);
+                it = clients.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int const fd = ::accept(listener, nullptr, nullptr);
+            if (fd >= 0) {
+                ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+                clients.push_back({fd, {}, false});
+            }
+        }
+    }
+
+    for (auto const &client : clients) {
+        ::close(client.fd);
+    }
+    ::close(listener);
+    ::unlink(path.c_str());
+    return 0;
+}
+
+#endif // _WIN32
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
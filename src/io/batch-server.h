@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Transport of the batch processing server: newline-delimited JSON jobs read from standard
+ * input or from the clients of a UNIX socket.
+ *
+ * Copyright (C) 2026 Inkscape Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_IO_BATCH_SERVER_H
+#define INKSCAPE_IO_BATCH_SERVER_H
+
+#include <functional>
+#include <string>
+
+#include "util/json.h"
+
+namespace Inkscape {
+
+/**
+ * Reads one JSON job per line and writes one JSON response per line, in the order of the jobs of
+ * each client. The jobs themselves are run by the handler, on the calling (main) thread.
+ *
+ * A job {"quit": true} stops the server after answering it. Malformed lines are answered with
+ * {"ok": false, "error": "..."} without calling the handler.
+ */
+class BatchServer
+{
+public:
+    using Handler = std::function<Util::JsonValue(Util::JsonValue const &job)>;
+
+    explicit BatchServer(Handler handler);
+
+    /// Serve jobs from standard input until end of file, answering on standard output. What the
+    /// jobs print to standard output meanwhile goes to standard error.
+    /// @return Exit status.
+    int serveStdio();
+
+    /**
+     * Serve jobs from any number of clients of a UNIX socket created at \a path, until a client
+     * asks to quit. Clients are served in turn, one job at a time each.
+     * @return Exit status.
+     */
+    int serveSocket(std::string const &path);
+
+private:
+    /// Run the job of one line; returns the response line. Sets _quit if asked to.
+    std::string _process(std::string const &line);
+
+    Handler _handler;
+    bool _quit = false;
+};
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_IO_BATCH_SERVER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -14,9 +14,16 @@
 
 #include "file-export-cmd.h"
 
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <boost/algorithm/string.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
 #include <giomm/file.h>
 #include <glibmm/convert.h>
 #include <glibmm/fileutils.h>
@@ -77,6 +84,7 @@ InkFileExportCmd::InkFileExportCmd()
     , export_plain_svg(false)
     ,export_png_compression(6)
     ,export_png_antialias(2)
+    ,export_jobs(0)
 {
 }
 
@@ -473,6 +481,117 @@ guint32 InkFileExportCmd::get_bgcolor(SPDocument *doc) {
     return bgcolor;
 }
 
+/**
+ * Writes the PNG files of an export, either right away or, with --export-jobs, on a thread pool.
+ * The drawings are always set up (and released) on the main thread, in order; a bounded number
+ * of them is kept around while their files are being written.
+ */
+class InkFileExportCmd::PngQueue
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Setup = std::function<std::unique_ptr<PngExport>()>;
+    using Write = std::function<ExportResult(PngExport &)>;
+
+    /// @param jobs Number of files to write concurrently; the time taken is reported unless 0.
+    explicit PngQueue(int jobs)
+        : _jobs(std::max(jobs, 1))
+        , _report(jobs > 0)
+        , _start(Clock::now())
+    {
+        if (_jobs > 1) {
+            _pool.emplace(_jobs);
+        }
+    }
+
+    ~PngQueue() { finish(); }
+
+    /// Whether a single export may use threads of its own.
+    bool exportThreaded() const { return !_pool; }
+
+    void add(std::string filename, Setup const &setup, Write write)
+    {
+        auto const start = Clock::now();
+        Item item{std::move(filename), setup()};
+        item.setup = Clock::now() - start;
+
+        if (!_pool) {
+            auto const write_start = Clock::now();
+            auto const result = write(*item.png);
+            _done(item, result, Clock::now() - write_start);
+            return;
+        }
+
+        auto task = std::make_shared<std::packaged_task<std::pair<ExportResult, Clock::duration>()>>(
+            [png = item.png.get(), write = std::move(write)] {
+                auto const write_start = Clock::now();
+                auto const result = write(*png);
+                return std::make_pair(result, Clock::now() - write_start);
+            });
+        item.result = task->get_future();
+        boost::asio::post(*_pool, [task] { (*task)(); });
+        _pending.push_back(std::move(item));
+
+        // Keep every job busy without setting up all drawings at once.
+        while (_pending.size() > 2 * static_cast<std::size_t>(_jobs)) {
+            _reap();
+        }
+    }
+
+    /// Wait for all files to be written.
+    void finish()
+    {
+        while (!_pending.empty()) {
+            _reap();
+        }
+        if (_report && _count > 0) {
+            std::cerr << "Exported " << _count << " PNG file(s) in " << _ms(Clock::now() - _start)
+                      << " ms using " << _jobs << " job(s)" << std::endl;
+            _count = 0;
+        }
+    }
+
+private:
+    struct Item
+    {
+        std::string filename;
+        std::unique_ptr<PngExport> png;
+        Clock::duration setup{};
+        std::future<std::pair<ExportResult, Clock::duration>> result;
+    };
+
+    static double _ms(Clock::duration d) { return std::chrono::duration<double, std::milli>(d).count(); }
+
+    void _reap()
+    {
+        auto item = std::move(_pending.front());
+        _pending.pop_front();
+        auto const [result, duration] = item.result.get();
+        _done(item, result, duration);
+    }
+
+    void _done(Item &item, ExportResult result, Clock::duration duration)
+    {
+        item.png.reset();
+        if (result != EXPORT_OK) {
+            std::cerr << "InkFileExport::do_export_png: Failed to export to " << item.filename << std::endl;
+            return;
+        }
+        if (_report) {
+            std::cerr << item.filename << ": " << _ms(item.setup + duration) << " ms (setup "
+                      << _ms(item.setup) << " ms, render and write " << _ms(duration) << " ms)" << std::endl;
+        }
+        ++_count;
+    }
+
+    int _jobs;
+    bool _report;
+    Clock::time_point _start;
+    int _count = 0;
+    std::optional<boost::asio::thread_pool> _pool;
+    std::deque<Item> _pending;
+};
+
 /**
  *  Perform a PNG export
  *
@@ -492,6 +611,8 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &export_filen
     // Export each object in list (or root if empty).  Use ';' so in future it could be possible to selected multiple objects to export together.
     std::vector<Glib::ustring> objects = Glib::Regex::split_simple("\\s*;\\s*", export_id);
 
+    PngQueue queue(export_jobs);
+
     std::vector<SPItem const *> items;
     std::vector<Glib::ustring> objects_found;
     for (auto const &object_id : objects) {
@@ -531,9 +652,10 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &export_filen
             // And if only one page is selected then we assume the user knows the filename they intended.
             std::string filename_out = base + (pages.size() > 1 ? "_p" + std::to_string(page_num) : "") + ".png";
             if (auto page = pm.getPage(page_num - 1)) {
-                do_export_png_now(doc, filename_out, page->getDesktopRect(), dpi, items);
+                do_export_png_now(doc, filename_out, page->getDesktopRect(), dpi, items, queue);
             }
         }
+        queue.finish();
         return 0;
     }
 
@@ -664,15 +786,16 @@ InkFileExportCmd::do_export_png(SPDocument *doc, std::string const &export_filen
             area = area.roundOutwards();
         }
         // End finding area.
-        do_export_png_now(doc, filename_out, area, dpi, items);
+        do_export_png_now(doc, filename_out, area, dpi, items, queue);
 
     } // End loop over objects.
+    queue.finish();
     prefs->setBool("/options/dithering/value", old_dither);
     return 0;
 }
 
 void
-InkFileExportCmd::do_export_png_now(SPDocument *doc, std::string const &filename_out, Geom::Rect area, double dpi_in, const std::vector<SPItem const *> &items)
+InkFileExportCmd::do_export_png_now(SPDocument *doc, std::string const &filename_out, Geom::Rect area, double dpi_in, const std::vector<SPItem const *> &items, PngQueue &queue)
 {
     // -------------------------- DPI -------------------------------
 
@@ -795,12 +918,21 @@ InkFileExportCmd::do_export_png_now(SPDocument *doc, std::string const &filename
             return;
         }
 
-        if( sp_export_png_file(doc, filename_out.c_str(), area, width, height, xdpi, ydpi,
-                               bgcolor, nullptr, nullptr, true, export_id_only ? items : std::vector<SPItem const *>(),
-                               false, color_type, bit_depth, export_png_compression, export_png_antialias) == 1 ) {
-        } else {
+        if (area.hasZeroArea()) {
             std::cerr << "InkFileExport::do_export_png: Failed to export to " << filename_out << std::endl;
+            return;
         }
+
+        queue.add(filename_out,
+                  [&] {
+                      return std::make_unique<PngExport>(doc, area, width, height, bgcolor,
+                                                         export_id_only ? items : std::vector<SPItem const *>(),
+                                                         export_png_antialias, queue.exportThreaded());
+                  },
+                  [=, zlib = export_png_compression] (PngExport &png) {
+                      return png.write(filename_out.c_str(), xdpi, ydpi, nullptr, nullptr, false, color_type,
+                                       bit_depth, zlib);
+                  });
 }
 
 
@@ -13,14 +13,18 @@
 /*
  * This is a thin wrapper of libz calls, in order
  * to provide a simple interface to our developers
- * for gzip input and output.
+ * for gzip input and output. Large streams are
+ * inflated ahead of the reader, and deflated in
+ * parallel blocks.
  */
 
 #include "gzipstream.h"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <string>
+#include <boost/asio/post.hpp>
 
 namespace Inkscape
 {
@@ -31,7 +35,12 @@ namespace IO
 //# G Z I P    I N P U T    S T R E A M
 //#########################################################################
 
-#define OUT_SIZE 4000
+/// Bytes inflated at a time, and read from the source at a time.
+constexpr std::size_t OUT_SIZE = 64 * 1024;
+constexpr std::size_t SRC_SIZE = 64 * 1024;
+
+/// Inflated chunks the reader thread may get ahead by.
+constexpr std::size_t MAX_CHUNKS = 16;
 
 /**
  *
@@ -39,14 +48,11 @@ namespace IO
 GzipInputStream::GzipInputStream(InputStream &sourceStream)
                     : BasicInputStream(sourceStream),
                       loaded(false),
-                      outputBuf(nullptr),
-                      srcBuf(nullptr),
-                      crc(0),
-                      srcCrc(0),
-                      srcSiz(0),
-                      srcLen(0),
+                      sourceEnded(false),
+                      inflateEnded(false),
                       outputBufPos(0),
-                      outputBufLen(0)
+                      readerDone(false),
+                      stopReader(false)
 {
     memset( &d_stream, 0, sizeof(d_stream) );
 }
@@ -57,14 +63,6 @@ GzipInputStream::GzipInputStream(InputStream &sourceStream)
 GzipInputStream::~GzipInputStream()
 {
     close();
-    if ( srcBuf ) {
-      delete[] srcBuf;
-      srcBuf = nullptr;
-    }
-    if ( outputBuf ) {
-        delete[] outputBuf;
-        outputBuf = nullptr;
-    }
 }
 
 /**
@@ -74,9 +72,9 @@ GzipInputStream::~GzipInputStream()
  */ 
 int GzipInputStream::available()
 {
-    if (closed || !outputBuf)
+    if (closed)
         return 0;
-    return outputBufLen - outputBufPos;
+    return outputBuf.size() - outputBufPos;
 }
 
     
@@ -89,19 +87,25 @@ void GzipInputStream::close()
     if (closed)
         return;
 
-    int zerr = inflateEnd(&d_stream);
-    if (zerr != Z_OK) {
-        printf("inflateEnd: Some kind of problem: %d\n", zerr);
+    if (reader.joinable()) {
+        {
+            std::lock_guard lock(mutex);
+            stopReader = true;
+        }
+        cond.notify_all();
+        reader.join();
     }
 
-    if ( srcBuf ) {
-      delete[] srcBuf;
-      srcBuf = nullptr;
-    }
-    if ( outputBuf ) {
-        delete[] outputBuf;
-        outputBuf = nullptr;
+    if (loaded) {
+        int zerr = inflateEnd(&d_stream);
+        if (zerr != Z_OK) {
+            printf("inflateEnd: Some kind of problem: %d\n", zerr);
+        }
     }
+
+    srcBuf = {};
+    outputBuf = {};
+    chunks.clear();
     closed = true;
 }
     
@@ -110,199 +114,183 @@ void GzipInputStream::close()
  */ 
 int GzipInputStream::get()
 {
-    int ch = -1;
     if (closed) {
-        // leave return value -1
+        return -1;
     }
-    else if (!loaded && !load()) {
-        closed=true;
-    } else {
+    if (!loaded) {
         loaded = true;
-
-        if ( outputBufPos >= outputBufLen ) {
-            // time to read more, if we can
-            fetchMore();
+        if (!load()) {
+            closed = true;
+            return -1;
         }
+    }
 
-        if ( outputBufPos < outputBufLen ) {
-            ch = (int)outputBuf[outputBufPos++];
+    while (outputBufPos >= outputBuf.size()) {
+        // time to read more, if we can
+        if (!nextChunk()) {
+            return -1;
         }
     }
 
-    return ch;
+    return static_cast<int>(outputBuf[outputBufPos++]);
 }
 
-#define FTEXT 0x01
-#define FHCRC 0x02
-#define FEXTRA 0x04
-#define FNAME 0x08
-#define FCOMMENT 0x10
-
+/**
+ * Start inflating. zlib reads the gzip header and trailer itself, including the optional
+ * header fields, and checks the CRC.
+ */
 bool GzipInputStream::load()
 {
-    crc = crc32(0L, Z_NULL, 0);
-    
-    std::vector<Byte> inputBuf;
-    while (true)
-        {
-        int ch = source.get();
-        if (ch<0)
-            break;
-        inputBuf.push_back(static_cast<Byte>(ch & 0xff));
-        }
-    long inputBufLen = inputBuf.size();
-    
-    if (inputBufLen < 19) //header + tail + 1
-        {
+    int zerr = inflateInit2(&d_stream, 16 + MAX_WBITS);
+    if (zerr != Z_OK) {
+        printf("inflateInit2: Some kind of problem: %d\n", zerr);
         return false;
-        }
+    }
 
-    srcLen = inputBuf.size();
-    srcBuf = new (std::nothrow) Byte [srcLen];
-    if (!srcBuf) {
-        return false;
+    // Small sources, like compressed SVG glyphs, are inflated as they are read. Larger ones are
+    // read and inflated by a thread of their own.
+    readSource();
+    if (!sourceEnded) {
+        reader = std::thread([this] { readAhead(); });
     }
+    return true;
+}
 
-    outputBuf = new (std::nothrow) unsigned char [OUT_SIZE];
-    if ( !outputBuf ) {
-        delete[] srcBuf;
-        srcBuf = nullptr;
+/**
+ * Read the next part of the source for inflating.
+ * @return false if the source was already at its end.
+ */
+bool GzipInputStream::readSource()
+{
+    if (sourceEnded) {
         return false;
     }
-    outputBufLen = 0; // Not filled in yet
-
-    std::vector<unsigned char>::iterator iter;
-    Bytef *p = srcBuf;
-    for (iter=inputBuf.begin() ; iter != inputBuf.end() ; ++iter)
-	{
-        *p++ = *iter;
-	}
-
-    size_t headerLen = 10;
-
-    int flags = static_cast<int>(srcBuf[3]);
-
-    constexpr size_t size_XLEN = 2;
-    constexpr size_t size_CRC16 = 2;
-    constexpr size_t size_CRC32 = 4;
-    constexpr size_t size_ISIZE = 4;
-
-    auto const check_not_truncated = [&] { return headerLen + size_CRC32 + size_ISIZE <= srcLen; };
-
-    auto const skip_n = [&](size_t n) {
-        headerLen += n;
-        return check_not_truncated();
-    };
-
-    auto const skip_zero_terminated = [&] {
-        while (headerLen < srcLen && srcBuf[headerLen++]) {
+    srcBuf.clear();
+    while (srcBuf.size() < SRC_SIZE) {
+        int ch = source.get();
+        if (ch < 0) {
+            sourceEnded = true;
+            break;
         }
-        return check_not_truncated();
-    };
+        srcBuf.push_back(static_cast<unsigned char>(ch & 0xff));
+    }
+    d_stream.next_in = srcBuf.data();
+    d_stream.avail_in = srcBuf.size();
+    return !srcBuf.empty();
+}
 
-    if (flags & FEXTRA) {
-        if (!skip_n(size_XLEN)) {
-            return false;
+/**
+ * Inflate up to OUT_SIZE bytes into \a chunk, reading the source as needed. Sets inflateEnded
+ * once the stream is done with, at its end or at an error.
+ */
+void GzipInputStream::inflateChunk(std::vector<unsigned char> &chunk)
+{
+    chunk.resize(OUT_SIZE);
+    d_stream.next_out = chunk.data();
+    d_stream.avail_out = chunk.size();
+
+    while (d_stream.avail_out > 0 && !inflateEnded) {
+        if (d_stream.avail_in == 0 && !readSource()) {
+            // Truncated
+            inflateEnded = true;
+            break;
         }
-        auto const xlen = size_t(srcBuf[headerLen - 2]) | //
-                          size_t(srcBuf[headerLen - 1] << 8);
-        if (!skip_n(xlen)) {
-            return false;
+        int zerr = inflate(&d_stream, Z_NO_FLUSH);
+        if (zerr == Z_STREAM_END) {
+            inflateEnded = true;
+        } else if (zerr != Z_OK && zerr != Z_BUF_ERROR) {
+            printf("inflate: Some kind of problem: %d\n", zerr);
+            inflateEnded = true;
         }
     }
 
-    if ((flags & FNAME) && !skip_zero_terminated()) {
-        return false;
-    }
-
-    if ((flags & FCOMMENT) && !skip_zero_terminated()) {
-        return false;
-    }
-
-    if ((flags & FHCRC) && !skip_n(size_CRC16)) {
-        return false;
-    }
+    chunk.resize(chunk.size() - d_stream.avail_out);
+}
 
-    if (!check_not_truncated()) {
-        return false;
-    }
+/**
+ * Body of the reader thread: inflate chunks until the end of the stream, or until told to stop.
+ */
+void GzipInputStream::readAhead()
+{
+    while (true) {
+        std::vector<unsigned char> chunk;
+        try {
+            inflateChunk(chunk);
+        } catch (...) {
+            inflateEnded = true;
+        }
 
-    srcCrc = ((0x0ff & srcBuf[srcLen - 5]) << 24)
-           | ((0x0ff & srcBuf[srcLen - 6]) << 16)
-           | ((0x0ff & srcBuf[srcLen - 7]) <<  8)
-           | ((0x0ff & srcBuf[srcLen - 8]) <<  0);
-    //printf("srcCrc:%lx\n", srcCrc);
-    
-    srcSiz = ((0x0ff & srcBuf[srcLen - 1]) << 24)
-           | ((0x0ff & srcBuf[srcLen - 2]) << 16)
-           | ((0x0ff & srcBuf[srcLen - 3]) <<  8)
-           | ((0x0ff & srcBuf[srcLen - 4]) <<  0);
-    //printf("srcSiz:%lx/%ld\n", srcSiz, srcSiz);
-    
-    //outputBufLen = srcSiz + srcSiz/100 + 14;
-    
-    unsigned char *data = srcBuf + headerLen;
-    unsigned long dataLen = srcLen - (headerLen + 8);
-    //printf("%x %x\n", data[0], data[dataLen-1]);
-    
-    d_stream.zalloc    = (alloc_func)nullptr;
-    d_stream.zfree     = (free_func)nullptr;
-    d_stream.opaque    = (voidpf)nullptr;
-    d_stream.next_in   = data;
-    d_stream.avail_in  = dataLen;
-    d_stream.next_out  = outputBuf;
-    d_stream.avail_out = OUT_SIZE;
-    
-    int zerr = inflateInit2(&d_stream, -MAX_WBITS);
-    if ( zerr == Z_OK )
-    {
-        zerr = fetchMore();
-    } else {
-        printf("inflateInit2: Some kind of problem: %d\n", zerr);
+        std::unique_lock lock(mutex);
+        cond.wait(lock, [this] { return chunks.size() < MAX_CHUNKS || stopReader; });
+        if (stopReader) {
+            break;
+        }
+        if (!chunk.empty()) {
+            chunks.push_back(std::move(chunk));
+        }
+        if (inflateEnded) {
+            break;
+        }
+        cond.notify_all();
     }
 
-        
-    return (zerr == Z_OK) || (zerr == Z_STREAM_END);
+    std::lock_guard lock(mutex);
+    readerDone = true;
+    cond.notify_all();
 }
 
-
-int GzipInputStream::fetchMore()
+/**
+ * Make the next inflated chunk the output buffer.
+ * @return false at the end of the stream.
+ */
+bool GzipInputStream::nextChunk()
 {
-    // TODO assumes we aren't called till the buffer is empty
-    d_stream.next_out  = outputBuf;
-    d_stream.avail_out = OUT_SIZE;
-    outputBufLen = 0;
     outputBufPos = 0;
+    outputBuf.clear();
 
-    int zerr = inflate( &d_stream, Z_SYNC_FLUSH );
-    if ( zerr == Z_OK || zerr == Z_STREAM_END ) {
-        outputBufLen = OUT_SIZE - d_stream.avail_out;
-        if ( outputBufLen ) {
-            crc = crc32(crc, const_cast<const Bytef *>(outputBuf), outputBufLen);
+    if (!reader.joinable()) {
+        if (inflateEnded) {
+            return false;
         }
-        //printf("crc:%lx\n", crc);
-//     } else if ( zerr != Z_STREAM_END ) {
-//         // TODO check to be sure this won't happen for partial end reads
-//         printf("inflate: Some kind of problem: %d\n", zerr);
+        inflateChunk(outputBuf);
+        return !outputBuf.empty();
     }
 
-    return zerr;
+    std::unique_lock lock(mutex);
+    cond.wait(lock, [this] { return !chunks.empty() || readerDone; });
+    if (chunks.empty()) {
+        return false;
+    }
+    outputBuf = std::move(chunks.front());
+    chunks.pop_front();
+    cond.notify_all();
+    return true;
 }
 
 //#########################################################################
 //# G Z I P   O U T P U T    S T R E A M
 //#########################################################################
 
+/// Bytes deflated as one block; the size pigz uses.
+constexpr std::size_t BLOCK_SIZE = 128 * 1024;
+
+/// Bytes at the end of a block that the next one may refer back to.
+constexpr std::size_t DICTIONARY_SIZE = 32 * 1024;
+
 /**
- *
- */ 
-GzipOutputStream::GzipOutputStream(OutputStream &destinationStream)
+ * Deflate onto \a destinationStream, spreading large files over \a num_threads threads.
+ */
+GzipOutputStream::GzipOutputStream(OutputStream &destinationStream, int num_threads)
                      : BasicOutputStream(destinationStream)
+                     , numThreads(num_threads)
 {
 
     totalIn         = 0;
     totalOut        = 0;
     crc             = crc32(0L, Z_NULL, 0);
+    maxPending      = 0;
+
+    inputBuf.reserve(BLOCK_SIZE);
 
     //Gzip header
     destination.put(0x1f);
@@ -347,7 +335,10 @@ void GzipOutputStream::close()
     if (closed)
         return;
 
-    flush();
+    // The last block ends the deflate stream, even if it is empty.
+    submitBlock(true);
+    writePending(0);
+    pool.reset();
 
     //# Send the CRC
     uLong outlong = crc;
@@ -374,51 +365,115 @@ void GzipOutputStream::close()
  */ 
 void GzipOutputStream::flush()
 {
-    if (closed || inputBuf.empty())
-	{
+    if (closed) {
         return;
     }
-	
-    uLong srclen = inputBuf.size();
-    Bytef *srcbuf = new (std::nothrow) Bytef [srclen];
-    if (!srcbuf)
-        {
-        return;
-        }
-        
-    uLong destlen = srclen;
-    Bytef *destbuf = new (std::nothrow) Bytef [(destlen + (srclen/100) + 13)];
-    if (!destbuf)
-        {
-        delete[] srcbuf;
-        return;
+
+    if (!inputBuf.empty()) {
+        submitBlock(false);
+    }
+    writePending(0);
+    destination.flush();
+}
+
+/**
+ * Deflate a block into a part of the stream. All blocks but the last end with a sync flush, so
+ * they can be concatenated.
+ */
+GzipOutputStream::Block GzipOutputStream::deflateBlock(std::vector<unsigned char> const &input,
+                                                       std::vector<unsigned char> const &dictionary, bool last)
+{
+    Block block;
+    block.length = input.size();
+    block.crc = crc32(crc32(0L, Z_NULL, 0), input.data(), input.size());
+
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        printf("deflateInit2: Some kind of problem\n");
+        return block;
+    }
+    if (!dictionary.empty()) {
+        deflateSetDictionary(&zs, dictionary.data(), dictionary.size());
+    }
+    block.data.resize(deflateBound(&zs, input.size()) + 16);
+    zs.next_in = const_cast<Bytef *>(input.data());
+    zs.avail_in = input.size();
+    zs.next_out = block.data.data();
+    zs.avail_out = block.data.size();
+    int const flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    while (true) {
+        int const zerr = deflate(&zs, flush);
+        if (zerr == Z_STREAM_END || ((zerr == Z_OK || zerr == Z_BUF_ERROR) && !last && zs.avail_out > 0)) {
+            break; // All input consumed and flushed.
         }
-        
-    std::vector<unsigned char>::iterator iter;
-    Bytef *p = srcbuf;
-    for (iter=inputBuf.begin() ; iter != inputBuf.end() ; ++iter)
-        *p++ = *iter;
-        
-    crc = crc32(crc, const_cast<const Bytef *>(srcbuf), srclen);
-    
-    int zerr = compress(destbuf, static_cast<uLongf *>(&destlen), srcbuf, srclen);
-    if (zerr != Z_OK)
-        {
-        printf("Some kind of problem\n");
+        if (zerr != Z_OK && zerr != Z_BUF_ERROR) {
+            printf("deflate: Some kind of problem: %d\n", zerr);
+            break;
         }
+        auto const used = block.data.size() - zs.avail_out;
+        block.data.resize(block.data.size() * 2);
+        zs.next_out = block.data.data() + used;
+        zs.avail_out = block.data.size() - used;
+    }
+    block.data.resize(zs.total_out);
+    deflateEnd(&zs);
+    return block;
+}
 
-    totalOut += destlen;
-    //skip the redundant zlib header and checksum
-    for (uLong i=2; i<destlen-4 ; i++)
-        {
-        destination.put((int)destbuf[i]);
-        }
-        
-    destination.flush();
+/**
+ * Hand the buffered input over for deflating. Files of more than one block are deflated on a
+ * thread pool, if the stream was given more than one thread.
+ */
+void GzipOutputStream::submitBlock(bool last)
+{
+    auto input = std::make_shared<std::vector<unsigned char>>(std::move(inputBuf));
+    inputBuf = {};
+    inputBuf.reserve(BLOCK_SIZE);
+
+    auto block_dictionary = dictionary;
+    dictionary.insert(dictionary.end(), input->begin(), input->end());
+    if (dictionary.size() > DICTIONARY_SIZE) {
+        dictionary.erase(dictionary.begin(), dictionary.end() - DICTIONARY_SIZE);
+    }
+
+    if (!pool && input->size() >= BLOCK_SIZE && numThreads > 1) {
+        pool.emplace(numThreads);
+        // Bounds the memory taken by blocks waiting for their turn.
+        maxPending = 2 * numThreads;
+    }
 
-    inputBuf.clear();
-    delete[] srcbuf;
-    delete[] destbuf;
+    if (!pool) {
+        writeBlock(deflateBlock(*input, block_dictionary, last));
+        return;
+    }
+
+    auto task = std::make_shared<std::packaged_task<Block()>>(
+        [input, block_dictionary = std::move(block_dictionary), last] {
+            return deflateBlock(*input, block_dictionary, last);
+        });
+    pending.push_back(task->get_future());
+    boost::asio::post(*pool, [task] { (*task)(); });
+    writePending(maxPending);
+}
+
+/**
+ * Write out the oldest deflated blocks, until no more than \a max_pending are left.
+ */
+void GzipOutputStream::writePending(std::size_t max_pending)
+{
+    while (pending.size() > max_pending) {
+        writeBlock(pending.front().get());
+        pending.pop_front();
+    }
+}
+
+void GzipOutputStream::writeBlock(Block const &block)
+{
+    crc = crc32_combine(crc, block.crc, block.length);
+    totalOut += block.data.size();
+    for (auto byte : block.data) {
+        destination.put(static_cast<char>(byte));
+    }
 }
 
 
@@ -438,9 +493,33 @@ int GzipOutputStream::put(char ch)
     //Add char to buffer
     inputBuf.push_back(ch);
     totalIn++;
+    if (inputBuf.size() >= BLOCK_SIZE) {
+        submitBlock(false);
+    }
     return 1;
 }
 
+/**
+ * Add a run of bytes to the buffer, a block at a time.
+ */
+void GzipOutputStream::write(char const *data, std::size_t size)
+{
+    if (closed) {
+        return;
+    }
+
+    while (size > 0) {
+        auto const n = std::min(size, BLOCK_SIZE - inputBuf.size());
+        inputBuf.insert(inputBuf.end(), data, data + n);
+        totalIn += n;
+        data += n;
+        size -= n;
+        if (inputBuf.size() >= BLOCK_SIZE) {
+            submitBlock(false);
+        }
+    }
+}
+
 
 
 } // namespace IO
@@ -18,10 +18,18 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <vector>
-#include "inkscapestream.h"
+#include <boost/asio/thread_pool.hpp>
 #include <zlib.h>
 
+#include "inkscapestream.h"
+
 namespace Inkscape
 {
 namespace IO
@@ -34,6 +42,8 @@ namespace IO
 /**
  * This class is for deflating a gzip-compressed InputStream source
  *
+ * Sources that don't fit in one chunk are read and inflated on a thread of their own, a few
+ * chunks ahead of the reader, so that decompressing overlaps with parsing the result.
  */
 class GzipInputStream : public BasicInputStream
 {
@@ -53,21 +63,28 @@ public:
 private:
 
     bool load();
-    int fetchMore();
+    bool readSource();
+    void inflateChunk(std::vector<unsigned char> &chunk);
+    void readAhead();
+    bool nextChunk();
 
     bool loaded;
-    
-    unsigned char *outputBuf;
-    unsigned char *srcBuf;
+    bool sourceEnded;
+    bool inflateEnded;
 
-    unsigned long crc;
-    unsigned long srcCrc;
-    unsigned long srcSiz;
-    unsigned long srcLen;
-    long outputBufPos;
-    long outputBufLen;
+    std::vector<unsigned char> srcBuf;
+    std::vector<unsigned char> outputBuf;
+    std::size_t outputBufPos;
 
     z_stream d_stream;
+
+    // Read-ahead: chunks inflated by the reader thread, waiting for get()
+    std::thread reader;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<std::vector<unsigned char>> chunks;
+    bool readerDone;
+    bool stopReader;
 }; // class GzipInputStream
 
 
@@ -81,13 +98,17 @@ private:
  * This class is for gzip-compressing data going to the
  * destination OutputStream
  *
+ * The data is deflated in blocks which, like pigz does, are compressed independently on a
+ * thread pool, each primed with the end of the block before, and then written out in order.
+ * The number of threads is fixed on construction, since the stream may be used off the main
+ * thread, where the preferences can't be read.
  */
 class GzipOutputStream : public BasicOutputStream
 {
 
 public:
 
-    GzipOutputStream(OutputStream &destinationStream);
+    GzipOutputStream(OutputStream &destinationStream, int num_threads = 1);
     
     ~GzipOutputStream() override;
     
@@ -97,9 +118,30 @@ public:
     
     int put(char ch) override;
 
+    void write(char const *data, std::size_t size) override;
+
 private:
 
+    struct Block
+    {
+        std::vector<unsigned char> data;
+        uLong crc = 0;
+        uLong length = 0;
+    };
+
+    static Block deflateBlock(std::vector<unsigned char> const &input, std::vector<unsigned char> const &dictionary,
+                              bool last);
+    void submitBlock(bool last);
+    void writeBlock(Block const &block);
+    void writePending(std::size_t max_pending);
+
     std::vector<unsigned char> inputBuf;
+    std::vector<unsigned char> dictionary;
+
+    std::optional<boost::asio::thread_pool> pool;
+    std::deque<std::future<Block>> pending;
+    std::size_t maxPending;
+    int numThreads;
 
     long totalIn;
     long totalOut;
@@ -94,6 +94,13 @@ int BasicInputStream::get()
 /**
  *
  */ 
+void OutputStream::write(char const *data, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        put(data[i]);
+    }
+}
+
 BasicOutputStream::BasicOutputStream(OutputStream &destinationStream)
                      : destination(destinationStream)
 {
@@ -469,6 +476,16 @@ void BasicWriter::put(char ch)
         destination->put(ch);
 }
 
+/**
+ * Writes the specified bytes to this output writer, one at a time.
+ */ 
+void BasicWriter::write(char const *data, std::size_t size)
+{
+    for (std::size_t i = 0; i < size; ++i) {
+        put(data[i]);
+    }
+}
+
 /**
  * Provide printf()-like formatting
  */ 
@@ -508,9 +525,7 @@ Writer &BasicWriter::writeUString(const Glib::ustring &str)
  */ 
 Writer &BasicWriter::writeStdString(const std::string &str)
 {
-    for (char it : str) {
-        put(it);
-    }
+    write(str.data(), str.size());
     return *this;
 }
 
@@ -740,6 +755,14 @@ void OutputStreamWriter::put(char ch)
     outputStream.put(ch);
 }
 
+/**
+ *  Pass a block of bytes on to the OutputStream at once.
+ */
+void OutputStreamWriter::write(char const *data, std::size_t size)
+{
+    outputStream.write(data, size);
+}
+
 //#########################################################################
 //# S T D    W R I T E R
 //#########################################################################
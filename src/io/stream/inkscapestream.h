@@ -194,6 +194,12 @@ public:
      */
     virtual int put(char ch) = 0;
 
+    /**
+     * Send \a size bytes to the destination stream. By default they are sent one at a time
+     * with put(); streams that can take a whole block at once override this.
+     */
+    virtual void write(char const *data, std::size_t size);
+
 
 }; // class OutputStream
 
@@ -474,6 +480,9 @@ public:
     virtual void flush() = 0;
     
     virtual void put(char ch) = 0;
+
+    /* Send \a size bytes at once */
+    virtual void write(char const *data, std::size_t size) = 0;
     
     /* Formatted output */
     virtual Writer& printf(char const *fmt, ...) G_GNUC_PRINTF(2,3) = 0;
@@ -528,8 +537,9 @@ public:
     void flush() override;
     
     void put(char ch) override;
-    
-    
+
+    /* Puts the bytes one at a time; overload it too if put() can be bypassed */
+    void write(char const *data, std::size_t size) override;
     
     /* Formatted output */
     Writer &printf(char const *fmt, ...) override G_GNUC_PRINTF(2,3);
@@ -620,6 +630,8 @@ public:
     
     void put(char ch) override;
 
+    void write(char const *data, std::size_t size) override;
+
 
 private:
 
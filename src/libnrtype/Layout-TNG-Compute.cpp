@@ -20,6 +20,7 @@
 #include "object/sp-object.h"
 #include "object/sp-flowdiv.h"
 #include "Layout-TNG-Scanline-Maker.h"
+#include "Layout-TNG-Shaping-Cache.h"
 #include <limits>
 #include "livarot/Shape.h"
 
@@ -67,6 +68,8 @@ class Layout::Calculator
     ScanlineMaker *_scanline_maker;
     unsigned _current_shape_index;     /// index into Layout::_input_wrap_shapes
     PangoContext *_pango_context;
+    PangoGravity _base_gravity;        /// set on _pango_context when itemizing
+    PangoGravityHint _gravity_hint;
     Direction _block_progression;
 
     /**
@@ -177,6 +180,7 @@ class Layout::Calculator
         std::vector<PangoItemInfo> pango_items;
         std::vector<PangoLogAttr> char_attributes;    ///< For every character in the paragraph.
         std::vector<UnbrokenSpan> unbroken_spans;
+        std::shared_ptr<ShapingCache::Paragraph> shaping;   ///< Where the glyphs of this paragraph are kept.
 
         template<typename T> static void free_sequence(T &seq)
         {
@@ -192,6 +196,7 @@ class Layout::Calculator
             free_sequence(input_items);
             free_sequence(pango_items);
             free_sequence(unbroken_spans);
+            shaping.reset();
         }
     };
 
@@ -904,6 +909,7 @@ void Layout::Calculator::_outputLine(ParagraphInfo const &para,
                         } else {
                             // Upright orientation
 
+                            auto const pango_lock = FontFactory::get().lock();
                             auto hb_font = pango_font_get_hb_font(font->get_font());
 
 #ifdef DEBUG_GLYPH
@@ -1331,6 +1337,10 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
 
     TRACE(("itemizing para, first input %d\n", para->first_input_index));
 
+    // Everything that itemizing and shaping depend on, to find the results of an earlier layout
+    // of this or another text.
+    std::string shaping_key;
+
     PangoAttrList *attributes_list = pango_attr_list_new();
     for (unsigned input_index = para->first_input_index ; input_index < _flow._input_stream.size() ; input_index++) {
         if (_flow._input_stream[input_index]->Type() == CONTROL_CODE) {
@@ -1370,16 +1380,58 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
                 PangoAttribute *attribute_language = pango_attr_language_new( language );
                 pango_attr_list_insert(attributes_list, attribute_language);
             }
+
+            char *font_description = pango_font_description_to_string(font->get_descr());
+            shaping_key += font_description;
+            g_free(font_description);
+            shaping_key += '\0';
+            shaping_key += text_source->style->getFontFeatureString();
+            shaping_key += '\0';
+            shaping_key += object->lang.raw();
+            shaping_key += '\0';
+            shaping_key += std::to_string(para->text.bytes());
+            shaping_key += '\n';
+        }
+    }
+
+    bool const has_direction = _flow._input_stream[para->first_input_index]->Type() == TEXT_SOURCE;
+    if (has_direction) {
+        auto text_source = static_cast<Layout::InputStreamTextSource const *>(_flow._input_stream[para->first_input_index]);
+        shaping_key += text_source->style->direction.computed == SP_CSS_DIRECTION_LTR ? 'l' : 'r';
+    }
+    shaping_key += std::to_string(_base_gravity);
+    shaping_key += std::to_string(_gravity_hint);
+    shaping_key += '\n';
+    shaping_key += para->text.raw();
+
+    para->shaping = ShapingCache::get().find(shaping_key);
+    if (para->shaping) {
+        pango_attr_list_unref(attributes_list);
+        para->direction = para->shaping->direction;
+        para->pango_items.reserve(para->shaping->items.size());
+        for (unsigned i = 0 ; i < para->shaping->items.size() ; i++) {
+            PangoItemInfo new_item;
+            new_item.item = pango_item_copy(para->shaping->items[i]);
+            new_item.font = para->shaping->fonts[i];
+            para->pango_items.push_back(new_item);
         }
+        para->char_attributes = para->shaping->char_attributes;
+        TRACE(("para itemization found in the shaping cache\n"));
+        return;
     }
 
     TRACE(("whole para: \"%s\"\n", para->text.data()));
 //    TRACE(("%d input sources used\n", input_index - para->first_input_index));
 
+    // The font context is shared with other threads laying out text at the same time.
+    auto const pango_lock = FontFactory::get().lock();
+    pango_context_set_base_gravity(_pango_context, _base_gravity);
+    pango_context_set_gravity_hint(_pango_context, _gravity_hint);
+
     // Pango Itemize
     GList *pango_items_glist = nullptr;
     para->direction = LEFT_TO_RIGHT; // CSS default
-    if (_flow._input_stream[para->first_input_index]->Type() == TEXT_SOURCE) {
+    if (has_direction) {
         Layout::InputStreamTextSource const *text_source = static_cast<Layout::InputStreamTextSource *>(_flow._input_stream[para->first_input_index]);
 
         para->direction =                (text_source->style->direction.computed == SP_CSS_DIRECTION_LTR) ? LEFT_TO_RIGHT : RIGHT_TO_LEFT;
@@ -1415,6 +1467,15 @@ void  Layout::Calculator::_buildPangoItemizationForPara(ParagraphInfo *para) con
     // This breaks Inkscape's multiline text (i.e. sodipodi:role line).
     para->char_attributes[para->text.length()].is_mandatory_break = 0;
 
+    auto shaping = std::make_shared<ShapingCache::Paragraph>();
+    shaping->direction = para->direction;
+    for (auto const &pango_item : para->pango_items) {
+        shaping->items.push_back(pango_item_copy(pango_item.item));
+        shaping->fonts.push_back(pango_item.font);
+    }
+    shaping->char_attributes = para->char_attributes;
+    para->shaping = ShapingCache::get().insert(shaping_key, std::move(shaping));
+
     TRACE(("end para itemize, direction = %d\n", para->direction));
 }
 
@@ -1588,7 +1649,12 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                 // now we know the length, do some final calculations and add the UnbrokenSpan to the list
                 new_span.font_size = text_source->style->font_size.computed * _flow.getTextLengthMultiplierDue();
                 if (new_span.text_bytes) {
-                    new_span.glyph_string = pango_glyph_string_new();
+                    // Glyphs shaped for the same paragraph in an earlier layout are used as they are.
+                    new_span.glyph_string = para->shaping->findGlyphs(para_text_index, new_span.text_bytes);
+                    bool const shaped = new_span.glyph_string;
+                    if (!shaped) {
+                        new_span.glyph_string = pango_glyph_string_new();
+                    }
                     /* Some assertions intended to help diagnose bug #1277746. */
                     g_assert( 0 < new_span.text_bytes );
                     g_assert( span_start_byte_in_source < text_source->text->bytes() );
@@ -1610,14 +1676,17 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                     assert (gold == gnew);
 
                     // Convert characters to glyphs
-                    pango_shape_full(para->text.data() + para_text_index,
-                                     new_span.text_bytes,
-                                     para->text.data(),
-                                     -1,
-                                     &para->pango_items[pango_item_index].item->analysis,
-                                     new_span.glyph_string);
-
-                    if (para->pango_items[pango_item_index].item->analysis.level & 1) {
+                    if (!shaped) {
+                        auto const pango_lock = FontFactory::get().lock();
+                        pango_shape_full(para->text.data() + para_text_index,
+                                         new_span.text_bytes,
+                                         para->text.data(),
+                                         -1,
+                                         &para->pango_items[pango_item_index].item->analysis,
+                                         new_span.glyph_string);
+                    }
+
+                    if (!shaped && (para->pango_items[pango_item_index].item->analysis.level & 1)) {
                         // Right to left text (Arabic, Hebrew, etc.)
 
                         // pango_shape() will reorder glyphs in rtl sections into visual order
@@ -1716,6 +1785,9 @@ unsigned Layout::Calculator::_buildSpansForPara(ParagraphInfo *para) const
                     // }
                     /* glyphs[].x_offset values are probably out of order within any log_clusters, apparently harmless */
 
+                    if (!shaped) {
+                        para->shaping->addGlyphs(para_text_index, new_span.text_bytes, new_span.glyph_string);
+                    }
 
                     new_span.pango_item_index = pango_item_index;
                     new_span.line_height_multiplier = _computeFontLineHeight(text_source->style);
@@ -2127,24 +2199,24 @@ bool Layout::Calculator::calculate()
         // Vertical text, CJK
         switch (_flow._blockTextOrientation()) {
             case SP_CSS_TEXT_ORIENTATION_MIXED:
-                pango_context_set_base_gravity(_pango_context, PANGO_GRAVITY_EAST);
-                pango_context_set_gravity_hint(_pango_context, PANGO_GRAVITY_HINT_NATURAL);
+                _base_gravity = PANGO_GRAVITY_EAST;
+                _gravity_hint = PANGO_GRAVITY_HINT_NATURAL;
                 break;
             case SP_CSS_TEXT_ORIENTATION_UPRIGHT:
-                pango_context_set_base_gravity(_pango_context, PANGO_GRAVITY_EAST);
-                pango_context_set_gravity_hint(_pango_context, PANGO_GRAVITY_HINT_STRONG);
+                _base_gravity = PANGO_GRAVITY_EAST;
+                _gravity_hint = PANGO_GRAVITY_HINT_STRONG;
                 break;
             case SP_CSS_TEXT_ORIENTATION_SIDEWAYS:
-                pango_context_set_base_gravity(_pango_context, PANGO_GRAVITY_SOUTH);
-                pango_context_set_gravity_hint(_pango_context, PANGO_GRAVITY_HINT_STRONG);
+                _base_gravity = PANGO_GRAVITY_SOUTH;
+                _gravity_hint = PANGO_GRAVITY_HINT_STRONG;
                 break;
             default:
                 std::cerr << "Layout::Calculator: Unhandled text orientation!" << std::endl;
         }
     } else {
         // Horizontal text
-        pango_context_set_base_gravity(_pango_context, PANGO_GRAVITY_AUTO);
-        pango_context_set_gravity_hint(_pango_context, PANGO_GRAVITY_HINT_NATURAL);
+        _base_gravity = PANGO_GRAVITY_AUTO;
+        _gravity_hint = PANGO_GRAVITY_HINT_NATURAL;
     }
 
     // Minimum line box height determined by block container.
@@ -2375,6 +2447,58 @@ void Layout::_calculateCursorShapeForEmpty()
     }
 }
 
+Layout::ShapingCache::Paragraph::~Paragraph()
+{
+    for (auto item : items) {
+        pango_item_free(item);
+    }
+    for (auto const &[key, glyph_string] : _glyphs) {
+        pango_glyph_string_free(glyph_string);
+    }
+}
+
+PangoGlyphString *Layout::ShapingCache::Paragraph::findGlyphs(unsigned offset, unsigned length) const
+{
+    auto lock = std::lock_guard(_glyphs_mutex);
+    auto it = _glyphs.find({offset, length});
+    return it != _glyphs.end() ? pango_glyph_string_copy(it->second) : nullptr;
+}
+
+void Layout::ShapingCache::Paragraph::addGlyphs(unsigned offset, unsigned length, PangoGlyphString *glyphs)
+{
+    auto copy = pango_glyph_string_copy(glyphs);
+    auto lock = std::lock_guard(_glyphs_mutex);
+    if (!_glyphs.emplace(std::make_pair(offset, length), copy).second) {
+        pango_glyph_string_free(copy);
+    }
+}
+
+Layout::ShapingCache::ShapingCache()
+    : _paragraphs(10000) // arbitrary limit for how many paragraphs to keep around
+{}
+
+Layout::ShapingCache &Layout::ShapingCache::get()
+{
+    static ShapingCache cache;
+    return cache;
+}
+
+std::shared_ptr<Layout::ShapingCache::Paragraph> Layout::ShapingCache::find(std::string const &key)
+{
+    auto lock = std::lock_guard(_mutex);
+    if (auto paragraph = _paragraphs.get(key)) {
+        return *paragraph;
+    }
+    return {};
+}
+
+std::shared_ptr<Layout::ShapingCache::Paragraph> Layout::ShapingCache::insert(std::string const &key, std::shared_ptr<Paragraph> paragraph)
+{
+    auto lock = std::lock_guard(_mutex);
+    _paragraphs.insert(key, paragraph);
+    return paragraph;
+}
+
 bool Layout::calculateFlow()
 {
     TRACE(("begin calculateFlow()\n"));
@@ -286,15 +286,14 @@ Geom::Affine glyph_matrix;
         for (unsigned glyph_index = 0 ; glyph_index < _glyphs.size() ; glyph_index++) {
             if (_characters[_glyphs[glyph_index].in_character].in_glyph == -1)continue; //invisible glyphs
             Span const &span = _spans[_characters[_glyphs[glyph_index].in_character].in_span];
-            Geom::PathVector const *pv = span.font->PathVector(_glyphs[glyph_index].glyph);
+            _getGlyphTransformMatrix(glyph_index, &glyph_matrix);
+            auto const pv = span.font->PathVector(_glyphs[glyph_index].glyph, glyph_matrix);
             InputStreamTextSource const *text_source = static_cast<InputStreamTextSource const *>(_input_stream[span.in_input_stream_item]);
             if (pv) {
-                _getGlyphTransformMatrix(glyph_index, &glyph_matrix);
-                Geom::PathVector temp_pv = (*pv) * glyph_matrix;
                 if (!text_source->style->fill.isNone())
-                    ctx->fill(temp_pv, ctm, text_source->style, pbox, dbox, bbox);
+                    ctx->fill(*pv, ctm, text_source->style, pbox, dbox, bbox);
                 if (!text_source->style->stroke.isNone())
-                    ctx->stroke(temp_pv, ctm, text_source->style, pbox, dbox, bbox);
+                    ctx->stroke(*pv, ctm, text_source->style, pbox, dbox, bbox);
             }
         }
     }
@@ -832,10 +831,9 @@ SPCurve Layout::convertToCurves(iterator const &from_glyph, iterator const &to_g
         Span const &span = _glyphs[glyph_index].span(this);
         _getGlyphTransformMatrix(glyph_index, &glyph_matrix);
 
-        Geom::PathVector const *pathv = span.font->PathVector(_glyphs[glyph_index].glyph);
-        if (pathv) {
-            Geom::PathVector pathv_trans = (*pathv) * glyph_matrix;
-            curve.append(SPCurve(std::move(pathv_trans)));
+        // Transformed while it is unpacked from the font's outline.
+        if (auto pathv = span.font->PathVector(_glyphs[glyph_index].glyph, glyph_matrix)) {
+            curve.append(SPCurve(std::move(*pathv)));
         }
     }
 
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::Text::Layout::ShapingCache - itemized and shaped paragraphs shared by layouts
+ *
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef LAYOUT_TNG_SHAPING_CACHE_H
+#define LAYOUT_TNG_SHAPING_CACHE_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/compute/detail/lru_cache.hpp>
+#include <pango/pango.h>
+#include "libnrtype/Layout-TNG.h"
+
+namespace Inkscape {
+namespace Text {
+
+/** \brief private to Layout. The Pango items and glyphs of recently laid out paragraphs.
+
+Itemizing and shaping a paragraph is most of the work of laying it out, and depends only on
+the text of the paragraph and on the fonts, features and language of its text sources; not on
+where its lines end up. Paragraphs are taken from here when one paragraph of a long text is
+edited, and when many text objects hold the same string in the same style, such as the tick
+labels of a chart, so that each is only shaped once.
+
+The cache is shared by all layouts, which may be calculated on several threads. Paragraphs are
+looked up by a key made of everything that itemizing and shaping depend on; see
+Calculator::_buildPangoItemizationForPara().
+*/
+class Layout::ShapingCache
+{
+public:
+    /** The Pango items of a paragraph, and the glyphs its spans were shaped to. The items are
+    only set before the paragraph is inserted; glyphs may be added by any thread. */
+    struct Paragraph
+    {
+        Direction direction;
+        std::vector<PangoItem *> items;
+        std::vector<std::shared_ptr<FontInstance>> fonts;   /// one for each item
+        std::vector<PangoLogAttr> char_attributes;
+
+        Paragraph() = default;
+        Paragraph(Paragraph const &) = delete;
+        Paragraph &operator=(Paragraph const &) = delete;
+        ~Paragraph();
+
+        /** A copy of the glyphs shaped from \a length bytes at \a offset in the paragraph, or null. */
+        PangoGlyphString *findGlyphs(unsigned offset, unsigned length) const;
+        /** Keeps a copy of \a glyphs, shaped from \a length bytes at \a offset in the paragraph. */
+        void addGlyphs(unsigned offset, unsigned length, PangoGlyphString *glyphs);
+
+    private:
+        mutable std::mutex _glyphs_mutex;
+        std::map<std::pair<unsigned, unsigned>, PangoGlyphString *> _glyphs;
+    };
+
+    static ShapingCache &get();
+
+    /** The paragraph stored for \a key, or null. */
+    std::shared_ptr<Paragraph> find(std::string const &key);
+
+    /** Stores \a paragraph for \a key, making room by forgetting the least recently used one
+    if needed. */
+    std::shared_ptr<Paragraph> insert(std::string const &key, std::shared_ptr<Paragraph> paragraph);
+
+private:
+    ShapingCache();
+
+    std::mutex _mutex;
+    boost::compute::detail::lru_cache<std::string, std::shared_ptr<Paragraph>> _paragraphs;
+};
+
+}//namespace Text
+}//namespace Inkscape
+
+#endif
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -152,6 +152,7 @@ public:
     class ScanlineMaker;
     class InfiniteScanlineMaker;
     class ShapeScanlineMaker;
+    class ShapingCache;
 
     Layout();
     virtual ~Layout();
@@ -20,6 +20,7 @@
 
 #include <unordered_map>
 
+#include <glib/gstdio.h>
 #include <glibmm/i18n.h>
 
 #include <fontconfig/fontconfig.h>
@@ -219,7 +220,9 @@ FontFactory::FontFactory()
 
 FontFactory::~FontFactory()
 {
-    loaded.clear();
+    for (auto &shard : loaded) {
+        shard.clear();
+    }
     g_object_unref(fontContext);
     g_object_unref(fontServer);
 }
@@ -229,6 +232,51 @@ void FontFactory::refreshConfig()
     pango_fc_font_map_config_changed(PANGO_FC_FONT_MAP(fontServer));
 }
 
+/**
+ * Returns a checksum of the fontconfig configuration files, font directories and application
+ * font files with their modification times, and of the default language (face names are
+ * localized). Fontconfig itself decides whether its caches are up to date by the directory times.
+ */
+std::string FontFactory::GetFontConfigStamp()
+{
+    std::string data;
+    auto add_file = [&] (char const *filename) {
+        data += filename;
+        GStatBuf st;
+        if (g_stat(filename, &st) == 0) {
+            data += '\t';
+            data += std::to_string(st.st_mtime);
+        }
+        data += '\n';
+    };
+    auto add_files = [&] (FcStrList *list) {
+        if (list) {
+            while (auto filename = FcStrListNext(list)) {
+                add_file(reinterpret_cast<char const *>(filename));
+            }
+            FcStrListDone(list);
+        }
+    };
+
+    auto config = pango_fc_font_map_get_config(PANGO_FC_FONT_MAP(fontServer));
+    add_files(FcConfigGetConfigFiles(config));
+    add_files(FcConfigGetFontDirs(config));
+    if (auto fonts = FcConfigGetFonts(config, FcSetApplication)) {
+        for (int i = 0; i < fonts->nfont; ++i) {
+            FcChar8 *filename = nullptr;
+            if (FcPatternGetString(fonts->fonts[i], FC_FILE, 0, &filename) == FcResultMatch) {
+                add_file(reinterpret_cast<char const *>(filename));
+            }
+        }
+    }
+    data += pango_language_to_string(pango_language_get_default());
+
+    auto checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, data.c_str(), data.size());
+    std::string stamp = checksum;
+    g_free(checksum);
+    return stamp;
+}
+
 Glib::ustring FontFactory::ConstructFontSpecification(PangoFontDescription *font)
 {
     Glib::ustring pangoString;
@@ -592,7 +640,14 @@ std::shared_ptr<FontInstance> FontFactory::Face(PangoFontDescription *descr, boo
     pango_font_description_set_size(descr, fontSize * PANGO_SCALE);
 
     // Check if already loaded.
-    if (auto res = loaded.lookup(descr)) {
+    auto &shard = loaded_shard(descr);
+    if (auto res = shard.lookup(descr)) {
+        return res;
+    }
+
+    // Load it under the Pango lock, unless another thread did so while we waited for it.
+    auto const face_lock = lock();
+    if (auto res = shard.lookup(descr)) {
         return res;
     }
 
@@ -619,7 +674,7 @@ std::shared_ptr<FontInstance> FontFactory::Face(PangoFontDescription *descr, boo
     // Note: The descr of the returned pangofont may differ from what was asked. We use the original as the map key.
     try {
         auto descr_copy = pango_font_description_copy(descr);
-        return loaded.add(
+        return shard.add(
                    descr_copy,
                    std::make_unique<FontInstance>(
                        pango_font_map_load_font(fontServer, fontContext, descr),
@@ -14,7 +14,9 @@
 #include <algorithm>
 #include <utility>
 #include <memory>
+#include <array>
 #include <map>
+#include <mutex>
 
 #include <pango/pango.h>
 #include "style.h"
@@ -63,6 +65,9 @@ public:
     // Refresh pango font configuration
     void refreshConfig();
 
+    /// Identifies the font configuration: which fonts there are, but without listing them.
+    std::string GetFontConfigStamp();
+
     ///< The fontsize used as workaround for hinting.
     static constexpr double fontSize = 512;
 
@@ -102,11 +107,17 @@ public:
     void AddFontFile(char const *utf8file);
 
     PangoContext *get_font_context() const { return fontContext; }
+
+    /// Pango is not thread-safe. Code that may run on other threads than the main one, like text
+    /// layout, holds this lock while it uses the font context, or Pango fonts and items.
+    /// Face() may be called with or without it, and only takes it to load a new face.
+    std::unique_lock<std::recursive_mutex> lock() { return std::unique_lock(mutex); }
     PangoFontDescription *parsePostscriptName(std::string const &name, bool substitute);
 private:
     // Pango data. Backend-specific structures are cast to these opaque types.
     PangoFontMap *fontServer;
     PangoContext *fontContext;
+    std::recursive_mutex mutex;
 
     // A hashmap of all the loaded font instances, indexed by their PangoFontDescription.
     // Note: Since pango already does that, using the PangoFont could work too.
@@ -118,7 +129,17 @@ private:
     {
         bool operator()(PangoFontDescription const *a, PangoFontDescription const *b) const;
     };
-    Inkscape::Util::cached_map<PangoFontDescription*, FontInstance, Hash, Compare> loaded;
+    // The map is split by hash into shards with their own locks, so that threads looking up
+    // faces that are already loaded don't wait for each other or for one being loaded.
+    struct LoadedShard : Inkscape::Util::cached_map<PangoFontDescription*, FontInstance, Hash, Compare>
+    {
+        LoadedShard() : cached_map(4) {} // up to 32 unused faces kept in all
+    };
+    std::array<LoadedShard, 8> loaded;
+    LoadedShard &loaded_shard(PangoFontDescription const *descr)
+    {
+        return loaded[Hash()(descr) % loaded.size()];
+    }
 
     // The following two commented out maps were an attempt to allow Inkscape to use font faces
     // that could not be distinguished by CSS values alone. In practice, they never were that
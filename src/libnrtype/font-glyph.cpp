@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Packed glyph outlines.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "font-glyph.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <utility>
+#include <2geom/path-sink.h>
+
+GlyphOutline::GlyphOutline(std::vector<Verb> verbs, std::vector<long> const &coords, double units_per_em)
+    : _verbs(std::move(verbs))
+{
+    long max = 0;
+    for (auto coord : coords) {
+        max = std::max(max, std::abs(coord));
+    }
+    int shift = 0;
+    while ((max >> shift) > std::numeric_limits<std::int16_t>::max()) {
+        shift++;
+    }
+
+    _coords.reserve(coords.size());
+    for (auto coord : coords) {
+        _coords.push_back(std::lround(std::ldexp(coord, -shift)));
+    }
+    _scale = std::ldexp(1.0, shift) / units_per_em;
+    _verbs.shrink_to_fit();
+}
+
+Geom::PathVector GlyphOutline::toPathVector(Geom::Affine const &transform) const
+{
+    Geom::PathBuilder builder;
+    feed(builder, transform);
+    builder.flush();
+    return builder.peek();
+}
+
+namespace {
+
+/// Finds the exact bounds of the segments fed to it, without building curves.
+struct BoundsSink
+{
+    Geom::OptRect bounds;
+    Geom::Point current;
+    Geom::Point start;
+
+    void add(Geom::Point const &p)
+    {
+        if (bounds) {
+            bounds->expandTo(p);
+        } else {
+            bounds = Geom::Rect(p, p);
+        }
+    }
+
+    void moveTo(Geom::Point const &p)
+    {
+        add(p);
+        current = start = p;
+    }
+
+    void lineTo(Geom::Point const &p)
+    {
+        add(p);
+        current = p;
+    }
+
+    void quadTo(Geom::Point const &c, Geom::Point const &p)
+    {
+        // The derivative is zero at t = (p0 - c) / (p0 - 2c + p) in each dimension.
+        for (auto d : {Geom::X, Geom::Y}) {
+            double const denominator = current[d] - 2 * c[d] + p[d];
+            if (denominator != 0) {
+                addQuadPoint(c, p, (current[d] - c[d]) / denominator);
+            }
+        }
+        add(p);
+        current = p;
+    }
+
+    void curveTo(Geom::Point const &c1, Geom::Point const &c2, Geom::Point const &p)
+    {
+        // The derivative divided by 3 is a t^2 + b t + c in each dimension.
+        for (auto d : {Geom::X, Geom::Y}) {
+            double const a = -current[d] + 3 * c1[d] - 3 * c2[d] + p[d];
+            double const b = 2 * (current[d] - 2 * c1[d] + c2[d]);
+            double const c = c1[d] - current[d];
+            if (a == 0) {
+                if (b != 0) {
+                    addCubicPoint(c1, c2, p, -c / b);
+                }
+                continue;
+            }
+            double const discriminant = b * b - 4 * a * c;
+            if (discriminant >= 0) {
+                double const root = std::sqrt(discriminant);
+                addCubicPoint(c1, c2, p, (-b + root) / (2 * a));
+                addCubicPoint(c1, c2, p, (-b - root) / (2 * a));
+            }
+        }
+        add(p);
+        current = p;
+    }
+
+    void closePath() { current = start; }
+
+    void addQuadPoint(Geom::Point const &c, Geom::Point const &p, double t)
+    {
+        if (t > 0 && t < 1) {
+            double const s = 1 - t;
+            add(s * s * current + 2 * s * t * c + t * t * p);
+        }
+    }
+
+    void addCubicPoint(Geom::Point const &c1, Geom::Point const &c2, Geom::Point const &p, double t)
+    {
+        if (t > 0 && t < 1) {
+            double const s = 1 - t;
+            add(s * s * s * current + 3 * s * s * t * c1 + 3 * s * t * t * c2 + t * t * t * p);
+        }
+    }
+};
+
+} // namespace
+
+Geom::OptRect GlyphOutline::bounds(Geom::Affine const &transform) const
+{
+    BoundsSink sink;
+    feed(sink, transform);
+    return sink.bounds;
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4 :
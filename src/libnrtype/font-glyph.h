@@ -10,8 +10,103 @@
 #ifndef LIBNRTYPE_FONT_GLYPH_H
 #define LIBNRTYPE_FONT_GLYPH_H
 
+#include <cstdint>
 #include <memory>
+#include <vector>
+#include <2geom/affine.h>
 #include <2geom/pathvector.h>
+#include <2geom/rect.h>
+#include <2geom/transforms.h>
+
+/**
+ * A glyph outline, packed into flat arrays of verbs and of points in font units.
+ *
+ * A Geom::PathVector allocates every curve on its own, which adds up to hundreds of MB for the
+ * glyphs of large CJK fonts. The outline is instead fed straight to whatever draws or measures
+ * it, and only turned into a PathVector when one is needed, e.g. for text to path.
+ *
+ * All contours are closed, as FreeType gives them.
+ */
+class GlyphOutline
+{
+public:
+    /// Segment kinds, taking one, one, two and three points respectively.
+    enum Verb : std::uint8_t
+    {
+        MOVE_TO,
+        LINE_TO,
+        QUAD_TO,
+        CUBIC_TO
+    };
+
+    GlyphOutline() = default;
+
+    /**
+     * Pack an outline. \a coords holds the x and y of the points taken by \a verbs, in font
+     * units of size 1 / \a units_per_em. Coordinates outside the 16-bit range are quantised
+     * more coarsely, which doesn't happen with TrueType or CFF fonts.
+     */
+    GlyphOutline(std::vector<Verb> verbs, std::vector<long> const &coords, double units_per_em);
+
+    bool empty() const { return _verbs.empty(); }
+
+    /**
+     * Feed the outline, in em units and transformed by \a transform, to \a sink, which has the
+     * moveTo(), lineTo(), quadTo(), curveTo() and closePath() of a Geom::PathBuilder.
+     */
+    template <typename Sink>
+    void feed(Sink &sink, Geom::Affine const &transform = Geom::identity()) const
+    {
+        auto const m = Geom::Scale(_scale) * transform;
+        auto coord = _coords.begin();
+        auto next = [&] {
+            auto const p = Geom::Point(coord[0], coord[1]) * m;
+            coord += 2;
+            return p;
+        };
+
+        bool open = false;
+        for (auto verb : _verbs) {
+            switch (verb) {
+                case MOVE_TO:
+                    if (open) {
+                        sink.closePath();
+                    }
+                    sink.moveTo(next());
+                    open = true;
+                    break;
+                case LINE_TO:
+                    sink.lineTo(next());
+                    break;
+                case QUAD_TO: {
+                    auto const c = next();
+                    sink.quadTo(c, next());
+                    break;
+                }
+                case CUBIC_TO: {
+                    auto const c1 = next();
+                    auto const c2 = next();
+                    sink.curveTo(c1, c2, next());
+                    break;
+                }
+            }
+        }
+        if (open) {
+            sink.closePath();
+        }
+    }
+
+    /// The outline as a path vector, in em units transformed by \a transform.
+    Geom::PathVector toPathVector(Geom::Affine const &transform = Geom::identity()) const;
+
+    /// The exact bounds of the outline, in em units transformed by \a transform.
+    Geom::OptRect bounds(Geom::Affine const &transform = Geom::identity()) const;
+
+private:
+    std::vector<Verb> _verbs;
+    std::vector<std::int16_t> _coords;
+    double _scale = 1.0; ///< Size of a stored unit in em
+};
 
 // The info for a glyph in a font. It's totally resolution- and fontsize-independent.
 struct FontGlyph
@@ -19,7 +114,7 @@ struct FontGlyph
     double h_advance, h_width; // width != advance because of kerning adjustements
     double v_advance, v_width;
     double bbox[4];            // bbox of the path (and the artbpath), not the bbox of the glyph as the fonts sometimes contain outline as a livarot Path
-    Geom::PathVector pathvector; // outline as 2geom pathvector, for text->curve stuff (should be unified with livarot)
+    GlyphOutline outline;      // outline, for drawing and text->curve stuff
 };
 
 #endif // LIBNRTYPE_FONT_GLYPH_H
@@ -45,59 +45,49 @@
 
 struct FT2GeomData
 {
-    FT2GeomData(Geom::PathBuilder &b, double s)
-        : builder(b)
-        , last(0, 0)
-        , scale(s)
+    std::vector<GlyphOutline::Verb> verbs;
+    std::vector<long> coords;
+
+    void add(GlyphOutline::Verb verb, FT_Vector const *to)
     {
+        verbs.push_back(verb);
+        coords.push_back(to->x);
+        coords.push_back(to->y);
     }
-
-    Geom::PathBuilder &builder;
-    Geom::Point last;
-    double scale;
 };
 
-// outline as returned by freetype
+// outline as returned by freetype; the points are kept in font units and packed in LoadGlyph()
 static int ft2_move_to(FT_Vector const *to, void * i_user)
 {
     FT2GeomData *user = (FT2GeomData*)i_user;
-    Geom::Point p(to->x, to->y);
-    //    printf("m  t=%f %f\n",p[0],p[1]);
-    user->builder.moveTo(p * user->scale);
-    user->last = p;
+    user->add(GlyphOutline::MOVE_TO, to);
     return 0;
 }
 
 static int ft2_line_to(FT_Vector const *to, void *i_user)
 {
     FT2GeomData *user = (FT2GeomData*)i_user;
-    Geom::Point p(to->x, to->y);
-    //    printf("l  t=%f %f\n",p[0],p[1]);
-    user->builder.lineTo(p * user->scale);
-    user->last = p;
+    user->add(GlyphOutline::LINE_TO, to);
     return 0;
 }
 
 static int ft2_conic_to(FT_Vector const *control, FT_Vector const *to, void *i_user)
 {
     FT2GeomData *user = (FT2GeomData*)i_user;
-    Geom::Point p(to->x, to->y), c(control->x, control->y);
-    user->builder.quadTo(c * user->scale, p * user->scale);
-    //    printf("b c=%f %f  t=%f %f\n",c[0],c[1],p[0],p[1]);
-    user->last = p;
+    user->add(GlyphOutline::QUAD_TO, control);
+    user->coords.push_back(to->x);
+    user->coords.push_back(to->y);
     return 0;
 }
 
 static int ft2_cubic_to(FT_Vector const *control1, FT_Vector const *control2, FT_Vector const *to, void *i_user)
 {
     FT2GeomData *user = (FT2GeomData*)i_user;
-    Geom::Point p(to->x, to->y);
-    Geom::Point c1(control1->x, control1->y);
-    Geom::Point c2(control2->x, control2->y);
-    //    printf("c c1=%f %f  c2=%f %f   t=%f %f\n",c1[0],c1[1],c2[0],c2[1],p[0],p[1]);
-    //user->theP->CubicTo(p,3*(c1-user->last),3*(p-c2));
-    user->builder.curveTo(c1 * user->scale, c2 * user->scale, p * user->scale);
-    user->last = p;
+    user->add(GlyphOutline::CUBIC_TO, control1);
+    for (auto p : {control2, to}) {
+        user->coords.push_back(p->x);
+        user->coords.push_back(p->y);
+    }
     return 0;
 }
 
@@ -390,11 +380,16 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
         return nullptr; // bitmap font
     }
 
-    if (auto it = data->glyphs.find(glyph_id); it != data->glyphs.end()) {
-        return it->second.get(); // already loaded
+    auto &shard = data->glyph_shard(glyph_id);
+    {
+        auto lock = std::shared_lock(shard.mutex);
+        if (auto it = shard.glyphs.find(glyph_id); it != shard.glyphs.end()) {
+            return it->second.get(); // already loaded
+        }
     }
 
-    Geom::PathBuilder path_builder;
+    // Another thread may be loading the same glyph; whichever comes second keeps the first one.
+    auto face_lock = std::unique_lock(face_mutex);
 
     auto n_g = std::make_unique<FontGlyph>();
     n_g->bbox[0] = n_g->bbox[1] = n_g->bbox[2] = n_g->bbox[3] = 0.0;
@@ -434,22 +429,13 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
             ft2_cubic_to,
             0, 0
         };
-        FT2GeomData user(path_builder, 1.0 / face->units_per_EM);
+        FT2GeomData user;
         FT_Outline_Decompose(&face->glyph->outline, &ft2_outline_funcs, &user);
+        n_g->outline = GlyphOutline(std::move(user.verbs), user.coords, face->units_per_EM);
     }
 
-    path_builder.flush();
-
-    Geom::PathVector pv = path_builder.peek();
-
-    // close all paths
-    for (auto &i : pv) {
-        i.close();
-    }
-
-    if (!pv.empty()) {
-        n_g->pathvector = std::move(pv);
-        Geom::OptRect bounds = bounds_exact(n_g->pathvector);
+    if (!n_g->outline.empty()) {
+        Geom::OptRect bounds = n_g->outline.bounds();
         if (bounds) {
             n_g->bbox[0] = bounds->left();
             n_g->bbox[1] = bounds->top();
@@ -458,7 +444,10 @@ FontGlyph const *FontInstance::LoadGlyph(int glyph_id)
         }
     }
 
-    auto ret = data->glyphs.emplace(glyph_id, std::move(n_g));
+    face_lock.unlock();
+
+    auto lock = std::unique_lock(shard.mutex);
+    auto ret = shard.glyphs.emplace(glyph_id, std::move(n_g));
 
     return ret.first->second.get();
 }
@@ -516,14 +505,24 @@ Geom::OptRect FontInstance::BBox(int glyph_id)
     return Geom::Rect(rmin, rmax);
 }
 
-Geom::PathVector const *FontInstance::PathVector(int glyph_id)
+GlyphOutline const *FontInstance::Outline(int glyph_id)
 {
     auto g = LoadGlyph(glyph_id);
     if (!g) {
         return nullptr;
     }
 
-    return &g->pathvector;
+    return &g->outline;
+}
+
+std::optional<Geom::PathVector> FontInstance::PathVector(int glyph_id, Geom::Affine const &transform)
+{
+    auto g = LoadGlyph(glyph_id);
+    if (!g) {
+        return {};
+    }
+
+    return g->outline.toPathVector(transform);
 }
 
 Inkscape::Pixbuf const *FontInstance::PixBuf(int glyph_id)
@@ -10,7 +10,10 @@
 #ifndef LIBNRTYPE_FONT_INSTANCE_H
 #define LIBNRTYPE_FONT_INSTANCE_H
 
+#include <array>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 #include <optional>
 #include <unordered_map>
@@ -57,13 +60,17 @@ public:
 
     // Loads the given glyph's info. Glyphs are lazy-loaded, but never unloaded or modified
     // as long as the FontInstance still exists. Pointers to FontGlyphs also remain valid.
+    // May be called from any thread, as may the functions below that use it.
     FontGlyph const *LoadGlyph(int glyph_id);
 
     // nota: all coordinates returned by these functions are on a [0..1] scale; you need to multiply
     // by the fontsize to get the real sizes
 
-    // Return 2geom pathvector for glyph. Deallocated when font instance dies.
-    Geom::PathVector const *PathVector(int glyph_id);
+    // Return the packed outline of a glyph. Deallocated when font instance dies.
+    GlyphOutline const *Outline(int glyph_id);
+
+    // Return 2geom pathvector for glyph, transformed by the given matrix. Built on each call.
+    std::optional<Geom::PathVector> PathVector(int glyph_id, Geom::Affine const &transform = Geom::identity());
 
     // Return font has SVG OpenType enties.
     bool                  FontHasSVG() const { return data->openTypeSVGGlyphs.size() > 0; };
@@ -74,14 +81,12 @@ public:
 
     // Return pixbuf of SVG glyph or nullptr if no SVG glyph exists. As with glyphs, pixbufs
     // are lazy-loaded but immutable once loaded. They are guaranteed to be in Cairo pixel format.
+    // Unlike glyphs, they must be loaded on the main thread.
     Inkscape::Pixbuf const *PixBuf(int glyph_id);
 
     // Horizontal advance if 'vertical' is false, vertical advance if true.
     double Advance(int glyph_id, bool vertical);
 
-    // Return a shared pointer that will keep alive the pathvector and pixbuf data, but nothing else.
-    std::shared_ptr<void const> share_data() const { return data; }
-
     double        GetTypoAscent()  const { return _ascent; }
     double        GetTypoDescent() const { return _descent; }
     double        GetXHeight()     const { return _xheight; }
@@ -129,6 +134,9 @@ private:
     // as long as p_font is valid, face is too
     FT_Face face;
 
+    // FreeType faces must not be used by several threads at once.
+    std::mutex face_mutex;
+
     /*
      * Metrics
      */
@@ -163,8 +171,19 @@ private:
          * Glyphs
          */
 
-        // Lookup table mapping pango glyph ids to glyphs.
-        std::unordered_map<int, std::unique_ptr<FontGlyph const>> glyphs;
+        // Lookup tables mapping pango glyph ids to glyphs, split by glyph id so that threads
+        // looking up different glyphs don't wait for each other.
+        struct GlyphShard
+        {
+            std::shared_mutex mutex;
+            std::unordered_map<int, std::unique_ptr<FontGlyph const>> glyphs;
+        };
+        std::array<GlyphShard, 8> glyph_shards;
+
+        GlyphShard &glyph_shard(int glyph_id)
+        {
+            return glyph_shards[static_cast<unsigned>(glyph_id) % glyph_shards.size()];
+        }
     };
 
     std::shared_ptr<Data> data;
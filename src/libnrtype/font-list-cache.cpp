@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * On-disk cache of the font families and styles shown in the UI.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "font-list-cache.h"
+
+#include <fstream>
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+#include <glibmm/stringutils.h>
+
+namespace Inkscape {
+
+namespace {
+
+/// First line of the cache; change the version whenever the format changes.
+constexpr char const *FONT_LIST_CACHE_HEADER = "# Inkscape font list 1";
+
+// Names are escaped, so that tabs and line breaks can separate them.
+std::string escape(Glib::ustring const &name)
+{
+    return Glib::strescape(name.raw());
+}
+
+std::string unescape(std::string const &name)
+{
+    return Glib::strcompress(name);
+}
+
+} // namespace
+
+FontListCache::FontListCache(std::string path)
+    : _path(std::move(path))
+{}
+
+std::string FontListCache::default_path()
+{
+    return Glib::build_filename(Glib::get_user_cache_dir(), "inkscape", "font-list");
+}
+
+/*
+ * The file holds the stamp, then one line per family:
+ *   F <family>
+ * and for each family with known styles, a line followed by one line per style:
+ *   S <family>
+ *   s <css name> <display name>
+ * with tabs between the fields.
+ */
+bool FontListCache::load(std::string const &stamp)
+{
+    _stamp.clear();
+    _families.clear();
+    _styles.clear();
+    _modified = false;
+
+    std::ifstream file(_path);
+    std::string line;
+    if (!std::getline(file, line) || line != FONT_LIST_CACHE_HEADER ||
+        !std::getline(file, line) || line != stamp) {
+        return false;
+    }
+
+    std::vector<std::string> families;
+    std::unordered_map<std::string, Styles> styles;
+    Styles *current = nullptr;
+    while (std::getline(file, line)) {
+        if (line.size() < 2 || line[1] != '\t') {
+            return false;
+        }
+        auto const fields = line.substr(2);
+        switch (line[0]) {
+            case 'F':
+                families.push_back(unescape(fields));
+                break;
+            case 'S':
+                current = &styles[unescape(fields)];
+                break;
+            case 's': {
+                auto const tab = fields.find('\t');
+                if (!current || tab == std::string::npos) {
+                    return false;
+                }
+                current->emplace_back(unescape(fields.substr(0, tab)), unescape(fields.substr(tab + 1)));
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    _stamp = stamp;
+    _families = std::move(families);
+    _styles = std::move(styles);
+    return true;
+}
+
+void FontListCache::reset(std::string stamp, std::vector<std::string> families)
+{
+    _stamp = std::move(stamp);
+    _families = std::move(families);
+    _styles.clear();
+    _modified = true;
+}
+
+FontListCache::Styles const *FontListCache::get_styles(std::string const &family) const
+{
+    auto it = _styles.find(family);
+    return it != _styles.end() ? &it->second : nullptr;
+}
+
+void FontListCache::set_styles(std::string const &family, Styles styles)
+{
+    _styles.insert_or_assign(family, std::move(styles));
+    _modified = true;
+}
+
+void FontListCache::save()
+{
+    if (!_modified || _stamp.empty()) {
+        return;
+    }
+
+    g_mkdir_with_parents(Glib::path_get_dirname(_path).c_str(), 0755);
+    auto const tmp_path = _path + ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::trunc);
+        file << FONT_LIST_CACHE_HEADER << '\n' << _stamp << '\n';
+        for (auto const &family : _families) {
+            file << "F\t" << escape(family) << '\n';
+        }
+        for (auto const &[family, styles] : _styles) {
+            file << "S\t" << escape(family) << '\n';
+            for (auto const &style : styles) {
+                file << "s\t" << escape(style.css_name) << '\t' << escape(style.display_name) << '\n';
+            }
+        }
+        if (!file.flush()) {
+            g_warning("Could not write the font list cache '%s'", tmp_path.c_str());
+            return;
+        }
+    }
+    if (g_rename(tmp_path.c_str(), _path.c_str()) != 0) {
+        g_warning("Could not write the font list cache '%s'", _path.c_str());
+        g_unlink(tmp_path.c_str());
+        return;
+    }
+    _modified = false;
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8 :
@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * On-disk cache of the font families and styles shown in the UI.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef LIBNRTYPE_FONT_LIST_CACHE_H
+#define LIBNRTYPE_FONT_LIST_CACHE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "font-factory.h"
+
+namespace Inkscape {
+
+/**
+ * The family names of the system fonts, and the UI style names of the families that were used,
+ * as found by FontFactory::GetUIFamilies() and FontFactory::GetUIStyles().
+ *
+ * Listing the fonts through Pango makes fontconfig look at every installed font, which takes
+ * seconds on systems with thousands of them. The cache is only valid for the font configuration
+ * it was made with, identified by FontFactory::GetFontConfigStamp().
+ */
+class FontListCache
+{
+public:
+    using Styles = std::vector<StyleNames>;
+
+    explicit FontListCache(std::string path);
+
+    /// The cache file in the user's cache directory.
+    static std::string default_path();
+
+    /// Read the cache file. Returns false, leaving the cache empty, unless it was made for \a stamp.
+    bool load(std::string const &stamp);
+
+    /// Start over for the configuration \a stamp, with the given families and no styles.
+    void reset(std::string stamp, std::vector<std::string> families);
+
+    std::vector<std::string> const &get_families() const { return _families; }
+
+    /// The styles of \a family, or null if they were never stored.
+    Styles const *get_styles(std::string const &family) const;
+    void set_styles(std::string const &family, Styles styles);
+
+    /// Write the cache file if anything changed.
+    void save();
+
+private:
+    std::string _path;
+    std::string _stamp;
+    std::vector<std::string> _families;
+    std::unordered_map<std::string, Styles> _styles;
+    bool _modified = false;
+};
+
+} // namespace Inkscape
+
+#endif // LIBNRTYPE_FONT_LIST_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8 :
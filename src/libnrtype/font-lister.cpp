@@ -19,6 +19,7 @@
 
 #include "font-lister.h"
 
+#include <glibmm/main.h>
 #include <glibmm/markup.h>
 #include <glibmm/regex.h>
 #include <gtkmm/cellrenderertext.h>
@@ -26,6 +27,7 @@
 #include <libnrtype/font-instance.h>
 
 #include "font-factory.h"
+#include "font-list-cache.h"
 #include "desktop.h"
 #include "desktop-style.h"
 #include "document.h"
@@ -67,8 +69,17 @@ FontLister::FontLister()
         {"Bold Italic"}
     });
 
-    pango_family_map = FontFactory::get().GetUIFamilies();
-    init_font_families();
+    font_list_cache = std::make_unique<FontListCache>(FontListCache::default_path());
+    load_font_families(false);
+
+    // Only the first families are listed right away, the others while idle.
+    init_font_families(-1, FONT_FAMILIES_GROUP_SIZE);
+    if (families_listed < (int)pango_family_map.size()) {
+        font_list_fill = Glib::signal_idle().connect([this] {
+            init_font_families(families_listed, FONT_FAMILIES_GROUP_SIZE);
+            return families_listed < (int)pango_family_map.size();
+        }, Glib::PRIORITY_LOW);
+    }
 
     style_list_store = Gtk::ListStore::create(font_style_list);
     init_default_styles();
@@ -77,7 +88,7 @@ FontLister::FontLister()
     if (auto settings = Gtk::Settings::get_default()) {
         settings->property_gtk_fontconfig_timestamp().signal_changed().connect([this]() {
             FontFactory::get().refreshConfig();
-            pango_family_map = FontFactory::get().GetUIFamilies();
+            load_font_families(true);
             init_font_families(-1);
             new_fonts_signal.emit();
         });
@@ -86,11 +97,98 @@ FontLister::FontLister()
 
 FontLister::~FontLister() = default;
 
+/**
+ * Sets up pango_family_map, from the font list cache if it was made for the current font
+ * configuration. Otherwise, or if \a refresh is set, the families are listed by Pango, which is
+ * slow with many fonts, and the cache is made anew.
+ */
+void FontLister::load_font_families(bool refresh)
+{
+    auto &factory = FontFactory::get();
+    auto stamp = factory.GetFontConfigStamp();
+
+    if (!refresh && font_list_cache->load(stamp)) {
+        pango_family_map.clear();
+        for (auto const &family : font_list_cache->get_families()) {
+            pango_family_map.emplace(family, nullptr);
+        }
+        families_resolved = false;
+        return;
+    }
+
+    pango_family_map = factory.GetUIFamilies();
+    families_resolved = true;
+
+    std::vector<std::string> families;
+    families.reserve(pango_family_map.size());
+    for (auto const &key_val : pango_family_map) {
+        families.push_back(key_val.first);
+    }
+    font_list_cache->reset(std::move(stamp), std::move(families));
+    font_list_cache->save();
+}
+
+/**
+ * Returns the PangoFontFamily of a system font family, or null if there is no such family.
+ * The first call lists the families through Pango if they came from the cache.
+ */
+PangoFontFamily *FontLister::get_pango_family(std::string const &family)
+{
+    if (!families_resolved) {
+        for (auto const &[name, pango_family] : FontFactory::get().GetUIFamilies()) {
+            if (auto it = pango_family_map.find(name); it != pango_family_map.end()) {
+                it->second = pango_family;
+            }
+        }
+        families_resolved = true;
+    }
+
+    auto it = pango_family_map.find(family);
+    return it != pango_family_map.end() ? it->second : nullptr;
+}
+
+/**
+ * Returns the styles of a system font family, from the font list cache if they are in there.
+ * Otherwise they are asked from Pango and added to the cache, which is written once idle.
+ */
+std::shared_ptr<FontLister::Styles> FontLister::get_system_styles(Glib::ustring const &family,
+                                                                 PangoFontFamily *pango_family)
+{
+    if (auto styles = font_list_cache->get_styles(family.raw())) {
+        return std::make_shared<Styles>(*styles);
+    }
+
+    if (!pango_family) {
+        pango_family = get_pango_family(family.raw());
+    }
+    if (!pango_family) {
+        return default_styles;
+    }
+
+    auto styles = std::make_shared<Styles>(FontFactory::get().GetUIStyles(pango_family));
+    font_list_cache->set_styles(family.raw(), *styles);
+    if (!font_list_cache_save) {
+        font_list_cache_save = Glib::signal_idle().connect([this] {
+            font_list_cache->save();
+            return false;
+        }, Glib::PRIORITY_LOW);
+    }
+    return styles;
+}
+
 bool FontLister::font_installed_on_system(Glib::ustring const &font) const
 {
     return pango_family_map.find(font) != pango_family_map.end();
 }
 
+/**
+ * Lists the system fonts in the font list.
+ *
+ * @param group_offset If not positive, the list is cleared first and filled from the first
+ *                     family (0 also inserts "sans-serif"); otherwise, the index in
+ *                     pango_family_map to continue from.
+ * @param group_size   How many families to add, or -1 for all of the remaining ones.
+ */
 void FontLister::init_font_families(int group_offset, int group_size)
 {
     static bool first_call = true;
@@ -102,15 +200,24 @@ void FontLister::init_font_families(int group_offset, int group_size)
     }
 
     if (group_offset <= 0) {
+        // Filling the whole list supersedes the one in progress.
+        if (group_size < 0) {
+            font_list_fill.disconnect();
+        }
         font_list_store->clear();
         if (group_offset == 0)
             insert_font_family("sans-serif");
+        group_offset = 0;
     }
 
     font_list_store->freeze_notify();
 
     // Traverse through the family names and set up the list store
-    for (auto const &key_val : pango_family_map) {
+    auto it = pango_family_map.begin();
+    std::advance(it, std::min<std::size_t>(group_offset, pango_family_map.size()));
+    int index = group_offset;
+    for (; it != pango_family_map.end() && (group_size < 0 || index < group_offset + group_size); ++it, ++index) {
+        auto const &key_val = *it;
         if (!key_val.first.empty()) {
             auto row = *font_list_store->append();
             row[font_list.family] = key_val.first;
@@ -122,10 +229,19 @@ void FontLister::init_font_families(int group_offset, int group_size)
             row[font_list.onSystem] = true;
         }
     }
+    families_listed = index;
 
     font_list_store->thaw_notify();
 }
 
+void FontLister::finish_font_list()
+{
+    if (font_list_fill) {
+        font_list_fill.disconnect();
+        init_font_families(families_listed, -1);
+    }
+}
+
 void FontLister::init_default_styles()
 {
     // Initialize style store with defaults
@@ -147,7 +263,7 @@ std::string FontLister::get_font_count_label() const
     int size = font_list_store->children().size();
     int total_families = get_font_families_size();
 
-    if (size >= total_families) {
+    if (size >= total_families || font_list_fill) {
         label += _("All Fonts");
     } else {
         label += _("Fonts ");
@@ -179,6 +295,8 @@ bool FontLister::find_string_case_insensitive(std::string const &text, std::stri
 
 void FontLister::show_results(Glib::ustring const &search_text)
 {
+    finish_font_list();
+
     // Clear currently selected collections.
     Inkscape::FontCollections::get()->clear_selected_collections();
 
@@ -221,6 +339,8 @@ void FontLister::show_results(Glib::ustring const &search_text)
 
 void FontLister::apply_collections(std::set <Glib::ustring>& selected_collections)
 {
+    finish_font_list();
+
     // Get the master set of fonts present in all the selected collections.
     std::set <Glib::ustring> fonts;
 
@@ -286,8 +406,8 @@ void FontLister::ensureRowStyles(Gtk::TreeModel::iterator iter)
         return;
     }
 
-    if (row[font_list.pango_family]) {
-        row[font_list.styles] = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+    if (row[font_list.onSystem]) {
+        row[font_list.styles] = get_system_styles(row[font_list.family], row[font_list.pango_family]);
     } else {
         row[font_list.styles] = default_styles;
     }
@@ -367,6 +487,7 @@ Glib::ustring FontLister::get_font_family_markup(Gtk::TreeModel::const_iterator
 // Used to insert a font that was not in the document and not on the system into the font list.
 void FontLister::insert_font_family(Glib::ustring const &new_family)
 {
+    finish_font_list();
     auto styles = default_styles;
 
     // In case this is a fallback list, check if first font-family on system.
@@ -377,7 +498,7 @@ void FontLister::insert_font_family(Glib::ustring const &new_family)
 
             if (row[font_list.onSystem] && familyNamesAreEqual(tokens[0], row[font_list.family])) {
                 if (!row_styles) {
-                    row_styles = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+                    row_styles = get_system_styles(row[font_list.family], row[font_list.pango_family]);
                 }
                 styles = row_styles;
                 break;
@@ -400,6 +521,7 @@ void FontLister::insert_font_family(Glib::ustring const &new_family)
 
 int FontLister::add_document_fonts_at_top(SPDocument *document)
 {
+    finish_font_list();
     if (!document) {
         return 0;
     }
@@ -661,6 +783,7 @@ std::pair<Glib::ustring, Glib::ustring> FontLister::ui_from_fontspec(Glib::ustri
  */
 void FontLister::font_family_row_update(int start)
 {
+    finish_font_list();
     if (this->current_family_row > -1 && start > -1) {
         int length = this->font_list_store->children().size();
         for (int i = 0; i < length; ++i) {
@@ -774,6 +897,7 @@ void FontLister::set_fontspec(Glib::ustring const &new_fontspec, bool /*check*/)
 // TODO: create new function new_font_family(Gtk::TreeModel::iterator iter)
 std::pair<Glib::ustring, Glib::ustring> FontLister::new_font_family(Glib::ustring const &new_family, bool /*check_style*/)
 {
+    finish_font_list();
 #ifdef DEBUG_FONT
     std::cout << "\n!!!!!!!!!!!!!!!!!!!!!!!!!!!!!" << std::endl;
     std::cout << "FontLister::new_font_family: " << new_family << std::endl;
@@ -798,7 +922,7 @@ std::pair<Glib::ustring, Glib::ustring> FontLister::new_font_family(Glib::ustrin
         if (familyNamesAreEqual(new_family, row[font_list.family])) {
             auto row_styles = row.get_value(font_list.styles);
             if (!row_styles) {
-                row_styles = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+                row_styles = get_system_styles(row[font_list.family], row[font_list.pango_family]);
             }
             styles = std::move(row_styles);
             break;
@@ -1084,6 +1208,7 @@ Glib::ustring FontLister::fontspec_from_style(SPStyle *style) const
 
 Gtk::TreeModel::Row FontLister::get_row_for_font(Glib::ustring const &family)
 {
+    finish_font_list();
     for (auto const &row : font_list_store->children()) {
         if (familyNamesAreEqual(family, row[font_list.family])) {
             return row;
@@ -1200,7 +1325,7 @@ Glib::ustring FontLister::get_best_style_match(Glib::ustring const &family, Glib
 
     auto styles = default_styles;
     if (row[font_list.onSystem] && !row.get_value(font_list.styles)) {
-        row[font_list.styles] = std::make_shared<Styles>(FontFactory::get().GetUIStyles(row[font_list.pango_family]));
+        row[font_list.styles] = get_system_styles(row[font_list.family], row[font_list.pango_family]);
         styles = row[font_list.styles];
     }
 
@@ -33,6 +33,8 @@
 #include <gtkmm/treemodelcolumn.h>
 #include <gtkmm/treepath.h>
 
+#include "helper/auto-connection.h"
+
 inline constexpr int FONT_FAMILIES_GROUP_SIZE = 30;
 
 class SPObject;
@@ -47,6 +49,8 @@ class CellRenderer;
 
 namespace Inkscape {
 
+class FontListCache;
+
 /**
  *  This class enumerates fonts using libnrtype into reusable data stores and
  *  allows for random access to the font-family list and the font-style list.
@@ -145,6 +149,8 @@ public:
     /**
      * The list of fonts, sorted by the order they will appear in the UI.
      * Also used to give log-time access to each font's PangoFontFamily, owned by the FontFactory.
+     * When the list comes from the font list cache, the PangoFontFamily is null until
+     * get_pango_family() asks Pango for the families.
      */
     std::map<std::string, PangoFontFamily *> pango_family_map;
 
@@ -334,6 +340,12 @@ public:
     void init_default_styles();
     std::string get_font_count_label() const;
 
+    /**
+     * The font list is filled in groups while idle after startup; this adds the remaining system
+     * fonts now, for code which searches the list.
+     */
+    void finish_font_list();
+
 private:
     FontLister();
     ~FontLister();
@@ -342,6 +354,21 @@ private:
 
     void font_family_row_update(int start = 0);
 
+    void load_font_families(bool refresh);
+    PangoFontFamily *get_pango_family(std::string const &family);
+    std::shared_ptr<Styles> get_system_styles(Glib::ustring const &family, PangoFontFamily *pango_family);
+
+    /// Family and style names saved between sessions.
+    std::unique_ptr<FontListCache> font_list_cache;
+    auto_connection font_list_cache_save;
+
+    /// Whether pango_family_map holds the PangoFontFamily of each family.
+    bool families_resolved = false;
+
+    /// How far init_font_families() got in pango_family_map, and its pending idle continuation.
+    int families_listed = 0;
+    auto_connection font_list_fill;
+
     Glib::RefPtr<Gtk::ListStore> font_list_store;
     Glib::RefPtr<Gtk::ListStore> style_list_store;
 
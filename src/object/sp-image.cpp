@@ -41,6 +41,7 @@
 #include "display/curve.h"
 #include "xml/quote.h"
 #include "xml/href-attribute-helper.h"
+#include "util/threading.h"
 
 #include "color/cms-system.h"
 #include "color-profile.h"
@@ -277,26 +278,13 @@ void SPImage::apply_profile(Inkscape::Pixbuf *pixbuf) {
                         intent = INTENT_PERCEPTUAL;
                 }
                                 
-                cmsHPROFILE destProf = cmsCreate_sRGBProfile();
-                cmsHTRANSFORM transf = cmsCreateTransform( prof,
-                                                           TYPE_RGBA_8,
-                                                           destProf,
-                                                           TYPE_RGBA_8,
-                                                           intent, 0 );
-                if ( transf ) {
-                    guchar* currLine = px;
-                    for ( int y = 0; y < imageheight; y++ ) {
-                        // Since the types are the same size, we can do the transformation in-place
-                        cmsDoTransform( transf, currLine, currLine, imagewidth );
-                        currLine += rowstride;
-                    }
-
-                    cmsDeleteTransform( transf );
+                if (auto transf = Inkscape::CMSSystem::get()->get_image_transform(prof, intent)) {
+                    // Since the types are the same size, we can do the transformation in-place
+                    Inkscape::CMSSystem::transform_image(*transf, px, imagewidth, imageheight, rowstride,
+                                                         Inkscape::get_num_threads());
                 } else {
                     DEBUG_MESSAGE( lcmsSix, "in <image>'s sp_image_update. Unable to create LCMS transform." );
                 }
-
-                cmsCloseProfile( destProf );
             } else {
                 DEBUG_MESSAGE( lcmsSeven, "in <image>'s sp_image_update. Profile type is named color. Can't transform." );
             }
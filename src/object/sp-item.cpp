@@ -1578,7 +1578,26 @@ bool SPItem::unoptimized() {
     return false;
 }
 
+SPItem::TransformPrefs SPItem::TransformPrefs::read()
+{
+    auto prefs = Inkscape::Preferences::get();
+    TransformPrefs result;
+    result.stroke = prefs->getBool("/options/transform/stroke", true);
+    result.rectcorners = prefs->getBool("/options/transform/rectcorners", true);
+    result.pattern = prefs->getBool("/options/transform/pattern", true);
+    result.hatch = prefs->getBool("/options/transform/hatch", true);
+    result.gradient = prefs->getBool("/options/transform/gradient", true);
+    result.preserve = prefs->getBool("/options/preservetransform/value", false);
+    return result;
+}
+
 void SPItem::doWriteTransform(Geom::Affine const &transform, Geom::Affine const *adv, bool compensate)
+{
+    doWriteTransform(transform, adv, compensate, TransformPrefs::read());
+}
+
+void SPItem::doWriteTransform(Geom::Affine const &transform, Geom::Affine const *adv, bool compensate,
+                              TransformPrefs const &prefs)
 {
     // calculate the relative transform, if not given by the adv attribute
     Geom::Affine advertized_transform;
@@ -1588,13 +1607,12 @@ void SPItem::doWriteTransform(Geom::Affine const &transform, Geom::Affine const
         advertized_transform = sp_item_transform_repr (this).inverse() * transform;
     }
 
-    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
     if (compensate) {
         // recursively compensating for stroke scaling will not always work, because it can be scaled to zero or infinite
         // from which we cannot ever recover by applying an inverse scale; therefore we temporarily block any changes
         // to the strokewidth in such a case instead, and unblock these after the transformation
         // (as reported in https://bugs.launchpad.net/inkscape/+bug/825840/comments/4)
-        if (!prefs->getBool("/options/transform/stroke", true)) {
+        if (!prefs.stroke) {
             double const expansion = 1. / advertized_transform.descrim();
             if (expansion < 1e-9 || expansion > 1e9) {
                 freeze_stroke_width_recursive(true);
@@ -1610,21 +1628,21 @@ void SPItem::doWriteTransform(Geom::Affine const &transform, Geom::Affine const
         }
 
         // recursively compensate rx/ry of a rect if requested
-        if (!prefs->getBool("/options/transform/rectcorners", true)) {
+        if (!prefs.rectcorners) {
             sp_item_adjust_rects_recursive(this, advertized_transform);
         }
 
         // recursively compensate pattern fill if it's not to be transformed
-        if (!prefs->getBool("/options/transform/pattern", true)) {
+        if (!prefs.pattern) {
             adjust_paint_recursive(advertized_transform.inverse(), Geom::identity(), PATTERN);
         }
-        if (!prefs->getBool("/options/transform/hatch", true)) {
+        if (!prefs.hatch) {
             adjust_paint_recursive(advertized_transform.inverse(), Geom::identity(), HATCH);
         }
 
         /// \todo FIXME: add the same else branch as for gradients below, to convert patterns to userSpaceOnUse as well
         /// recursively compensate gradient fill if it's not to be transformed
-        if (!prefs->getBool("/options/transform/gradient", true)) {
+        if (!prefs.gradient) {
             adjust_paint_recursive(advertized_transform.inverse(), Geom::identity(), GRADIENT);
         } else {
             // this converts the gradient/pattern fill/stroke, if any, to userSpaceOnUse; we need to do
@@ -1634,7 +1652,7 @@ void SPItem::doWriteTransform(Geom::Affine const &transform, Geom::Affine const
 
     } // endif(compensate)
 
-    gint preserve = prefs->getBool("/options/preservetransform/value", false);
+    bool const preserve = prefs.preserve;
     Geom::Affine transform_attr (transform);
 
     // CPPIFY: check this code.
@@ -1660,7 +1678,7 @@ void SPItem::doWriteTransform(Geom::Affine const &transform, Geom::Affine const
     if (freeze_stroke_width) {
         freeze_stroke_width_recursive(false);
         if (compensate) {
-            if (!prefs->getBool("/options/transform/stroke", true)) {
+            if (!prefs.stroke) {
                 // Recursively compensate for stroke scaling, depending on user preference
                 // (As to why we need to do this, see the comment a few lines above near the freeze_stroke_width_recursive(true) call)
                 double const expansion = 1. / advertized_transform.descrim();
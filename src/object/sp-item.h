@@ -370,6 +370,25 @@ public:
      */
     void doWriteTransform(Geom::Affine const &transform, Geom::Affine const *adv = nullptr, bool compensate = true);
 
+    /**
+     * The transform preferences that doWriteTransform() follows, to be read only once when
+     * transforming many items in a row.
+     */
+    struct TransformPrefs
+    {
+        bool stroke = true;      ///< Scale stroke widths
+        bool rectcorners = true; ///< Scale rounded corners of rects
+        bool pattern = true;     ///< Transform patterns
+        bool hatch = true;       ///< Transform hatches
+        bool gradient = true;    ///< Transform gradients
+        bool preserve = false;   ///< Keep transforms instead of embedding them
+
+        static TransformPrefs read();
+    };
+
+    void doWriteTransform(Geom::Affine const &transform, Geom::Affine const *adv, bool compensate,
+                          TransformPrefs const &prefs);
+
     /**
      * Sets item private transform (not propagated to repr), without compensating stroke widths,
      * gradients, patterns as sp_item_write_transform does.
@@ -994,6 +994,10 @@ void SPObject::notifyChildOrderChanged(Inkscape::XML::Node &, Inkscape::XML::Nod
 
 void SPObject::notifyElementNameChanged(Inkscape::XML::Node &node, GQuark old_name, GQuark new_name)
 {
+    if (!cloned) {
+        document->bindObjectToElement(this, old_name, new_name);
+    }
+
     auto const oldname = g_quark_to_string(old_name);
     auto const newname = g_quark_to_string(new_name);
 
@@ -1154,12 +1158,41 @@ void SPObject::readAttr(gchar const *key)
     }
 }
 
-void SPObject::notifyAttributeChanged(Inkscape::XML::Node &, GQuark key_, Util::ptr_shared, Util::ptr_shared)
+void SPObject::notifyAttributeChanged(Inkscape::XML::Node &, GQuark key_, Util::ptr_shared oldval,
+                                      Util::ptr_shared newval)
 {
+    static GQuark const class_key = g_quark_from_static_string("class");
+    if (key_ == class_key && !cloned) {
+        document->bindObjectToClasses(this, newval.pointer());
+    }
+
     auto const key = g_quark_to_string(key_);
     readAttr(key);
 }
 
+void SPObject::notifyAttributesChanged(Inkscape::XML::Node &node, std::span<Inkscape::XML::AttributeChange const> changes)
+{
+    if (!document->isWritingInBulk(this)) {
+        NodeObserver::notifyAttributesChanged(node, changes);
+        return;
+    }
+
+    // We wrote these ourselves, so only need the updates reading them back would request.
+    static GQuark const class_key = g_quark_from_static_string("class");
+    unsigned flags = SP_OBJECT_MODIFIED_FLAG;
+    for (auto const &change : changes) {
+        if (change.name == class_key && !cloned) {
+            document->bindObjectToClasses(this, change.new_value.pointer());
+        }
+        // Paths read "d" as their data, not as a property.
+        auto const keyid = sp_attribute_lookup(g_quark_to_string(change.name));
+        if (keyid == SPAttr::STYLE || (keyid != SPAttr::D && SP_ATTRIBUTE_IS_CSS(keyid))) {
+            flags |= SP_OBJECT_STYLE_MODIFIED_FLAG;
+        }
+    }
+    requestDisplayUpdate(flags);
+}
+
 void SPObject::notifyContentChanged(Inkscape::XML::Node &, Util::ptr_shared, Util::ptr_shared)
 {
     read_content();
@@ -845,6 +845,9 @@ private:
     void notifyAttributeChanged(Inkscape::XML::Node &node, GQuark key, Inkscape::Util::ptr_shared oldval,
                                 Inkscape::Util::ptr_shared newval) final;
 
+    void notifyAttributesChanged(Inkscape::XML::Node &node,
+                                 std::span<Inkscape::XML::AttributeChange const> changes) final;
+
     void notifyContentChanged(Inkscape::XML::Node &node, Inkscape::Util::ptr_shared oldcontent,
                               Inkscape::Util::ptr_shared newcontent) final;
 
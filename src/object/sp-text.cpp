@@ -26,6 +26,8 @@
 
 #include "sp-text.h"
 
+#include <utility>
+
 #include <glibmm/i18n.h>
 #include <glibmm/regex.h>
 
@@ -99,6 +101,9 @@ void SPText::build(SPDocument *doc, Inkscape::XML::Node *repr) {
 void SPText::release()
 {
     view_style_attachments.clear();
+    if (_layout_queue_index >= 0) {
+        document->dequeueTextLayout(std::exchange(_layout_queue_index, -1));
+    }
     SPItem::release();
 }
 
@@ -197,19 +202,50 @@ void SPText::update(SPCtx *ctx, guint flags) {
         /* fixme: It is not nice to have it here, but otherwise children content changes does not work */
         /* fixme: Even now it may not work, as we are delayed */
         /* fixme: So check modification flag everywhere immediate state is used */
-        this->rebuildLayout();
+        if (_layout_queue_index < 0) {
+            _layout_queue_index = document->queueTextLayout(this);
+        }
+        if (_layout_queue_index >= 0) {
+            // The document calculates the flow with those of other texts, then calls
+            // finishQueuedLayout().
+            prepareLayout();
+        } else {
+            this->rebuildLayout();
+            showLayout();
+        }
+    }
+}
 
-        Geom::OptRect paintbox = this->geometricBounds();
+void SPText::finishQueuedLayout()
+{
+    _layout_queue_index = -1;
+    finishLayout();
+    showLayout();
+}
 
-        for (auto &v : views) {
-            auto &sa = view_style_attachments[v.key];
-            sa.unattachAll();
-            auto g = cast<Inkscape::DrawingGroup>(v.drawingitem.get());
-            _clearFlow(g);
-            g->setStyle(style, parent->style);
-            // pass the bbox of this as paintbox (used for paintserver fills)
-            layout.show(g, sa, paintbox);
-        }
+void SPText::_calculateQueuedLayout() const
+{
+    if (_layout_queue_index >= 0) {
+        // Parents may ask for the bounds while the document is still updating its children.
+        auto self = const_cast<SPText *>(this);
+        document->dequeueTextLayout(_layout_queue_index);
+        self->layout.calculateFlow();
+        self->finishQueuedLayout();
+    }
+}
+
+void SPText::showLayout()
+{
+    Geom::OptRect paintbox = this->geometricBounds();
+
+    for (auto &v : views) {
+        auto &sa = view_style_attachments[v.key];
+        sa.unattachAll();
+        auto g = cast<Inkscape::DrawingGroup>(v.drawingitem.get());
+        _clearFlow(g);
+        g->setStyle(style, parent->style);
+        // pass the bbox of this as paintbox (used for paintserver fills)
+        layout.show(g, sa, paintbox);
     }
 }
 
@@ -309,6 +345,7 @@ Inkscape::XML::Node *SPText::write(Inkscape::XML::Document *xml_doc, Inkscape::X
 
 
 Geom::OptRect SPText::bbox(Geom::Affine const &transform, SPItem::BBoxType type) const {
+    _calculateQueuedLayout();
     return this->layout.bounds(transform, type == SPItem::VISUAL_BBOX);
 }
 
@@ -889,15 +926,23 @@ SPCurve SPText::getNormalizedBpath() const
 }
 
 void SPText::rebuildLayout()
+{
+    prepareLayout();
+    layout.calculateFlow();
+    finishLayout();
+}
+
+void SPText::prepareLayout()
 {
     layout.clear();
     _buildLayoutInit();
 
     Inkscape::Text::Layout::OptionalTextTagAttrs optional_attrs;
     _buildLayoutInput(this, optional_attrs, 0, false);
+}
 
-    layout.calculateFlow();
-
+void SPText::finishLayout()
+{
     for (auto& child: children) {
         if (is<SPTextPath>(&child)) {
             SPTextPath const *textpath = cast<SPTextPath>(&child);
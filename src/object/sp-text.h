@@ -47,6 +47,9 @@ public:
     /** Completely recalculates the layout. */
     void rebuildLayout();
 
+    /** Called by SPDocument once it calculated the flow of a layout queued by update(). */
+    void finishQueuedLayout();
+
     //semiprivate:  (need to be accessed by the C-style functions still)
     TextTagAttributes attributes;
     Inkscape::Text::Layout layout;
@@ -88,6 +91,19 @@ public:
 
 private:
 
+    /** The steps of rebuildLayout() around layout.calculateFlow(), which the document may run
+    on another thread: prepareLayout() reads the objects into the layout input, finishLayout()
+    writes positions back to them. */
+    void prepareLayout();
+    void finishLayout();
+    /** Recreates the drawing items of the text from the layout. */
+    void showLayout();
+
+    /** Lays out the text now if its layout is still queued, for those who need its bounds
+    before the document gets to it. */
+    void _calculateQueuedLayout() const;
+    int _layout_queue_index = -1; ///< Index in the text layout queue of the document, or -1
+
     /** Initializes layout from <text> (i.e. this node). */
     void _buildLayoutInit();
 
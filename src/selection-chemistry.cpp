@@ -24,11 +24,15 @@
 
 #include "selection-chemistry.h"
 
+#include <algorithm>
 #include <boost/range/adaptor/reversed.hpp>
 #include <cstring>
 #include <glibmm/i18n.h>
 #include <map>
+#include <span>
 #include <string>
+#include <unordered_set>
+#include <utility>
 
 #include "actions/actions-tools.h" // Switching tools
 #include "context-fns.h"
@@ -1632,6 +1636,19 @@ object_set_contains_both_clone_and_original(ObjectSet *set)
     return clone_with_original;
 }
 
+/**
+ * Whether \a item can be transformed in bulk: a path that nothing refers to or follows the
+ * transforms of, and which changes nothing but its own attributes when transformed.
+ */
+static bool
+is_bulk_transformable(SPItem *item)
+{
+    auto path = cast<SPPath>(item);
+    return path && !path->hasPathEffectRecursive() && !Inkscape::UI::Tools::cc_item_is_connector(path) &&
+           !path->isReferenced() && path->_transformed_signal.empty() && !path->getClipObject() &&
+           !path->getMaskObject() && !path->style->fill.isPaintserver() && !path->style->stroke.isPaintserver();
+}
+
 /**
  * Reapply the same transform again.
  */
@@ -1687,18 +1704,28 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
             transf_persp->apply_affine_transformation(affine);
         }
     }
+    // Clone original LPEs go first, last selected first.
     auto items_copy = items();
-    std::vector<SPItem *> ordered_items;
-    for (auto l=items_copy.begin();l!=items_copy.end() ;++l) {
-        SPItem *item = *l;
+    std::vector<SPItem *> ordered_items(items_copy.begin(), items_copy.end());
+    auto const clonelpes_end = std::stable_partition(ordered_items.begin(), ordered_items.end(), [](SPItem *item) {
         auto clonelpe = cast<SPLPEItem>(item);
-        if (clonelpe && clonelpe->hasPathEffectOfType(Inkscape::LivePathEffect::CLONE_ORIGINAL)) {
-            ordered_items.insert(ordered_items.begin(), item);
-        } else {
-            ordered_items.push_back(item);
-        }
-    }
-    for (auto item : ordered_items) {
+        return clonelpe && clonelpe->hasPathEffectOfType(Inkscape::LivePathEffect::CLONE_ORIGINAL);
+    });
+    std::reverse(ordered_items.begin(), clonelpes_end);
+    // Paths that nothing depends on go last, to be written in bulk.
+    auto const bulk_begin = std::stable_partition(clonelpes_end, ordered_items.end(), [this] (SPItem *item) {
+        return !is_bulk_transformable(item) || getSiblingState(item) != SiblingState::SIBLING_NONE;
+    });
+
+    // The preferences are read once for all items, which counts when moving many thousands.
+    // "clones are unmoved when original is moved" preference
+    Inkscape::Preferences *prefs = Inkscape::Preferences::get();
+    int compensation = prefs->getInt("/options/clonecompensation/value", SP_CLONE_COMPENSATION_UNMOVED);
+    bool prefs_unmoved = (compensation == SP_CLONE_COMPENSATION_UNMOVED);
+    bool prefs_parallel = (compensation == SP_CLONE_COMPENSATION_PARALLEL);
+    auto const transform_prefs = SPItem::TransformPrefs::read();
+
+    for (auto item : std::span(ordered_items.begin(), bulk_begin)) {
         if (is<SPRoot>(item) ) {
             // An SVG element cannot have a transform. We could change 'x' and 'y' in response
             // to a translation... but leave that for another day.
@@ -1729,12 +1756,6 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
             }
         }
 
-        // "clones are unmoved when original is moved" preference
-        Inkscape::Preferences *prefs = Inkscape::Preferences::get();
-        int compensation = prefs->getInt("/options/clonecompensation/value", SP_CLONE_COMPENSATION_UNMOVED);
-        bool prefs_unmoved = (compensation == SP_CLONE_COMPENSATION_UNMOVED);
-        bool prefs_parallel = (compensation == SP_CLONE_COMPENSATION_PARALLEL);
-
         SiblingState sibling_state = getSiblingState(item);
 
         /* If this is a clone and it's selected along with its original, do not move it;
@@ -1755,7 +1776,7 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
                     for (auto& itm: region.children) {
                         auto use = cast<SPUse>(&itm);
                         if ( use ) {
-                            use->doWriteTransform(item->transform.inverse(), nullptr, compensate);
+                            use->doWriteTransform(item->transform.inverse(), nullptr, compensate, transform_prefs);
                         }
                     }
                 }
@@ -1799,13 +1820,13 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
 
                 if (prefs_parallel) {
                     Geom::Affine move = result * clone_move * t_inv;
-                    item->doWriteTransform(move, &move, compensate);
+                    item->doWriteTransform(move, &move, compensate, transform_prefs);
 
                 } else if (prefs_unmoved) {
                     //if (is<SPUse>(sp_use_get_original(cast<SPUse>(item))))
                     //    clone_move = Geom::identity();
                     Geom::Affine move = result * clone_move;
-                    item->doWriteTransform(move, &t, compensate);
+                    item->doWriteTransform(move, &t, compensate, transform_prefs);
                 }
 
             } else if (sibling_state == SiblingState::SIBLING_OFFSET_SOURCE && (prefs_parallel || prefs_unmoved) && affine.isTranslation()){
@@ -1814,16 +1835,16 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
 
                 if (prefs_parallel) {
                     Geom::Affine move = result * offset_move * t_inv;
-                    item->doWriteTransform(move, &move, compensate);
+                    item->doWriteTransform(move, &move, compensate, transform_prefs);
 
                 } else if (prefs_unmoved) {
                     Geom::Affine move = result * offset_move;
-                    item->doWriteTransform(move, &t, compensate);
+                    item->doWriteTransform(move, &t, compensate, transform_prefs);
                 }
 
             } else {
                 // just apply the result
-                item->doWriteTransform(result, &t, compensate);
+                item->doWriteTransform(result, &t, compensate, transform_prefs);
             }
         } else if (sibling_state == SiblingState::SIBLING_TEXT_SHAPE_INSIDE) {
             item->readAttr(SPAttr::TRANSFORM);
@@ -1832,7 +1853,7 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
             if (set_i2d) {
                 item->set_i2d_affine(item->i2dt_affine() * (Geom::Affine)affine);
             }
-            item->doWriteTransform(item->transform, nullptr, compensate);
+            item->doWriteTransform(item->transform, nullptr, compensate, transform_prefs);
         }
 
         if (adjust_transf_center) { // The transformation center should not be touched in case of pasting or importing, which is allowed by this if clause
@@ -1844,6 +1865,33 @@ void ObjectSet::applyAffine(Geom::Affine const &affine, bool set_i2d, bool compe
             }
         }
     }
+
+    if (bulk_begin == ordered_items.end()) {
+        return;
+    }
+
+    // Writing these with the attribute notifications held back, each gets one notification
+    // instead of one per attribute, doesn't parse back what it wrote, and the lot of them make
+    // one undo event.
+    auto const bulk_items = std::span(bulk_begin, ordered_items.end());
+    std::unordered_set<SPObject const *> writers(bulk_items.begin(), bulk_items.end());
+    bulk_items.front()->document->writeInBulk(std::move(writers), [&] {
+        for (auto item : bulk_items) {
+            Geom::Point old_center(0,0);
+            if (set_i2d && item->isCenterSet())
+                old_center = item->getCenter();
+
+            if (set_i2d) {
+                item->set_i2d_affine(item->i2dt_affine() * (Geom::Affine)affine);
+            }
+            item->doWriteTransform(item->transform, nullptr, compensate, transform_prefs);
+
+            if (adjust_transf_center && set_i2d && item->isCenterSet() && !(affine.isTranslation() || affine.isIdentity())) {
+                item->setCenter(old_center * affine);
+                item->updateRepr();
+            }
+        }
+    });
 }
 
 void ObjectSet::removeTransform()
@@ -8,7 +8,7 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 #include "svg/stringstream.h"
-#include "svg/strip-trailing-zeros.h"
+#include "svg/svg-number.h"
 #include "preferences.h"
 #include <2geom/point.h>
 
@@ -29,24 +29,9 @@ Inkscape::SVGOStringStream::SVGOStringStream()
 Inkscape::SVGOStringStream &
 Inkscape::SVGOStringStream::operator<<(double d)
 {
-    auto &os = *this;
-
-    /* Try as integer first. */
-    {
-        int const n = int(d);
-        if (d == n) {
-            os << n;
-            return os;
-        }
-    }
-
-    std::ostringstream s;
-    s.imbue(std::locale::classic());
-    s.flags(os.setf(std::ios::showpoint));
-    s.precision(os.precision());
-    s << d;
-    os << strip_trailing_zeros(s.str());
-    return os;
+    char buf[Inkscape::SVG::NUMBER_BUFFER_SIZE];
+    ostr.write(buf, Inkscape::SVG::write_number_general(buf, d, ostr.precision()) - buf);
+    return *this;
 }
 
 Inkscape::SVGOStringStream &
@@ -0,0 +1,207 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Fast formatting of numbers for SVG output
+ *
+ * The digit generation is done by std::to_chars, which implements the Ryu algorithms for both
+ * the shortest round-trip representation and correctly rounded fixed precision output; this file
+ * only arranges the digits the way Inkscape has always written them.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "svg/svg-number.h"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace Inkscape {
+namespace SVG {
+
+namespace {
+
+/// Significant decimal digits of a positive finite number.
+struct Digits
+{
+    char digits[NUMBER_BUFFER_SIZE]; ///< Without trailing zeros
+    int count = 0;
+    int exponent = 0; ///< Decimal exponent of the first digit
+};
+
+/**
+ * Get the digits of @a val (positive and finite), correctly rounded to @a precision significant
+ * digits, or the shortest round-trip digits if precision is 0.
+ */
+Digits get_digits(double val, int precision)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    auto const res = precision > 0
+        ? std::to_chars(buf, buf + sizeof(buf), val, std::chars_format::scientific, precision - 1)
+        : std::to_chars(buf, buf + sizeof(buf), val, std::chars_format::scientific);
+
+    // The buffer now holds "d[.ddd]e(+|-)dd"
+    Digits result;
+    char const *p = buf;
+    for (; p < res.ptr && *p != 'e'; ++p) {
+        if (*p != '.') {
+            result.digits[result.count++] = *p;
+        }
+    }
+    while (result.count > 1 && result.digits[result.count - 1] == '0') {
+        result.count--;
+    }
+
+    bool const negative_exp = p + 1 < res.ptr && p[1] == '-';
+    for (p += 2; p < res.ptr; ++p) {
+        result.exponent = result.exponent * 10 + (*p - '0');
+    }
+    if (negative_exp) {
+        result.exponent = -result.exponent;
+    }
+    return result;
+}
+
+/// Write digits in positional notation, padding with zeros up to the decimal point.
+char *write_positional(char *out, Digits const &d)
+{
+    if (d.exponent < 0) {
+        *out++ = '0';
+        *out++ = '.';
+        out = std::fill_n(out, -d.exponent - 1, '0');
+        return std::copy_n(d.digits, d.count, out);
+    }
+
+    int const int_digits = d.exponent + 1;
+    if (d.count <= int_digits) {
+        out = std::copy_n(d.digits, d.count, out);
+        return std::fill_n(out, int_digits - d.count, '0');
+    }
+    out = std::copy_n(d.digits, int_digits, out);
+    *out++ = '.';
+    return std::copy_n(d.digits + int_digits, d.count - int_digits, out);
+}
+
+/// Write digits as "d.ddde<exp>", the exponent without sign or padding if positive.
+char *write_exponential(char *out, Digits const &d)
+{
+    *out++ = d.digits[0];
+    if (d.count > 1) {
+        *out++ = '.';
+        out = std::copy_n(d.digits + 1, d.count - 1, out);
+    }
+    *out++ = 'e';
+    return std::to_chars(out, out + 8, d.exponent).ptr;
+}
+
+/// Remove trailing zeros (and a trailing decimal point) from a fixed notation number.
+char *strip_trailing_zeros(char *begin, char *end)
+{
+    if (std::find(begin, end, '.') == end) {
+        return end;
+    }
+    while (end[-1] == '0') {
+        --end;
+    }
+    if (end[-1] == '.') {
+        --end;
+    }
+    return end;
+}
+
+} // namespace
+
+char *write_number(char *out, double val, int precision, int min_exp)
+{
+    if (!std::isfinite(val)) {
+        return std::to_chars(out, out + NUMBER_BUFFER_SIZE, val).ptr;
+    }
+    if (val == 0.0) {
+        *out++ = '0';
+        return out;
+    }
+
+    precision = std::clamp(precision, 1, NUMBER_MAX_PRECISION);
+    bool const shortest = precision == NUMBER_MAX_PRECISION;
+    double const abs_val = std::fabs(val);
+
+    Digits const d = get_digits(abs_val, shortest ? 0 : precision);
+    int const eval = d.exponent;
+    if (eval < min_exp) {
+        *out++ = '0';
+        return out;
+    }
+    int const tprec = shortest ? d.count : precision;
+
+    // Pick the notation that needs fewer characters (the sign is the same for both)
+    int const max_digits_without_exp = eval < 0 ? tprec - eval + 1 : eval + 1 < tprec ? tprec + 1 : eval + 1;
+    int const max_digits_with_exp = tprec + (eval < 0 ? 4 : 3);
+
+    char *const start = out;
+    if (val < 0) {
+        *out++ = '-';
+    }
+
+    if (max_digits_without_exp > max_digits_with_exp) {
+        return write_exponential(out, d);
+    }
+    if (shortest || eval + 1 >= tprec) {
+        return write_positional(out, d);
+    }
+
+    // Numbers with a fractional part are written with a fixed number of decimal places:
+    // enough for 'precision' significant digits, but never fewer than 'precision' for values < 1.
+    int const places = eval < 0 ? tprec : tprec - eval - 1;
+    auto const res = std::to_chars(out, start + NUMBER_BUFFER_SIZE, abs_val, std::chars_format::fixed, places);
+    out = strip_trailing_zeros(out, res.ptr);
+    if (out - start == 2 && start[0] == '-' && start[1] == '0') {
+        // Rounded to zero, don't write "-0"
+        start[0] = '0';
+        out = start + 1;
+    }
+    return out;
+}
+
+char *write_number_shortest(char *out, double val)
+{
+    return std::to_chars(out, out + NUMBER_BUFFER_SIZE, val).ptr;
+}
+
+char *write_number_general(char *out, double val, int precision)
+{
+    if (val >= INT_MIN && val <= INT_MAX && val == static_cast<int>(val)) {
+        return std::to_chars(out, out + NUMBER_BUFFER_SIZE, static_cast<int>(val)).ptr;
+    }
+    precision = std::clamp(precision, 1, NUMBER_MAX_PRECISION);
+    return std::to_chars(out, out + NUMBER_BUFFER_SIZE, val, std::chars_format::general, precision).ptr;
+}
+
+void append_number(std::string &str, double val, int precision, int min_exp)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    str.append(buf, write_number(buf, val, precision, min_exp));
+}
+
+void append_number_general(std::string &str, double val, int precision)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    str.append(buf, write_number_general(buf, val, precision));
+}
+
+} // namespace SVG
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Fast formatting of numbers for SVG output
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_SVG_NUMBER_H
+#define SEEN_INKSCAPE_SVG_NUMBER_H
+
+#include <cstddef>
+#include <string>
+
+namespace Inkscape {
+namespace SVG {
+
+/**
+ * Size of a buffer which can hold any number written by the functions below.
+ * The functions do not add a terminating NUL character.
+ */
+constexpr std::size_t NUMBER_BUFFER_SIZE = 32;
+
+/**
+ * Maximum useful precision; at this precision and above, numbers are written with the
+ * shortest representation which reads back to the same double.
+ */
+constexpr int NUMBER_MAX_PRECISION = 17;
+
+/**
+ * Write a number the way SVG attributes are written: rounded to @a precision significant digits,
+ * flushed to zero below 10^min_exp, using exponent notation only where it is shorter.
+ *
+ * The digits are exact (correctly rounded from the binary value), unlike the old floating point
+ * arithmetic based formatter.
+ *
+ * @return Pointer past the last written character.
+ */
+char *write_number(char *out, double val, int precision, int min_exp);
+
+/**
+ * Write the shortest representation of @a val which reads back to exactly the same double.
+ */
+char *write_number_shortest(char *out, double val);
+
+/**
+ * Write a number like printf's "%.<precision>g" in the C locale, but write integers exactly.
+ * This is the format of Inkscape::SVGOStringStream.
+ */
+char *write_number_general(char *out, double val, int precision);
+
+/**
+ * Append a number formatted by write_number() to @a str.
+ * Appending to a string that is reused avoids allocating a new string for every number.
+ */
+void append_number(std::string &str, double val, int precision, int min_exp);
+
+/**
+ * Append a number formatted by write_number_general() to @a str.
+ */
+void append_number_general(std::string &str, double val, int precision);
+
+} // namespace SVG
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_SVG_NUMBER_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
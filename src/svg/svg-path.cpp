@@ -16,19 +16,518 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <string>
+#include <vector>
 #include <glib.h> // g_assert()
 
 #include <2geom/pathvector.h>
 #include <2geom/curves.h>
 #include <2geom/sbasis-to-bezier.h>
 #include <2geom/path-sink.h>
-#include <2geom/svg-path-parser.h>
 
 #include "svg/svg.h"
 #include "svg/path-string.h"
 
+namespace {
+
+/*
+ * Number scanning
+ *
+ * SVG path data is mostly made of short decimal numbers, so instead of handing every
+ * coordinate to strtod we accumulate the digits into an integer mantissa and a decimal
+ * exponent ourselves. Whenever the mantissa fits into 53 bits and the exponent is small
+ * enough, a single multiplication or division by an exact power of ten yields the correctly
+ * rounded result (Clinger's fast path, as used by fast_float). Everything else is handed to
+ * g_ascii_strtod, so the result is always identical to the one of the generic parser.
+ */
+
+double const exact_powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+constexpr int MAX_EXACT_POWER = 22;
+constexpr int MAX_MANTISSA_DIGITS = 19; // 10^19 - 1 still fits into 64 bits
+constexpr std::uint64_t MAX_EXACT_MANTISSA = std::uint64_t(1) << 53;
+
+inline bool is_digit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool is_wsp(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+inline bool is_number_start(char c)
+{
+    return is_digit(c) || c == '+' || c == '-' || c == '.';
+}
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+/// Load eight characters as a little-endian word, so that the first character ends up in the lowest byte.
+inline std::uint64_t load_eight_chars(char const *p)
+{
+    std::uint64_t val;
+    std::memcpy(&val, p, sizeof(val));
+    return val;
+}
+
+/// Check, eight bytes at a time, whether all the characters of a word are decimal digits.
+inline bool is_eight_digits(std::uint64_t val)
+{
+    return !(((val + 0x4646464646464646) | (val - 0x3030303030303030)) & 0x8080808080808080);
+}
+
+/// Convert eight decimal digits loaded with load_eight_chars() to their value (SWAR).
+inline std::uint32_t parse_eight_digits(std::uint64_t val)
+{
+    std::uint64_t const mask = 0x000000FF000000FF;
+    std::uint64_t const mul1 = 0x000F424000000064; // 100 + (1000000 << 32)
+    std::uint64_t const mul2 = 0x0000271000000001; // 1 + (10000 << 32)
+    val -= 0x3030303030303030;
+    val = (val * 10) + (val >> 8);
+    val = (((val & mask) * mul1) + (((val >> 16) & mask) * mul2)) >> 32;
+    return static_cast<std::uint32_t>(val);
+}
+#endif
+
+/**
+ * Accumulate a run of decimal digits into the mantissa.
+ *
+ * Digits that do not fit are dropped (and flagged in @a truncated); @a dropped counts how many
+ * of them there were, so that the caller can correct the exponent.
+ */
+inline char const *scan_digits(char const *p, char const *end, std::uint64_t &mantissa, int &ndigits,
+                               int &dropped, bool &truncated)
+{
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+    while (end - p >= 8 && ndigits + 8 <= MAX_MANTISSA_DIGITS) {
+        std::uint64_t const chunk = load_eight_chars(p);
+        if (!is_eight_digits(chunk)) {
+            break;
+        }
+        mantissa = mantissa * 100000000 + parse_eight_digits(chunk);
+        ndigits += 8;
+        p += 8;
+    }
+#endif
+    for (; p < end && is_digit(*p); ++p) {
+        if (ndigits < MAX_MANTISSA_DIGITS) {
+            mantissa = mantissa * 10 + (*p - '0');
+            ndigits++;
+        } else {
+            dropped++;
+            truncated |= *p != '0';
+        }
+    }
+    return p;
+}
+
+/**
+ * Scan a number according to the SVG path data grammar.
+ *
+ * @return Pointer past the number, or nullptr if the text at @a p is not a valid number.
+ */
+char const *scan_number(char const *p, char const *end, double &value)
+{
+    char const *const start = p;
+    bool negative = false;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        ++p;
+    }
+
+    std::uint64_t mantissa = 0;
+    int ndigits = 0;
+    int dropped = 0;
+    int exponent = 0;
+    bool truncated = false;
+    bool seen_digit = false;
+
+    // Integer part. Leading zeros carry no information, skipping them keeps ndigits exact.
+    char const *digits = p;
+    while (p < end && *p == '0') {
+        ++p;
+    }
+    p = scan_digits(p, end, mantissa, ndigits, dropped, truncated);
+    seen_digit = p != digits;
+    exponent += dropped;
+
+    // Fractional part
+    if (p < end && *p == '.') {
+        ++p;
+        digits = p;
+        if (mantissa == 0) {
+            while (p < end && *p == '0') {
+                ++p;
+            }
+            exponent -= p - digits;
+        }
+        char const *significant = p;
+        dropped = 0;
+        p = scan_digits(p, end, mantissa, ndigits, dropped, truncated);
+        exponent -= (p - significant) - dropped;
+        seen_digit |= p != digits;
+    }
+
+    if (!seen_digit) {
+        return nullptr;
+    }
+
+    // Exponent
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool negative_exp = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            negative_exp = *p == '-';
+            ++p;
+        }
+        if (p == end || !is_digit(*p)) {
+            return nullptr;
+        }
+        int exp_value = 0;
+        for (; p < end && is_digit(*p); ++p) {
+            if (exp_value < 100000) {
+                exp_value = exp_value * 10 + (*p - '0');
+            }
+        }
+        exponent += negative_exp ? -exp_value : exp_value;
+    }
+
+    if (!truncated && mantissa <= MAX_EXACT_MANTISSA && exponent >= -MAX_EXACT_POWER &&
+        exponent <= MAX_EXACT_POWER) {
+        value = static_cast<double>(mantissa);
+        if (exponent < 0) {
+            value /= exact_powers_of_ten[-exponent];
+        } else {
+            value *= exact_powers_of_ten[exponent];
+        }
+        if (negative) {
+            value = -value;
+        }
+    } else {
+        // Slow path; the span has already been validated, so strtod sees exactly our number.
+        std::size_t const len = p - start;
+        char buf[64];
+        if (len < sizeof(buf)) {
+            std::memcpy(buf, start, len);
+            buf[len] = '\0';
+            value = g_ascii_strtod(buf, nullptr);
+        } else {
+            value = g_ascii_strtod(std::string(start, len).c_str(), nullptr);
+        }
+    }
+    return p;
+}
+
+/**
+ * Parser for SVG path data which feeds a Geom::PathSink directly.
+ *
+ * The parser does not allocate: it keeps the last segment in a small pending record, so that
+ * the final point can still be snapped to the subpath start when a closepath follows, and only
+ * then hands it to the sink.
+ */
+class PathDataParser
+{
+public:
+    PathDataParser(Geom::PathSink &sink, Geom::Coord z_snap_threshold)
+        : _sink(sink)
+        , _z_snap_threshold(z_snap_threshold)
+    {}
+
+    /**
+     * Parse the path data in [begin, end).
+     * @return False if an error was found; the data up to the error has been sent to the sink.
+     */
+    bool parse(char const *begin, char const *end);
+
+private:
+    enum class Segment { None, Line, Quad, Cubic, Arc };
+
+    bool _readParams(int count, bool is_arc);
+    void _execute(char cmd);
+    void _push(Segment kind, Geom::Point const &p0, Geom::Point const &p1 = {}, Geom::Point const &p2 = {});
+    void _flushPending();
+    void _closePath();
+
+    Geom::PathSink &_sink;
+    Geom::Coord _z_snap_threshold;
+
+    char const *_p = nullptr;
+    char const *_end = nullptr;
+    double _params[7];
+
+    Geom::Point _current;
+    Geom::Point _initial;
+    Geom::Point _quad_tangent;
+    Geom::Point _cubic_tangent;
+    bool _relative = false;
+    bool _moveto_was_relative = false;
+
+    // Last segment, not yet sent to the sink
+    Segment _pending = Segment::None;
+    Geom::Point _pending_pts[3];
+    double _pending_arc[5];
+    bool _pending_relative = false;
+};
+
+inline void skip_wsp(char const *&p, char const *end)
+{
+    while (p < end && is_wsp(*p)) {
+        ++p;
+    }
+}
+
+/// Skip an optional comma_wsp; returns true if a comma was found.
+inline bool skip_comma_wsp(char const *&p, char const *end)
+{
+    skip_wsp(p, end);
+    if (p < end && *p == ',') {
+        ++p;
+        skip_wsp(p, end);
+        return true;
+    }
+    return false;
+}
+
+bool PathDataParser::_readParams(int count, bool is_arc)
+{
+    for (int i = 0; i < count; i++) {
+        if (i > 0) {
+            skip_comma_wsp(_p, _end);
+        }
+        if (is_arc && (i == 3 || i == 4)) {
+            // Flags are single characters and need no separator
+            if (_p == _end || (*_p != '0' && *_p != '1')) {
+                return false;
+            }
+            _params[i] = *_p++ - '0';
+        } else {
+            char const *next = scan_number(_p, _end, _params[i]);
+            if (!next) {
+                return false;
+            }
+            _p = next;
+        }
+    }
+    return true;
+}
+
+bool PathDataParser::parse(char const *begin, char const *end)
+{
+    _p = begin;
+    _end = end;
+
+    skip_wsp(_p, _end);
+    if (_p < _end && *_p != 'M' && *_p != 'm') {
+        return false;
+    }
+
+    bool ok = true;
+    while (ok && _p < _end) {
+        char const cmd = *_p++;
+        _relative = g_ascii_islower(cmd);
+
+        int count;
+        switch (g_ascii_toupper(cmd)) {
+            case 'Z':
+                _closePath();
+                skip_wsp(_p, _end);
+                continue;
+            case 'H':
+            case 'V':
+                count = 1;
+                break;
+            case 'M':
+            case 'L':
+            case 'T':
+                count = 2;
+                break;
+            case 'S':
+            case 'Q':
+                count = 4;
+                break;
+            case 'C':
+                count = 6;
+                break;
+            case 'A':
+                count = 7;
+                break;
+            default:
+                ok = false;
+                continue;
+        }
+
+        // cmd wsp* args (comma_wsp? args)*
+        skip_wsp(_p, _end);
+        char implicit = cmd;
+        while (true) {
+            if (!_readParams(count, implicit == 'A' || implicit == 'a')) {
+                ok = false;
+                break;
+            }
+            _execute(implicit);
+            // Subsequent coordinate pairs of a moveto are implicit lineto commands
+            if (implicit == 'M') {
+                implicit = 'L';
+            } else if (implicit == 'm') {
+                implicit = 'l';
+            }
+
+            char const *group_end = _p;
+            bool const comma = skip_comma_wsp(_p, _end);
+            if (_p == _end || !is_number_start(*_p)) {
+                if (comma) {
+                    ok = false;
+                } else {
+                    _p = group_end;
+                }
+                break;
+            }
+        }
+        skip_wsp(_p, _end);
+    }
+
+    _flushPending();
+    _sink.flush();
+    return ok;
+}
+
+void PathDataParser::_execute(char cmd)
+{
+    Geom::Point const origin = _relative ? _current : Geom::Point(0, 0);
+    auto point = [&] (int i) { return origin + Geom::Point(_params[i], _params[i + 1]); };
+
+    switch (cmd) {
+        case 'M':
+        case 'm':
+            _flushPending();
+            _current = _initial = _quad_tangent = _cubic_tangent = point(0);
+            _moveto_was_relative = _relative;
+            _sink.moveTo(_current);
+            break;
+        case 'L':
+        case 'l':
+            _push(Segment::Line, point(0));
+            break;
+        case 'H':
+        case 'h':
+            _push(Segment::Line, Geom::Point(origin[Geom::X] + _params[0], _current[Geom::Y]));
+            break;
+        case 'V':
+        case 'v':
+            _push(Segment::Line, Geom::Point(_current[Geom::X], origin[Geom::Y] + _params[0]));
+            break;
+        case 'C':
+        case 'c':
+            _push(Segment::Cubic, point(0), point(2), point(4));
+            break;
+        case 'S':
+        case 's':
+            _push(Segment::Cubic, _cubic_tangent, point(0), point(2));
+            break;
+        case 'Q':
+        case 'q':
+            _push(Segment::Quad, point(0), point(2));
+            break;
+        case 'T':
+        case 't':
+            _push(Segment::Quad, _quad_tangent, point(0));
+            break;
+        case 'A':
+        case 'a':
+            // Per the SVG spec, an arc with identical end points is omitted
+            if (point(5) != _current) {
+                _push(Segment::Arc, point(5));
+            }
+            break;
+        default:
+            g_assert_not_reached();
+    }
+}
+
+/// Send the previous segment to the sink and make the given one pending.
+void PathDataParser::_push(Segment kind, Geom::Point const &p0, Geom::Point const &p1, Geom::Point const &p2)
+{
+    _flushPending();
+    _pending = kind;
+    _pending_relative = _relative;
+    _pending_pts[0] = p0;
+    _pending_pts[1] = p1;
+    _pending_pts[2] = p2;
+
+    switch (kind) {
+        case Segment::Quad:
+            _cubic_tangent = _current = p1;
+            _quad_tangent = p1 + (p1 - p0);
+            break;
+        case Segment::Cubic:
+            _quad_tangent = _current = p2;
+            _cubic_tangent = p2 + (p2 - p1);
+            break;
+        case Segment::Arc:
+            std::copy(_params, _params + 5, _pending_arc);
+            [[fallthrough]];
+        default:
+            _quad_tangent = _cubic_tangent = _current = p0;
+            break;
+    }
+}
+
+void PathDataParser::_flushPending()
+{
+    switch (_pending) {
+        case Segment::None:
+            return;
+        case Segment::Line:
+            _sink.lineTo(_pending_pts[0]);
+            break;
+        case Segment::Quad:
+            _sink.quadTo(_pending_pts[0], _pending_pts[1]);
+            break;
+        case Segment::Cubic:
+            _sink.curveTo(_pending_pts[0], _pending_pts[1], _pending_pts[2]);
+            break;
+        case Segment::Arc:
+            _sink.arcTo(std::fabs(_pending_arc[0]), std::fabs(_pending_arc[1]), Geom::rad_from_deg(_pending_arc[2]),
+                        _pending_arc[3] != 0, _pending_arc[4] != 0, _pending_pts[0]);
+            break;
+    }
+    _pending = Segment::None;
+}
+
+void PathDataParser::_closePath()
+{
+    // Relative coordinates accumulate rounding errors; snap the end point back onto the start
+    // so that the closing segment does not become a tiny spurious line.
+    if (_pending != Segment::None && (_pending_relative || _moveto_was_relative) &&
+        Geom::are_near(_initial, _current, _z_snap_threshold))
+    {
+        switch (_pending) {
+            case Segment::Quad:
+                _pending_pts[1] = _initial;
+                break;
+            case Segment::Cubic:
+                _pending_pts[2] = _initial;
+                break;
+            default:
+                _pending_pts[0] = _initial;
+                break;
+        }
+    }
+    _flushPending();
+    _sink.closePath();
+    _quad_tangent = _cubic_tangent = _current = _initial;
+}
+
+} // namespace
+
 /*
  * Parses the path in str. When an error is found in the pathstring, this method
  * returns a truncated path up to where the error was found in the pathstring.
@@ -40,15 +539,19 @@ Geom::PathVector sp_svg_read_pathv(char const * str)
     if (!str)
         return pathv;  // return empty pathvector when str == NULL
 
-    Geom::PathBuilder builder(pathv);
-    Geom::SVGPathParser parser(builder);
-    parser.setZSnapThreshold(Geom::EPSILON);
+    std::size_t const len = std::strlen(str);
+    char const *const end = str + len;
 
-    try {
-        parser.parse(str);
-    }
-    catch (Geom::SVGPathParseError &e) {
-        builder.flush();
+    // Pre-count the subpaths so that the path storage is allocated only once.
+    std::vector<Geom::Path> paths;
+    paths.reserve(std::count_if(str, end, [] (char c) { return c == 'M' || c == 'm'; }));
+
+    Geom::PathIteratorSink<std::back_insert_iterator<std::vector<Geom::Path>>> sink(std::back_inserter(paths));
+    PathDataParser parser(sink, Geom::EPSILON);
+    bool const ok = parser.parse(str, end);
+
+    pathv = Geom::PathVector(paths.begin(), paths.end());
+    if (!ok) {
         // This warning is extremely annoying when testing
         g_warning(
             "Malformed SVG path, truncated path up to where error was found.\n Input path=\"%s\"\n Parsed path=\"%s\"",
@@ -2424,12 +2424,7 @@ void CanvasPrivate::paint_single_buffer(Cairo::RefPtr<Cairo::ImageSurface> const
     // Apply CMS transform.
     if (rd.cms_transform) {
         surface->flush();
-        auto px = surface->get_data();
-        int stride = surface->get_stride();
-        for (int i = 0; i < surface->get_height(); i++) {
-                auto row = px + i * stride;
-                Inkscape::CMSSystem::do_transform(rd.cms_transform->getHandle(), row, row, surface->get_width());
-        }
+        rd.cms_transform->apply(surface->get_data(), surface->get_width(), surface->get_height(), surface->get_stride());
         surface->mark_dirty();
     }
 
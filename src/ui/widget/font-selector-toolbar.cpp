@@ -168,6 +168,7 @@ FontSelectorToolbar::get_missing_fonts ()
     Inkscape::FontLister* font_lister = Inkscape::FontLister::get_instance();
 
     std::vector<Glib::ustring> tokens = Glib::Regex::split_simple("\\s*,\\s*", font_list);
+    font_lister->finish_font_list();
 
     for (auto token: tokens) {
         bool found = false;
@@ -16,6 +16,7 @@
 #include <unordered_map>
 #include <deque>
 #include <memory>
+#include <mutex>
 #include <algorithm>
 
 namespace Inkscape {
@@ -44,6 +45,10 @@ namespace Util {
  * still active. This is in accord with its expected usage; if the factory loads objects from an
  * external library, then it should be safe to destroy the cache just before the library is
  * unloaded, as the objects should no longer be in use at that point anyway.
+ *
+ * The map may be used from several threads at once, and the shared pointers it returns may be
+ * released on any thread. Unused objects are only deleted by add(), so that a factory can
+ * control the thread and the locks they are deleted with.
  */
 template <typename Tk, typename Tv, typename Hash = std::hash<Tk>, typename Compare = std::equal_to<Tk>>
 class cached_map
@@ -65,8 +70,13 @@ public:
      */
     auto add(Tk key, std::unique_ptr<Tv> value)
     {
+        auto lock = std::lock_guard(mutex);
         auto ret = map.emplace(std::move(key), std::move(value));
-        return get_view(ret.first->second);
+        auto view = get_view(ret.first);
+        while (unused.size() > max_cache_size) {
+            pop_unused();
+        }
+        return view;
     }
 
     /**
@@ -76,8 +86,9 @@ public:
      */
     auto lookup(Tk const &key) -> std::shared_ptr<Tv>
     {
+        auto lock = std::lock_guard(mutex);
         if (auto it = map.find(key); it != map.end()) {
-            return get_view(it->second);
+            return get_view(it);
         } else {
             return {};
         }
@@ -85,6 +96,7 @@ public:
 
     void clear()
     {
+        auto lock = std::lock_guard(mutex);
         unused.clear();
         map.clear();
     }
@@ -99,44 +111,40 @@ private:
 
     std::size_t const max_cache_size;
     std::unordered_map<Tk, Item, Hash, Compare> map;
-    std::deque<Tv*> unused;
+    std::deque<Tk> unused; // The keys of the unused values, oldest first.
+    std::mutex mutex;
 
-    auto get_view(Item &item)
+    auto get_view(typename decltype(map)::iterator it)
     {
+        auto &item = it->second;
         if (auto view = item.view.lock()) {
             return view;
         } else {
-            remove_unused(item.value.get());
-            auto new_view = std::shared_ptr<Tv>(item.value.get(), [this] (Tv *value) {
-                push_unused(value);
+            remove_unused(it->first);
+            auto new_view = std::shared_ptr<Tv>(item.value.get(), [this, key = it->first] (Tv *) {
+                auto lock = std::lock_guard(mutex);
+                // Another thread may have looked the value up again in the meantime.
+                if (auto it = map.find(key); it != map.end() && it->second.view.expired()) {
+                    remove_unused(key);
+                    unused.emplace_back(key);
+                }
             });
             item.view = new_view;
             return new_view;
         }
     }
 
-    void remove_unused(Tv *value)
+    void remove_unused(Tk const &key)
     {
-        auto it = std::find(unused.begin(), unused.end(), value);
+        auto it = std::find_if(unused.begin(), unused.end(), [&] (Tk const &k) { return Compare{}(k, key); });
         if (it != unused.end()) {
             unused.erase(it);
         }
     }
 
-    void push_unused(Tv *value)
-    {
-        unused.emplace_back(value);
-        if (unused.size() > max_cache_size) {
-            pop_unused();
-        }
-    }
-
     void pop_unused()
     {
-        auto value = unused.front();
-        map.erase(std::find_if(map.begin(), map.end(), [value] (auto const &it) {
-            return it.second.value.get() == value;
-        }));
+        map.erase(unused.front());
         unused.pop_front();
     }
 };
@@ -0,0 +1,383 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::Util::JsonValue - minimal JSON reader and writer for line based protocols
+ *
+ * Copyright (C) 2026 Inkscape Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "json.h"
+
+#include <charconv>
+#include <cmath>
+#include <glib.h>
+
+namespace Inkscape {
+namespace Util {
+
+namespace {
+
+/// Deeper nesting than this is rejected, so that hostile input cannot exhaust the stack.
+constexpr int MAX_DEPTH = 64;
+
+class Parser
+{
+public:
+    explicit Parser(std::string_view text) : _text(text) {}
+
+    std::optional<JsonValue> parseDocument()
+    {
+        auto value = parseValue(0);
+        if (value) {
+            skipWhitespace();
+            if (_pos != _text.size()) {
+                return fail("unexpected data after the value");
+            }
+        }
+        return value;
+    }
+
+    std::string const &error() const { return _error; }
+
+private:
+    std::nullopt_t fail(char const *message)
+    {
+        if (_error.empty()) {
+            _error = std::string(message) + " at offset " + std::to_string(_pos);
+        }
+        return std::nullopt;
+    }
+
+    void skipWhitespace()
+    {
+        while (_pos < _text.size() && (_text[_pos] == ' ' || _text[_pos] == '\t' ||
+                                       _text[_pos] == '\n' || _text[_pos] == '\r')) {
+            ++_pos;
+        }
+    }
+
+    bool consume(std::string_view literal)
+    {
+        if (_text.substr(_pos, literal.size()) == literal) {
+            _pos += literal.size();
+            return true;
+        }
+        return false;
+    }
+
+    std::optional<JsonValue> parseValue(int depth)
+    {
+        if (depth > MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+        skipWhitespace();
+        if (_pos >= _text.size()) {
+            return fail("unexpected end of input");
+        }
+        switch (_text[_pos]) {
+            case '{': return parseObject(depth);
+            case '[': return parseArray(depth);
+            case '"': {
+                auto str = parseString();
+                if (!str) {
+                    return std::nullopt;
+                }
+                return JsonValue(std::move(*str));
+            }
+            case 't': if (consume("true")) return JsonValue(true); break;
+            case 'f': if (consume("false")) return JsonValue(false); break;
+            case 'n': if (consume("null")) return JsonValue(); break;
+            default: return parseNumber();
+        }
+        return fail("invalid literal");
+    }
+
+    std::optional<JsonValue> parseObject(int depth)
+    {
+        ++_pos; // '{'
+        JsonValue::Object object;
+        skipWhitespace();
+        if (consume("}")) {
+            return JsonValue(std::move(object));
+        }
+        while (true) {
+            skipWhitespace();
+            if (_pos >= _text.size() || _text[_pos] != '"') {
+                return fail("expected a member name");
+            }
+            auto name = parseString();
+            if (!name) {
+                return std::nullopt;
+            }
+            skipWhitespace();
+            if (!consume(":")) {
+                return fail("expected ':'");
+            }
+            auto value = parseValue(depth + 1);
+            if (!value) {
+                return std::nullopt;
+            }
+            object.insert_or_assign(std::move(*name), std::move(*value));
+            skipWhitespace();
+            if (consume("}")) {
+                return JsonValue(std::move(object));
+            }
+            if (!consume(",")) {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    std::optional<JsonValue> parseArray(int depth)
+    {
+        ++_pos; // '['
+        JsonValue::Array array;
+        skipWhitespace();
+        if (consume("]")) {
+            return JsonValue(std::move(array));
+        }
+        while (true) {
+            auto value = parseValue(depth + 1);
+            if (!value) {
+                return std::nullopt;
+            }
+            array.push_back(std::move(*value));
+            skipWhitespace();
+            if (consume("]")) {
+                return JsonValue(std::move(array));
+            }
+            if (!consume(",")) {
+                return fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    std::optional<unsigned> parseHex4()
+    {
+        if (_pos + 4 > _text.size()) {
+            return std::nullopt;
+        }
+        unsigned value = 0;
+        for (int i = 0; i < 4; ++i) {
+            int const digit = g_ascii_xdigit_value(_text[_pos++]);
+            if (digit < 0) {
+                return std::nullopt;
+            }
+            value = value * 16 + digit;
+        }
+        return value;
+    }
+
+    std::optional<std::string> parseString()
+    {
+        ++_pos; // '"'
+        std::string result;
+        while (true) {
+            if (_pos >= _text.size()) {
+                fail("unterminated string");
+                return std::nullopt;
+            }
+            char const c = _text[_pos++];
+            if (c == '"') {
+                return result;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                fail("control character in string");
+                return std::nullopt;
+            }
+            if (c != '\\') {
+                result += c;
+                continue;
+            }
+            if (_pos >= _text.size()) {
+                fail("unterminated string");
+                return std::nullopt;
+            }
+            switch (_text[_pos++]) {
+                case '"':  result += '"';  break;
+                case '\\': result += '\\'; break;
+                case '/':  result += '/';  break;
+                case 'b':  result += '\b'; break;
+                case 'f':  result += '\f'; break;
+                case 'n':  result += '\n'; break;
+                case 'r':  result += '\r'; break;
+                case 't':  result += '\t'; break;
+                case 'u': {
+                    auto code = parseHex4();
+                    if (!code) {
+                        fail("invalid \\u escape");
+                        return std::nullopt;
+                    }
+                    gunichar ch = *code;
+                    if (ch >= 0xd800 && ch < 0xdc00) {
+                        // High surrogate, must be followed by a low one.
+                        std::optional<unsigned> low;
+                        if (consume("\\u")) {
+                            low = parseHex4();
+                        }
+                        if (!low || *low < 0xdc00 || *low >= 0xe000) {
+                            fail("unpaired surrogate");
+                            return std::nullopt;
+                        }
+                        ch = 0x10000 + ((ch - 0xd800) << 10) + (*low - 0xdc00);
+                    } else if (ch >= 0xdc00 && ch < 0xe000) {
+                        fail("unpaired surrogate");
+                        return std::nullopt;
+                    }
+                    char utf8[6];
+                    result.append(utf8, g_unichar_to_utf8(ch, utf8));
+                    break;
+                }
+                default:
+                    fail("invalid escape");
+                    return std::nullopt;
+            }
+        }
+    }
+
+    std::optional<JsonValue> parseNumber()
+    {
+        // Check the grammar strictly, then convert locale independently.
+        auto const start = _pos;
+        auto const digits = [this] {
+            auto const from = _pos;
+            while (_pos < _text.size() && g_ascii_isdigit(_text[_pos])) {
+                ++_pos;
+            }
+            return _pos - from;
+        };
+        consume("-");
+        if (consume("0")) {
+            // No leading zeros.
+        } else if (digits() == 0) {
+            return fail("invalid value");
+        }
+        if (consume(".") && digits() == 0) {
+            return fail("invalid number");
+        }
+        if (_pos < _text.size() && (_text[_pos] == 'e' || _text[_pos] == 'E')) {
+            ++_pos;
+            if (!consume("+")) {
+                consume("-");
+            }
+            if (digits() == 0) {
+                return fail("invalid number");
+            }
+        }
+        std::string const number(_text.substr(start, _pos - start));
+        return JsonValue(g_ascii_strtod(number.c_str(), nullptr));
+    }
+
+    std::string_view _text;
+    std::size_t _pos = 0;
+    std::string _error;
+};
+
+void serialize_string(std::string const &str, std::string &out)
+{
+    out += '"';
+    for (char c : str) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\r': out += "\\r";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    g_snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    out += '"';
+}
+
+} // namespace
+
+JsonValue const *JsonValue::find(std::string const &name) const
+{
+    if (auto object = getObject()) {
+        if (auto it = object->find(name); it != object->end()) {
+            return &it->second;
+        }
+    }
+    return nullptr;
+}
+
+std::string JsonValue::serialize() const
+{
+    std::string out;
+    serialize(out);
+    return out;
+}
+
+void JsonValue::serialize(std::string &out) const
+{
+    if (auto b = getBool()) {
+        out += *b ? "true" : "false";
+    } else if (auto number = getNumber()) {
+        if (std::isfinite(*number)) {
+            // Shortest representation which reads back the same.
+            char buf[32];
+            auto const end = std::to_chars(buf, buf + sizeof(buf), *number).ptr;
+            out.append(buf, end);
+        } else {
+            out += "null"; // Not representable in JSON.
+        }
+    } else if (auto str = getString()) {
+        serialize_string(*str, out);
+    } else if (auto array = getArray()) {
+        out += '[';
+        for (auto const &value : *array) {
+            if (&value != &array->front()) {
+                out += ',';
+            }
+            value.serialize(out);
+        }
+        out += ']';
+    } else if (auto object = getObject()) {
+        out += '{';
+        bool first = true;
+        for (auto const &[name, value] : *object) {
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            serialize_string(name, out);
+            out += ':';
+            value.serialize(out);
+        }
+        out += '}';
+    } else {
+        out += "null";
+    }
+}
+
+std::optional<JsonValue> JsonValue::parse(std::string_view text, std::string *error)
+{
+    Parser parser(text);
+    auto value = parser.parseDocument();
+    if (!value && error) {
+        *error = parser.error();
+    }
+    return value;
+}
+
+} // namespace Util
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Inkscape::Util::JsonValue - minimal JSON reader and writer for line based protocols
+ *
+ * Copyright (C) 2026 Inkscape Authors
+ *
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_UTIL_JSON_H
+#define SEEN_INKSCAPE_UTIL_JSON_H
+
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace Inkscape {
+namespace Util {
+
+/**
+ * A JSON value: null, boolean, number, string, array or object.
+ *
+ * Only what is needed to exchange small messages, such as the jobs of the batch server, is
+ * supported. Objects keep their members sorted by name; duplicate names keep the last value.
+ */
+class JsonValue
+{
+public:
+    using Array = std::vector<JsonValue>;
+    using Object = std::map<std::string, JsonValue>;
+
+    JsonValue() = default;
+    JsonValue(std::nullptr_t) {}
+    JsonValue(bool value) : _value(value) {}
+    JsonValue(double value) : _value(value) {}
+    JsonValue(int value) : _value(static_cast<double>(value)) {}
+    JsonValue(std::string value) : _value(std::move(value)) {}
+    JsonValue(char const *value) : _value(std::string(value)) {}
+    JsonValue(Array value) : _value(std::move(value)) {}
+    JsonValue(Object value) : _value(std::move(value)) {}
+
+    bool isNull() const { return std::holds_alternative<std::nullptr_t>(_value); }
+    bool isBool() const { return std::holds_alternative<bool>(_value); }
+    bool isNumber() const { return std::holds_alternative<double>(_value); }
+    bool isString() const { return std::holds_alternative<std::string>(_value); }
+    bool isArray() const { return std::holds_alternative<Array>(_value); }
+    bool isObject() const { return std::holds_alternative<Object>(_value); }
+
+    /// The value if it has the asked type, otherwise null.
+    bool const *getBool() const { return std::get_if<bool>(&_value); }
+    double const *getNumber() const { return std::get_if<double>(&_value); }
+    std::string const *getString() const { return std::get_if<std::string>(&_value); }
+    Array const *getArray() const { return std::get_if<Array>(&_value); }
+    Object const *getObject() const { return std::get_if<Object>(&_value); }
+    Object *getObject() { return std::get_if<Object>(&_value); }
+
+    /// The member called \a name of an object, or null if there is none or this is no object.
+    JsonValue const *find(std::string const &name) const;
+
+    /// Write as compact JSON, without any line breaks.
+    std::string serialize() const;
+    void serialize(std::string &out) const;
+
+    /**
+     * Parse a complete JSON text; only whitespace may surround the value.
+     *
+     * @param error Set to a description of the problem if parsing fails.
+     */
+    static std::optional<JsonValue> parse(std::string_view text, std::string *error = nullptr);
+
+private:
+    std::variant<std::nullptr_t, bool, double, std::string, Array, Object> _value;
+};
+
+} // namespace Util
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_UTIL_JSON_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * How many threads to spread work over.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "threading.h"
+
+#include <thread>
+
+#include "preferences.h"
+
+namespace Inkscape {
+
+int default_num_threads()
+{
+    auto ret = std::thread::hardware_concurrency();
+    return ret == 0 ? 4 : ret; // Sensible fallback if not reported.
+}
+
+int get_num_threads()
+{
+    return Preferences::get()->getIntLimited("/options/threading/numthreads", default_num_threads(), 1, 256);
+}
+
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
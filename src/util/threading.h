@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * How many threads to spread work over.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef INKSCAPE_UTIL_THREADING_H
+#define INKSCAPE_UTIL_THREADING_H
+
+namespace Inkscape {
+
+/// One thread per core, or a sensible number if the cores aren't reported.
+int default_num_threads();
+
+/**
+ * The number of threads to spread work over: the threading preference, or one per core if unset.
+ * This reads the preferences, so call it on the main thread and hand the result to workers.
+ */
+int get_num_threads();
+
+} // namespace Inkscape
+
+#endif // INKSCAPE_UTIL_THREADING_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
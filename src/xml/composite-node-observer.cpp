@@ -100,6 +100,17 @@ void CompositeNodeObserver::notifyAttributeChanged(
     _finishIteration();
 }
 
+void CompositeNodeObserver::notifyAttributesChanged(Node &node, std::span<AttributeChange const> changes)
+{
+    _startIteration();
+    for (auto &iter : _active) {
+        if (!iter.marked) {
+            iter.observer->notifyAttributesChanged(node, changes);
+        }
+    }
+    _finishIteration();
+}
+
 void CompositeNodeObserver::notifyElementNameChanged(Node& node, GQuark old_name, GQuark new_name)
 {
     _startIteration();
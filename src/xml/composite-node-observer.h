@@ -71,6 +71,8 @@ public:
                                 Util::ptr_shared old_value,
                                 Util::ptr_shared new_value) override;
 
+    void notifyAttributesChanged(Node &node, std::span<AttributeChange const> changes) override;
+
     void notifyElementNameChanged(Node& node, GQuark old_name, GQuark new_name) override;
 
 private:
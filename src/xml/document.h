@@ -85,6 +85,31 @@ public:
     virtual Event *commitUndoable()=0;
     /*@}*/
 
+    /**
+     * @name Bulk attribute changes
+     * @{
+     */
+    /**
+     * @brief Checks whether attribute changes are being made in bulk
+     */
+    virtual bool inBulkAttributes()=0;
+    /**
+     * @brief Start holding back the notifications of attribute changes
+     *
+     * Until endBulkAttributes() is called, changes to the attributes of this document's nodes
+     * are neither sent to the nodes' observers nor logged. Only attributes may be changed in
+     * the meantime, and nothing may rely on the observers having seen the changes.
+     */
+    virtual void beginBulkAttributes()=0;
+    /**
+     * @brief Send out the attribute changes held back since beginBulkAttributes()
+     *
+     * If there is an active transaction, the changes are logged as a single event. Each
+     * node's observers are then told about its changes with NodeObserver::notifyAttributesChanged().
+     */
+    virtual void endBulkAttributes()=0;
+    /*@}*/
+
     /**
      * @name Create new nodes
      * @{
@@ -16,6 +16,8 @@
 
 #include <glib.h> // g_assert()
 #include <cstdio>
+#include <unordered_map>
+#include <utility>
 
 #include "event.h"
 #include "event-fns.h"
@@ -123,6 +125,27 @@ public:
     }
 };
 
+/**
+ * Undo or replay \a event with the LogPerformer, changing the attributes of an EventChgAttrs in
+ * bulk again.
+ */
+void perform_one(Inkscape::XML::Event const *event, bool undo)
+{
+    auto &performer = LogPerformer::instance();
+    auto const bulk = dynamic_cast<Inkscape::XML::EventChgAttrs const *>(event) ? event->repr->document() : nullptr;
+    if (bulk) {
+        bulk->beginBulkAttributes();
+    }
+    if (undo) {
+        event->undoOne(performer);
+    } else {
+        event->replayOne(performer);
+    }
+    if (bulk) {
+        bulk->endBulkAttributes();
+    }
+}
+
 }
 
 void Inkscape::XML::undo_log_to_observer(
@@ -148,7 +171,9 @@ void sp_repr_undo_log (Inkscape::XML::Event *log)
         }
     }
 
-    Inkscape::XML::undo_log_to_observer(log, LogPerformer::instance());
+    for (auto action = log; action; action = action->next) {
+        perform_one(action, true);
+    }
 }
 
 void Inkscape::XML::EventAdd::_undoOne(
@@ -169,6 +194,15 @@ void Inkscape::XML::EventChgAttr::_undoOne(
     observer.notifyAttributeChanged(*this->repr, this->key, this->newval, this->oldval);
 }
 
+void Inkscape::XML::EventChgAttrs::_undoOne(
+    Inkscape::XML::NodeObserver &observer
+) const {
+    for (auto i = changes.size(); i-- > 0;) {
+        auto const &change = changes[i];
+        observer.notifyAttributeChanged(*nodes[i], change.name, change.new_value, change.old_value);
+    }
+}
+
 void Inkscape::XML::EventChgContent::_undoOne(
     Inkscape::XML::NodeObserver &observer
 ) const {
@@ -216,7 +250,13 @@ sp_repr_replay_log (Inkscape::XML::Event *log)
         }
     }
 
-    Inkscape::XML::replay_log_to_observer(log, LogPerformer::instance());
+    std::vector<Inkscape::XML::Event const *> r;
+    for (auto action = log; action; action = action->next) {
+        r.push_back(action);
+    }
+    for (auto reversed = r.rbegin(); reversed != r.rend(); ++reversed) {
+        perform_one(*reversed, false);
+    }
 }
 
 void Inkscape::XML::EventAdd::_replayOne(
@@ -237,6 +277,15 @@ void Inkscape::XML::EventChgAttr::_replayOne(
     observer.notifyAttributeChanged(*this->repr, this->key, this->oldval, this->newval);
 }
 
+void Inkscape::XML::EventChgAttrs::_replayOne(
+    Inkscape::XML::NodeObserver &observer
+) const {
+    for (std::size_t i = 0; i < changes.size(); ++i) {
+        auto const &change = changes[i];
+        observer.notifyAttributeChanged(*nodes[i], change.name, change.old_value, change.new_value);
+    }
+}
+
 void Inkscape::XML::EventChgContent::_replayOne(
     Inkscape::XML::NodeObserver &observer
 ) const {
@@ -255,6 +304,105 @@ void Inkscape::XML::EventChgElementName::_replayOne(
     observer.notifyElementNameChanged(*this->repr, this->old_name, this->new_name);
 }
 
+namespace {
+
+/**
+ * Whether other events can be moved across \a event: attribute, content and order changes
+ * don't depend on each other, unlike the adding, removing or renaming of nodes.
+ */
+bool is_structural(Inkscape::XML::Event const *event)
+{
+    return dynamic_cast<Inkscape::XML::EventAdd const *>(event) ||
+           dynamic_cast<Inkscape::XML::EventDel const *>(event) ||
+           dynamic_cast<Inkscape::XML::EventChgElementName const *>(event);
+}
+
+/**
+ * Fold the attribute changes of \a b into the latest changes to the same attributes in \a a,
+ * which b follows. Each such change then goes straight to the value b leaves behind.
+ * @return What remains of b
+ */
+Inkscape::XML::Event *merge_attribute_changes(Inkscape::XML::Event *a, Inkscape::XML::Event *b)
+{
+    using namespace Inkscape::XML;
+
+    for (auto event = b; event; event = event->next) {
+        if (is_structural(event)) {
+            return b;
+        }
+    }
+
+    // The new value of the latest change to each attribute in a, and whether it has been given
+    // b's value yet. Changes made in bulk are walked from the latest too.
+    std::unordered_map<AttributeChangeKey, std::pair<Inkscape::Util::ptr_shared *, bool>, AttributeChangeKey::Hash> changes;
+    for (auto event = a; event && !is_structural(event); event = event->next) {
+        if (auto chg_attr = dynamic_cast<EventChgAttr *>(event)) {
+            changes.try_emplace({chg_attr->repr, chg_attr->key}, &chg_attr->newval, false);
+        } else if (auto chg_attrs = dynamic_cast<EventChgAttrs *>(event)) {
+            for (auto i = chg_attrs->changes.size(); i-- > 0;) {
+                auto &change = chg_attrs->changes[i];
+                changes.try_emplace({chg_attrs->nodes[i], change.name}, &change.new_value, false);
+            }
+        }
+    }
+    if (changes.empty()) {
+        return b;
+    }
+
+    // Give a change of b to a, if a has changed the same attribute.
+    auto fold = [&] (Node const *repr, GQuark key, Inkscape::Util::ptr_shared newval) {
+        auto it = changes.find({repr, key});
+        if (it == changes.end()) {
+            return false;
+        }
+        auto &[earlier, has_value] = it->second;
+        if (!has_value) {
+            /* b is walked from its latest change, so this is the value b leaves behind */
+            *earlier = newval;
+            has_value = true;
+        }
+        return true;
+    };
+
+    Event **prev_ptr = &b;
+    while (auto event = *prev_ptr) {
+        bool remove = false;
+        if (auto chg_attr = dynamic_cast<EventChgAttr *>(event)) {
+            remove = fold(chg_attr->repr, chg_attr->key, chg_attr->newval);
+        } else if (auto chg_attrs = dynamic_cast<EventChgAttrs *>(event)) {
+            auto &nodes = chg_attrs->nodes;
+            auto &bulk = chg_attrs->changes;
+            std::vector<bool> folded(bulk.size());
+            for (auto i = bulk.size(); i-- > 0;) {
+                folded[i] = fold(nodes[i], bulk[i].name, bulk[i].new_value);
+            }
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < bulk.size(); ++i) {
+                if (!folded[i]) {
+                    nodes[kept] = nodes[i];
+                    bulk[kept] = bulk[i];
+                    ++kept;
+                }
+            }
+            nodes.resize(kept);
+            bulk.resize(kept);
+            remove = bulk.empty();
+            if (!remove) {
+                chg_attrs->repr = nodes.front();
+            }
+        }
+        if (!remove) {
+            prev_ptr = &event->next;
+            continue;
+        }
+        *prev_ptr = event->next;
+        delete event;
+    }
+    return b;
+}
+
+} // namespace
+
 Inkscape::XML::Event *
 sp_repr_coalesce_log (Inkscape::XML::Event *a, Inkscape::XML::Event *b)
 {
@@ -264,6 +412,9 @@ sp_repr_coalesce_log (Inkscape::XML::Event *a, Inkscape::XML::Event *b)
     if (!b) return a;
     if (!a) return b;
 
+    b = merge_attribute_changes(a, b);
+    if (!b) return a;
+
     /* find the earliest action in the second log */
     /* (also noting the pointer that references it, so we can
      *  replace it later) */
@@ -16,11 +16,16 @@
 typedef unsigned int GQuark;
 #include <glibmm/ustring.h>
 
+#include <functional>
 #include <iterator>
+#include <utility>
+#include <vector>
 #include "util/share.h"
 #include "util/forward-pointer-iterator.h"
+#include "inkgc/gc-alloc.h"
 #include "inkgc/gc-managed.h"
 #include "xml/node.h"
+#include "xml/node-observer.h"
 
 namespace Inkscape {
 namespace XML {
@@ -181,6 +186,50 @@ private:
     void _replayOne(NodeObserver &observer) const override;
 };
 
+/**
+ * @brief Object representing attribute changes made in bulk
+ *
+ * This is logged for the changes made between Document::beginBulkAttributes() and
+ * Document::endBulkAttributes(), in place of an EventChgAttr for each of them. The repr member
+ * is the node of the first change.
+ */
+class EventChgAttrs : public Event {
+public:
+    using Nodes = std::vector<Node *, Inkscape::GC::Alloc<Node *>>;
+    using Changes = std::vector<AttributeChange, Inkscape::GC::Alloc<AttributeChange>>;
+
+    EventChgAttrs(Nodes n, Changes c, Event *next)
+    : Event(n.front(), next), nodes(std::move(n)), changes(std::move(c)) {}
+
+    /// The node of each change
+    Nodes nodes;
+    /// The changes, in the order they were made
+    Changes changes;
+
+private:
+    Event *_optimizeOne() override { return this; }
+    void _undoOne(NodeObserver &observer) const override;
+    void _replayOne(NodeObserver &observer) const override;
+};
+
+/**
+ * @brief The attribute changed by an EventChgAttr, to find other changes to the same attribute
+ */
+struct AttributeChangeKey {
+    Node const *repr;
+    GQuark key;
+
+    bool operator==(AttributeChangeKey const &other) const {
+        return repr == other.repr && key == other.key;
+    }
+
+    struct Hash {
+        std::size_t operator()(AttributeChangeKey const &k) const {
+            return std::hash<Node const *>()(k.repr) ^ (std::hash<GQuark>()(k.key) * 0x9e3779b97f4a7c15ull);
+        }
+    };
+};
+
 /**
  * @brief Object representing content change
  */
@@ -11,6 +11,9 @@
  */
 
 #include "xml/log-builder.h"
+
+#include <utility>
+
 #include "xml/event.h"
 #include "xml/event-fns.h"
 
@@ -18,22 +21,26 @@ namespace Inkscape {
 namespace XML {
 
 void LogBuilder::discard() {
+    _attribute_changes.clear();
     sp_repr_free_log(_log);
     _log = nullptr;
 }
 
 Event *LogBuilder::detach() {
+    _attribute_changes.clear();
     Event *log=_log;
     _log = nullptr;
     return log;
 }
 
 void LogBuilder::addChild(Node &node, Node &child, Node *prev) {
+    _attribute_changes.clear();
     _log = new Inkscape::XML::EventAdd(&node, &child, prev, _log);
     _log = _log->optimizeOne();
 }
 
 void LogBuilder::removeChild(Node &node, Node &child, Node *prev) {
+    _attribute_changes.clear();
     _log = new Inkscape::XML::EventDel(&node, &child, prev, _log);
     _log = _log->optimizeOne();
 }
@@ -57,12 +64,27 @@ void LogBuilder::setAttribute(Node &node, GQuark name,
                               Util::ptr_shared old_value,
                               Util::ptr_shared new_value)
 {
-    _log = new Inkscape::XML::EventChgAttr(&node, name, old_value, new_value, _log);
+    auto [it, inserted] = _attribute_changes.try_emplace({&node, name}, nullptr);
+    if (!inserted) {
+        /* the earlier change already restores the value from before both */
+        it->second->newval = new_value;
+        return;
+    }
+    auto chg_attr = new Inkscape::XML::EventChgAttr(&node, name, old_value, new_value, _log);
+    it->second = chg_attr;
+    _log = chg_attr->optimizeOne();
+}
+
+void LogBuilder::setAttributes(EventChgAttrs::Nodes nodes, EventChgAttrs::Changes changes)
+{
+    _attribute_changes.clear();
+    _log = new Inkscape::XML::EventChgAttrs(std::move(nodes), std::move(changes), _log);
     _log = _log->optimizeOne();
 }
 
 void LogBuilder::setElementName(Node& node, GQuark old_name, GQuark new_name)
 {
+    _attribute_changes.clear();
     _log = new Inkscape::XML::EventChgElementName(&node, old_name, new_name, _log);
     _log = _log->optimizeOne();
 }
@@ -13,7 +13,10 @@
 #ifndef SEEN_INKSCAPE_XML_LOG_BUILDER_H
 #define SEEN_INKSCAPE_XML_LOG_BUILDER_H
 
+#include <unordered_map>
+
 #include "inkgc/gc-managed.h"
+#include "xml/event.h"
 #include "xml/node-observer.h"
 
 namespace Inkscape {
@@ -28,6 +31,11 @@ class Node;
  * This object records all events sent to it via the public methods in an internal event log.
  * Calling detach() then returns the built log. Calling discard() will clear all the events
  * recorded so far.
+ *
+ * Repeated changes to an attribute are recorded as one event, however many other changes
+ * happened in between, so that a drag over many nodes logs one event per changed attribute
+ * rather than one per motion event. Adding, removing or renaming nodes starts over, so that
+ * an attribute change is never moved across them, and so do changes made in bulk.
  */
 class LogBuilder {
 public:
@@ -65,10 +73,16 @@ public:
                       Util::ptr_shared new_value);
 
     void setElementName(Node& node, GQuark old_name, GQuark new_name);
+
+    /// Record attribute changes made in bulk as one event
+    void setAttributes(EventChgAttrs::Nodes nodes, EventChgAttrs::Changes changes);
     /*@}*/
 
 private:
     Event *_log;
+    /// The attribute changes in the log since it was last added to by other than a change of
+    /// attribute, content or child order.
+    std::unordered_map<AttributeChangeKey, EventChgAttr *, AttributeChangeKey::Hash> _attribute_changes;
 };
 
 }
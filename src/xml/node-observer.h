@@ -15,6 +15,8 @@
 #ifndef SEEN_INKSCAPE_XML_NODE_OBSERVER_H
 #define SEEN_INKSCAPE_XML_NODE_OBSERVER_H
 
+#include <span>
+
 #include "util/share.h"
 typedef unsigned int GQuark;
 
@@ -27,6 +29,18 @@ namespace XML {
 
 class Node;
 
+/**
+ * @brief A change of one attribute, as passed to NodeObserver::notifyAttributesChanged()
+ */
+struct AttributeChange {
+    /// GQuark corresponding to the attribute's name
+    GQuark name;
+    /// Old value of the attribute
+    Util::ptr_shared old_value;
+    /// New value of the attribute
+    Util::ptr_shared new_value;
+};
+
 /**
  * @brief Interface for XML node observers
  *
@@ -146,6 +160,23 @@ public:
         INK_UNUSED(new_value);
     }
 
+    /**
+     * @brief Callback for attribute changes made in bulk
+     *
+     * This method is called instead of notifyAttributeChanged() for the attributes changed
+     * between Document::beginBulkAttributes() and Document::endBulkAttributes(), once for
+     * each run of changes to the observed node. By default it calls notifyAttributeChanged()
+     * for each change in turn; override it to handle them all at once.
+     *
+     * @param node The changed XML node
+     * @param changes The changes to the attributes of @c node, in the order they were made
+     */
+    virtual void notifyAttributesChanged(Node &node, std::span<AttributeChange const> changes) {
+        for (auto const &change : changes) {
+            notifyAttributeChanged(node, change.name, change.old_value, change.new_value);
+        }
+    }
+
     /**
      * @brief Element name change callback.
      *
@@ -13,6 +13,7 @@
 #ifndef SEEN_INKSCAPE_XML_NODE_H
 #define SEEN_INKSCAPE_XML_NODE_H
 
+#include <cstdint>
 #include <vector>
 
 #include <2geom/point.h>
@@ -118,6 +119,17 @@ public:
      */
     virtual unsigned position() const = 0;
 
+    /**
+     * @brief Get a key that orders this node among its siblings
+     *
+     * Siblings compare by their keys the same way as by their positions, but the keys stay
+     * valid when other siblings are added, moved or removed, so comparing them never needs
+     * the siblings to be counted. They mean nothing for nodes with different parents.
+     *
+     * @return The node's order key, or 0 if the node does not have a parent
+     */
+    virtual std::uint64_t orderKey() const = 0;
+
     /**
      * @brief Get the number of children of this node
      * @return The number of children
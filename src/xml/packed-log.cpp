@@ -0,0 +1,258 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Compact storage for the values of old undo steps.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "packed-log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <glib.h>
+#include <zlib.h>
+
+#include "xml/event.h"
+
+namespace Inkscape {
+namespace XML {
+
+SpillFile::SpillFile()
+    : _file(std::tmpfile())
+{
+    if (!_file) {
+        g_warning("Could not create a temporary file for the undo history.");
+    }
+}
+
+SpillFile::~SpillFile()
+{
+    if (_file) {
+        std::fclose(_file);
+    }
+}
+
+std::int64_t SpillFile::write(std::vector<unsigned char> const &data)
+{
+    if (!_file || std::fseek(_file, 0, SEEK_END) != 0) {
+        return -1;
+    }
+    auto const offset = std::ftell(_file);
+    if (offset < 0 || std::fwrite(data.data(), 1, data.size(), _file) != data.size()) {
+        return -1;
+    }
+    return offset;
+}
+
+bool SpillFile::read(std::int64_t offset, std::vector<unsigned char> &data) const
+{
+    return _file && std::fseek(_file, offset, SEEK_SET) == 0 &&
+           std::fread(data.data(), 1, data.size(), _file) == data.size();
+}
+
+namespace {
+
+/// The values of an attribute or content change, which is keyed by quark 0 for content.
+struct ChangeValues
+{
+    std::pair<Node *, GQuark> key;
+    Util::ptr_shared *oldval;
+    Util::ptr_shared *newval;
+};
+
+/// The attribute and content changes of \a log, from the latest back.
+std::vector<ChangeValues> change_values(Event *log)
+{
+    std::vector<ChangeValues> result;
+    for (auto event = log; event; event = event->next) {
+        if (auto chg_attr = dynamic_cast<EventChgAttr *>(event)) {
+            result.push_back({{chg_attr->repr, chg_attr->key}, &chg_attr->oldval, &chg_attr->newval});
+        } else if (auto chg_attrs = dynamic_cast<EventChgAttrs *>(event)) {
+            for (auto i = chg_attrs->changes.size(); i-- > 0;) {
+                auto &change = chg_attrs->changes[i];
+                result.push_back({{chg_attrs->nodes[i], change.name}, &change.old_value, &change.new_value});
+            }
+        } else if (auto chg_content = dynamic_cast<EventChgContent *>(event)) {
+            result.push_back({{chg_content->repr, 0}, &chg_content->oldval, &chg_content->newval});
+        }
+    }
+    return result;
+}
+
+bool same_value(Util::ptr_shared const &a, Util::ptr_shared const &b)
+{
+    return a ? b && std::strcmp(a, b) == 0 : !b;
+}
+
+} // namespace
+
+PackedLog::PackedLog(Event *log, SpillFile *spill)
+{
+    // The earlier value of the last change seen on each attribute or content. As the log runs
+    // from the latest change back, this is the later value of the next change on it, which is
+    // then not stored again. The values stay held by the events until all are packed.
+    std::map<std::pair<Node *, GQuark>, Util::ptr_shared> earlier;
+
+    auto const changes = change_values(log);
+    std::string middles;
+    for (auto const &[key, oldval, newval] : changes) {
+        Value value;
+        value.old_null = !*oldval;
+        value.new_null = !*newval;
+        std::size_t const old_length = value.old_null ? 0 : std::strlen(*oldval);
+        std::size_t const new_length = value.new_null ? 0 : std::strlen(*newval);
+        char const *o = *oldval;
+        char const *n = *newval;
+
+        auto const it = earlier.find(key);
+        value.new_stored = it == earlier.end() || !same_value(it->second, *newval);
+        if (value.new_stored) {
+            value.new_length = new_length;
+            middles.append(n ? n : "", new_length);
+        }
+        earlier[key] = *oldval;
+
+        std::size_t prefix = 0;
+        while (prefix < old_length && prefix < new_length && o[prefix] == n[prefix]) {
+            ++prefix;
+        }
+        std::size_t suffix = 0;
+        while (suffix < old_length - prefix && suffix < new_length - prefix &&
+               o[old_length - 1 - suffix] == n[new_length - 1 - suffix]) {
+            ++suffix;
+        }
+        value.prefix = prefix;
+        value.suffix = suffix;
+        value.middle = old_length - prefix - suffix;
+        middles.append(o ? o + prefix : "", value.middle);
+        _values.push_back(value);
+    }
+
+    for (auto const &change : changes) {
+        *change.oldval = Util::ptr_shared();
+        *change.newval = Util::ptr_shared();
+    }
+
+    _data_length = middles.size();
+    uLongf packed_length = compressBound(middles.size());
+    _data.resize(packed_length);
+    if (compress2(_data.data(), &packed_length, reinterpret_cast<Bytef const *>(middles.data()), middles.size(),
+                  Z_DEFAULT_COMPRESSION) == Z_OK) {
+        _data.resize(packed_length);
+        _deflated = true;
+    } else {
+        _data.assign(middles.begin(), middles.end());
+    }
+
+    if (spill) {
+        auto const offset = spill->write(_data);
+        if (offset >= 0) {
+            _spill = spill;
+            _spill_offset = offset;
+            _spill_size = _data.size();
+            _data = {};
+        }
+    }
+    _data.shrink_to_fit();
+}
+
+void PackedLog::unpack(Event *log) const
+{
+    std::vector<unsigned char> data;
+    if (_spill) {
+        data.resize(_spill_size);
+        if (!_spill->read(_spill_offset, data)) {
+            g_warning("Could not read back the undo history from its temporary file.");
+            data.clear();
+        }
+    } else {
+        data = _data;
+    }
+
+    std::string middles(_data_length, '\0');
+    uLongf length = _data_length;
+    if (!_deflated) {
+        middles.assign(data.begin(), data.end());
+    } else if (uncompress(reinterpret_cast<Bytef *>(middles.data()), &length, data.data(), data.size()) != Z_OK ||
+               length != _data_length) {
+        g_warning("Could not unpack the undo history.");
+    }
+
+    // The later value of each change is stored, or is what the change after it on the same
+    // attribute or content started from.
+    std::map<std::pair<Node *, GQuark>, Util::ptr_shared> earlier;
+
+    auto value = _values.begin();
+    std::size_t pos = 0;
+    auto take = [&] (std::size_t length) {
+        length = std::min(length, middles.size() - std::min(pos, middles.size()));
+        auto const start = std::min(pos, middles.size());
+        pos += length;
+        return std::string_view(middles).substr(start, length);
+    };
+
+    for (auto const &[key, oldval, newval] : change_values(log)) {
+        if (value == _values.end()) {
+            break;
+        }
+
+        auto &current = earlier[key];
+        if (value->new_stored) {
+            auto const n = take(value->new_length);
+            current = value->new_null ? Util::ptr_shared() : Util::share_string(n.data(), n.size());
+        }
+        *newval = current;
+
+        if (value->old_null) {
+            *oldval = Util::ptr_shared();
+        } else {
+            auto const n = std::string_view(current ? static_cast<char const *>(current) : "");
+            std::string old_value(n.substr(0, value->prefix));
+            old_value += take(value->middle);
+            old_value += n.substr(n.size() - std::min<std::size_t>(value->suffix, n.size()));
+            *oldval = Util::share_string(old_value.c_str(), old_value.size());
+        }
+        current = *oldval;
+
+        ++value;
+    }
+}
+
+std::size_t PackedLog::size() const
+{
+    return sizeof(*this) + _values.capacity() * sizeof(Value) + _data.capacity();
+}
+
+std::size_t PackedLog::valueSize(Event const *log)
+{
+    // Each value is counted once, as the earlier value of a change: the later one is shared
+    // with the next change, or with the document.
+    std::size_t size = 0;
+    for (auto const &change : change_values(const_cast<Event *>(log))) {
+        if (*change.oldval) {
+            size += std::strlen(*change.oldval) + 1;
+        }
+    }
+    return size;
+}
+
+} // namespace XML
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
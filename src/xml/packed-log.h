@@ -0,0 +1,106 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Compact storage for the values of old undo steps.
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#ifndef SEEN_INKSCAPE_XML_PACKED_LOG_H
+#define SEEN_INKSCAPE_XML_PACKED_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace Inkscape {
+namespace XML {
+
+class Event;
+
+/**
+ * A temporary file that packed logs can be moved out of memory to. The file is deleted when
+ * closed.
+ */
+class SpillFile
+{
+public:
+    SpillFile();
+    ~SpillFile();
+    SpillFile(SpillFile const &) = delete;
+    SpillFile &operator=(SpillFile const &) = delete;
+
+    /// Append \a data to the file. @return its offset, or -1 if it could not be written.
+    std::int64_t write(std::vector<unsigned char> const &data);
+    bool read(std::int64_t offset, std::vector<unsigned char> &data) const;
+
+private:
+    std::FILE *_file;
+};
+
+/**
+ * The attribute and content values of an event log, packed away so that old undo steps take
+ * less memory.
+ *
+ * Each earlier value is kept as the part that differs from the later one, which for the likes of
+ * path data is a small part of it. A later value is only kept where it is not the earlier value
+ * of the next change on the same attribute or content, i.e. once for each, so that unpacking does
+ * not depend on what the document holds by then. All parts are deflated together, and can
+ * further be moved to a spill file.
+ */
+class PackedLog
+{
+public:
+    /**
+     * Pack the values of the attribute and content changes of \a log, which are cleared from
+     * its events. The log must not be changed until it is unpacked.
+     */
+    PackedLog(Event *log, SpillFile *spill = nullptr);
+
+    /// Give the events of \a log their values back.
+    void unpack(Event *log) const;
+
+    /// The memory taken by the packed values.
+    std::size_t size() const;
+
+    /// An estimate of the memory taken by the values of the events of \a log.
+    static std::size_t valueSize(Event const *log);
+
+private:
+    struct Value
+    {
+        std::uint32_t prefix = 0;     ///< Length of the start the earlier value shares with the later
+        std::uint32_t suffix = 0;     ///< Length of the end the earlier value shares with the later
+        std::uint32_t middle = 0;     ///< Length of the rest of the earlier value
+        std::uint32_t new_length = 0; ///< Length of the later value, if stored
+        bool old_null = false;
+        bool new_null = false;
+        bool new_stored = false;      ///< Whether the later value is stored before the middle
+    };
+
+    std::vector<Value> _values;
+    std::vector<unsigned char> _data; ///< The stored later values and middles, deflated
+    std::size_t _data_length = 0;     ///< Length of the data before deflating
+    bool _deflated = false;
+    SpillFile *_spill = nullptr;
+    std::int64_t _spill_offset = -1;
+    std::size_t _spill_size = 0;
+};
+
+} // namespace XML
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_XML_PACKED_LOG_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
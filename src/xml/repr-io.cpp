@@ -21,6 +21,7 @@
 #include "xml/repr.h"
 #include "xml/attribute-record.h"
 #include "xml/rebase-hrefs.h"
+#include "xml/serialization-cache.h"
 #include "xml/simple-document.h"
 #include "xml/text-node.h"
 #include "xml/node.h"
@@ -37,6 +38,9 @@
 
 #include "preferences.h"
 
+#include "util/threading.h"
+
+#include <glib/gstdio.h>
 #include <glibmm/miscutils.h>
 
 using Inkscape::IO::Writer;
@@ -46,6 +50,7 @@ using Inkscape::XML::Node;
 using Inkscape::XML::AttributeRecord;
 using Inkscape::XML::AttributeVector;
 using Inkscape::XML::rebase_href_attrs;
+using Inkscape::XML::SerializationCache;
 
 Document *sp_repr_do_read (xmlDocPtr doc, const gchar *default_ns);
 static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gchar *default_ns, std::map<std::string, std::string> &prefix_map);
@@ -54,7 +59,15 @@ static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
                                               bool add_whitespace, gchar const *default_ns,
                                               int inlineattrs, int indent,
                                               gchar const *old_href_abs_base,
-                                              gchar const *new_href_abs_base);
+                                              gchar const *new_href_abs_base,
+                                              SerializationCache *cache);
+
+static void sp_repr_write_stream_node(Node *repr, Writer &out, gint indent_level,
+                                      bool add_whitespace, Glib::QueryQuark elide_prefix,
+                                      int inlineattrs, int indent,
+                                      gchar const *old_href_abs_base,
+                                      gchar const *new_href_abs_base,
+                                      SerializationCache *cache);
 
 static void sp_repr_write_stream_element(Node *repr, Writer &out,
                                          gint indent_level, bool add_whitespace,
@@ -62,7 +75,8 @@ static void sp_repr_write_stream_element(Node *repr, Writer &out,
                                          const AttributeVector & attributes,
                                          int inlineattrs, int indent,
                                          gchar const *old_href_abs_base,
-                                         gchar const *new_href_abs_base);
+                                         gchar const *new_href_abs_base,
+                                         SerializationCache *cache);
 
 
 class XmlSource
@@ -593,15 +607,130 @@ static Node *sp_repr_svg_read_node (Document *xml_doc, xmlNodePtr node, const gc
 }
 
 
+namespace {
+
+/**
+ * Writer that collects the serialized form of an element for the serialization cache.
+ * Once more than \a limit bytes were written, the collected bytes are passed on to the
+ * destination writer and so is everything written afterwards.
+ */
+class CaptureWriter : public Inkscape::IO::BasicWriter
+{
+public:
+    CaptureWriter(Writer &destination, std::size_t limit)
+        : BasicWriter(destination)
+        , _limit(limit)
+    {}
+
+    void close() override {}
+    void flush() override {}
+
+    void put(char ch) override
+    {
+        if (_spilled) {
+            destination->put(ch);
+        } else {
+            _buffer += ch;
+            _checkLimit();
+        }
+    }
+
+    void write(char const *data, std::size_t size) override
+    {
+        if (_spilled) {
+            destination->write(data, size);
+        } else {
+            _buffer.append(data, size);
+            _checkLimit();
+        }
+    }
+
+    /// Whether the output exceeded the limit and was passed on.
+    bool spilled() const { return _spilled; }
+
+    std::string release() { return std::move(_buffer); }
+
+private:
+    void _checkLimit()
+    {
+        if (_buffer.size() > _limit) {
+            destination->write(_buffer.data(), _buffer.size());
+            _buffer.clear();
+            _buffer.shrink_to_fit();
+            _spilled = true;
+        }
+    }
+
+    std::size_t _limit;
+    std::string _buffer;
+    bool _spilled = false;
+};
+
+/**
+ * Writer that collects the serialized document as a SerializedDocument, taking over the bytes
+ * of cached subtrees without copying them.
+ */
+class SnapshotWriter : public Inkscape::IO::BasicWriter
+{
+public:
+    void close() override {}
+    void flush() override {}
+    void put(char ch) override { _pending += ch; }
+    void write(char const *data, std::size_t size) override { _pending.append(data, size); }
+
+    void share(Inkscape::XML::SerializedDocument::Chunk chunk)
+    {
+        _flushPending();
+        _snapshot->append(std::move(chunk));
+    }
+
+    std::shared_ptr<Inkscape::XML::SerializedDocument> finish()
+    {
+        _flushPending();
+        return std::move(_snapshot);
+    }
+
+private:
+    void _flushPending()
+    {
+        if (!_pending.empty()) {
+            _snapshot->append(std::make_shared<std::string const>(std::move(_pending)));
+            _pending.clear();
+        }
+    }
+
+    std::shared_ptr<Inkscape::XML::SerializedDocument> _snapshot = std::make_shared<Inkscape::XML::SerializedDocument>();
+    std::string _pending;
+};
+
+void write_cached_bytes(Writer &out, Inkscape::XML::SerializedDocument::Chunk const &bytes)
+{
+    if (auto snapshot = dynamic_cast<SnapshotWriter *>(&out)) {
+        snapshot->share(bytes);
+    } else {
+        out.write(bytes->data(), bytes->size());
+    }
+}
+
+} // namespace
+
 static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
                     gchar const *default_ns,
                     gchar const *old_href_abs_base,
-                    gchar const *new_href_abs_base)
+                    gchar const *new_href_abs_base,
+                    SerializationCache *cache = nullptr)
 {
     Inkscape::Preferences *prefs = Inkscape::Preferences::get();
     bool inlineattrs = prefs->getBool("/options/svgoutput/inlineattrs");
     int indent = prefs->getInt("/options/svgoutput/indent", 2);
 
+    if (cache) {
+        g_return_if_fail(&cache->document() == doc);
+        cache->begin({inlineattrs, indent,
+                      old_href_abs_base ? old_href_abs_base : "",
+                      new_href_abs_base ? new_href_abs_base : ""});
+    }
+
     /* fixme: do this The Right Way */
     out->writeString( "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"no\"?>\n" );
 
@@ -616,7 +745,7 @@ static void sp_repr_save_writer(Document *doc, Inkscape::IO::Writer *out,
         Inkscape::XML::NodeType const node_type = repr->type();
         if ( node_type == Inkscape::XML::NodeType::ELEMENT_NODE ) {
             sp_repr_write_stream_root_element(repr, *out, TRUE, default_ns, inlineattrs, indent,
-                                              old_href_abs_base, new_href_abs_base);
+                                              old_href_abs_base, new_href_abs_base, cache);
         } else {
             sp_repr_write_stream(repr, *out, 0, TRUE, GQuark(0), inlineattrs, indent,
                                  old_href_abs_base, new_href_abs_base);
@@ -644,30 +773,138 @@ Glib::ustring sp_repr_save_buf(Document *doc)
 
 void sp_repr_save_stream(Document *doc, FILE *fp, gchar const *default_ns, bool compress,
                     gchar const *const old_href_abs_base,
-                    gchar const *const new_href_abs_base)
+                    gchar const *const new_href_abs_base,
+                    SerializationCache *cache)
 {
     Inkscape::IO::FileOutputStream bout(fp);
-    Inkscape::IO::GzipOutputStream *gout = compress ? new Inkscape::IO::GzipOutputStream(bout) : nullptr;
+    Inkscape::IO::GzipOutputStream *gout = compress ? new Inkscape::IO::GzipOutputStream(bout, Inkscape::get_num_threads()) : nullptr;
     Inkscape::IO::OutputStreamWriter *out  = compress ? new Inkscape::IO::OutputStreamWriter( *gout ) : new Inkscape::IO::OutputStreamWriter( bout );
 
-    sp_repr_save_writer(doc, out, default_ns, old_href_abs_base, new_href_abs_base);
+    sp_repr_save_writer(doc, out, default_ns, old_href_abs_base, new_href_abs_base, cache);
 
     delete out;
     delete gout;
 }
 
+/**
+ * Serialize a document into a snapshot, which can be written to a file from another thread
+ * with sp_repr_save_snapshot_file().
+ *
+ * With a cache, taking the snapshot costs about as much as the changes since the previous save
+ * with that cache, as the bytes of unchanged subtrees are shared rather than serialized.
+ */
+std::shared_ptr<Inkscape::XML::SerializedDocument const> sp_repr_save_snapshot(Document *doc, gchar const *default_ns,
+                                                                             SerializationCache *cache)
+{
+    SnapshotWriter out;
+    sp_repr_save_writer(doc, &out, default_ns, nullptr, nullptr, cache);
+    return out.finish();
+}
+
+
+
+/**
+ * Open a temporary file next to an existing regular file, to be renamed over it once the
+ * new contents are completely written. Returns null if the file can't be replaced that way.
+ *
+ * \param utf8name The file to be replaced.
+ * \param tmpname Set to the name of the temporary file, in the GLib filename encoding.
+ */
+static FILE *sp_repr_open_replacement_file(gchar const *utf8name, std::string &tmpname)
+{
+    // Write symbolic links and special files in place so that they keep pointing to the same file.
+    if (!Inkscape::IO::file_test(utf8name, G_FILE_TEST_IS_REGULAR) ||
+        Inkscape::IO::file_test(utf8name, G_FILE_TEST_IS_SYMLINK)) {
+        return nullptr;
+    }
+
+    gchar *filename = g_filename_from_utf8(utf8name, -1, nullptr, nullptr, nullptr);
+    if (!filename) {
+        return nullptr;
+    }
+    GStatBuf st;
+    bool const exists = g_stat(filename, &st) == 0;
+    tmpname = std::string(filename) + ".XXXXXX";
+    g_free(filename);
+    if (!exists) {
+        return nullptr;
+    }
+
+    int fd = g_mkstemp(tmpname.data());
+    if (fd == -1) {
+        return nullptr;
+    }
+    FILE *file = fdopen(fd, "wb");
+    if (!file) {
+        g_close(fd, nullptr);
+        g_unlink(tmpname.c_str());
+        return nullptr;
+    }
+    // g_mkstemp() creates the file with mode 0600; keep the permissions of the original.
+    g_chmod(tmpname.c_str(), st.st_mode & 07777);
+    return file;
+}
+
+/**
+ * Open a file for saving, preferring a temporary file to be renamed over an existing one.
+ *
+ * \param tmpname Set to the name of the temporary file, or empty if writing directly.
+ */
+static FILE *sp_repr_open_save_file(gchar const *utf8name, std::string &tmpname)
+{
+    FILE *file = sp_repr_open_replacement_file(utf8name, tmpname);
+    if (file == nullptr) {
+        tmpname.clear();
+        Inkscape::IO::dump_fopen_call( utf8name, "B" );
+        file = Inkscape::IO::fopen_utf8name(utf8name, "w");
+    }
+    return file;
+}
+
+/**
+ * Close a file opened with sp_repr_open_save_file(), moving the temporary file into place if
+ * everything was written successfully.
+ */
+static bool sp_repr_close_save_file(FILE *file, gchar const *utf8name, std::string const &tmpname)
+{
+    bool const written = fflush(file) == 0 && !ferror(file);
+    if (fclose (file) != 0 || !written) {
+        if (!tmpname.empty()) {
+            g_unlink(tmpname.c_str());
+        }
+        return false;
+    }
+
+    if (!tmpname.empty()) {
+        gchar *target = g_filename_from_utf8(utf8name, -1, nullptr, nullptr, nullptr);
+        bool const renamed = target && g_rename(tmpname.c_str(), target) == 0;
+        g_free(target);
+        if (!renamed) {
+            g_unlink(tmpname.c_str());
+            return false;
+        }
+    }
 
+    return true;
+}
 
 /**
  * Returns true if file successfully saved.
  *
+ * An existing regular file is replaced atomically: the document is written to a temporary file
+ * in the same directory, which is then renamed over the original.
+ *
  * \param filename The actual file to do I/O to, which might be a temp file.
  *
  * \param for_filename The base URI [actually filename] to assume for purposes of rewriting
  *              xlink:href attributes.
+ *
+ * \param cache If given, the serialized form of subtrees which didn't change since the previous
+ *              save with the same cache is reused.
  */
 bool sp_repr_save_rebased_file(Document *doc, gchar const *const filename, gchar const *default_ns,
-                          gchar const *old_base, gchar const *for_filename)
+                          gchar const *old_base, gchar const *for_filename,
+                          SerializationCache *cache)
 {
     if (!filename) {
         return false;
@@ -680,8 +917,8 @@ bool sp_repr_save_rebased_file(Document *doc, gchar const *const filename, gchar
                      && strcasecmp(".svgz", filename + filename_len - 5) == 0 );
     }
 
-    Inkscape::IO::dump_fopen_call( filename, "B" );
-    FILE *file = Inkscape::IO::fopen_utf8name(filename, "w");
+    std::string tmpname;
+    FILE *file = sp_repr_open_save_file(filename, tmpname);
     if (file == nullptr) {
         return false;
     }
@@ -709,13 +946,55 @@ bool sp_repr_save_rebased_file(Document *doc, gchar const *const filename, gchar
          * to using sodipodi:absref instead of the xlink:href value,
          * then we should do `if streq() { free them and set both to NULL; }'. */
     }
-    sp_repr_save_stream(doc, file, default_ns, compress, old_href_abs_base.c_str(), new_href_abs_base.c_str());
+    sp_repr_save_stream(doc, file, default_ns, compress, old_href_abs_base.c_str(), new_href_abs_base.c_str(),
+                        cache);
 
-    if (fclose (file) != 0) {
+    return sp_repr_close_save_file(file, filename, tmpname);
+}
+
+/**
+ * Write a snapshot taken with sp_repr_save_snapshot() to a file, compressing it on \a num_threads
+ * threads if the name ends in ".svgz". Only touches the snapshot, so it may be called from any
+ * thread; take the thread count from get_num_threads() on the main thread beforehand.
+ *
+ * Returns true if file successfully saved.
+ */
+bool sp_repr_save_snapshot_file(Inkscape::XML::SerializedDocument const &snapshot, gchar const *filename,
+                                int num_threads)
+{
+    if (!filename) {
         return false;
     }
 
-    return true;
+    size_t const filename_len = strlen(filename);
+    bool const compress = filename_len > 5 && strcasecmp(".svgz", filename + filename_len - 5) == 0;
+
+    std::string tmpname;
+    FILE *file = sp_repr_open_save_file(filename, tmpname);
+    if (file == nullptr) {
+        return false;
+    }
+
+    if (compress) {
+        try {
+            Inkscape::IO::FileOutputStream bout(file);
+            Inkscape::IO::GzipOutputStream gout(bout, num_threads);
+            for (auto const &chunk : snapshot.chunks()) {
+                gout.write(chunk->data(), chunk->size());
+            }
+            gout.close();
+        } catch (Inkscape::IO::StreamException const &) {
+            // Leaves the error indicator of the file set.
+        }
+    } else {
+        for (auto const &chunk : snapshot.chunks()) {
+            if (fwrite(chunk->data(), 1, chunk->size(), file) != chunk->size()) {
+                break;
+            }
+        }
+    }
+
+    return sp_repr_close_save_file(file, filename, tmpname);
 }
 
 /**
@@ -830,7 +1109,8 @@ static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
                                   bool add_whitespace, gchar const *default_ns,
                                   int inlineattrs, int indent,
                                   gchar const *const old_href_base,
-                                  gchar const *const new_href_base)
+                                  gchar const *const new_href_base,
+                                  SerializationCache *cache)
 {
     using Inkscape::Util::ptr_shared;
 
@@ -884,7 +1164,46 @@ static void sp_repr_write_stream_root_element(Node *repr, Writer &out,
     }
 
     return sp_repr_write_stream_element(repr, out, 0, add_whitespace, elide_prefix, attributes,
-                                        inlineattrs, indent, old_href_base, new_href_base);
+                                        inlineattrs, indent, old_href_base, new_href_base, cache);
+}
+
+/**
+ * Write an element, reusing its serialized form from the cache if it didn't change since it
+ * was last written in the same context.
+ */
+static void sp_repr_write_stream_cached_element(Node *repr, Writer &out, gint indent_level,
+                                                bool add_whitespace, Glib::QueryQuark elide_prefix,
+                                                int inlineattrs, int indent,
+                                                gchar const *const old_href_base,
+                                                gchar const *const new_href_base,
+                                                SerializationCache &cache)
+{
+    SerializationCache::Context const context{elide_prefix.id(), indent_level, add_whitespace};
+
+    if (auto bytes = cache.lookup(*repr, context)) {
+        write_cached_bytes(out, bytes);
+        return;
+    }
+
+    if (cache.isOversized(*repr, context)) {
+        // Too large to be kept as a whole, but its children may be cached.
+        sp_repr_write_stream_element(repr, out, indent_level, add_whitespace, elide_prefix,
+                                     repr->attributeList(), inlineattrs, indent,
+                                     old_href_base, new_href_base, &cache);
+        return;
+    }
+
+    CaptureWriter capture(out, SerializationCache::MAX_ENTRY_SIZE);
+    sp_repr_write_stream_element(repr, capture, indent_level, add_whitespace, elide_prefix,
+                                 repr->attributeList(), inlineattrs, indent,
+                                 old_href_base, new_href_base, &cache);
+    if (capture.spilled()) {
+        cache.markOversized(*repr, context);
+    } else {
+        auto bytes = std::make_shared<std::string const>(capture.release());
+        write_cached_bytes(out, bytes);
+        cache.store(*repr, context, std::move(bytes));
+    }
 }
 
 void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
@@ -892,6 +1211,17 @@ void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
                            int inlineattrs, int indent,
                            gchar const *const old_href_base,
                            gchar const *const new_href_base)
+{
+    sp_repr_write_stream_node(repr, out, indent_level, add_whitespace, elide_prefix, inlineattrs, indent,
+                              old_href_base, new_href_base, nullptr);
+}
+
+static void sp_repr_write_stream_node(Node *repr, Writer &out, gint indent_level,
+                                      bool add_whitespace, Glib::QueryQuark elide_prefix,
+                                      int inlineattrs, int indent,
+                                      gchar const *const old_href_base,
+                                      gchar const *const new_href_base,
+                                      SerializationCache *cache)
 {
     switch (repr->type()) {
         case Inkscape::XML::NodeType::TEXT_NODE: {
@@ -914,11 +1244,17 @@ void sp_repr_write_stream( Node *repr, Writer &out, gint indent_level,
             break;
         }
         case Inkscape::XML::NodeType::ELEMENT_NODE: {
+            if (cache) {
+                sp_repr_write_stream_cached_element(repr, out, indent_level, add_whitespace, elide_prefix,
+                                                    inlineattrs, indent, old_href_base, new_href_base,
+                                                    *cache);
+                break;
+            }
             sp_repr_write_stream_element( repr, out, indent_level,
                                           add_whitespace, elide_prefix,
                                           repr->attributeList(),
                                           inlineattrs, indent,
-                                          old_href_base, new_href_base);
+                                          old_href_base, new_href_base, nullptr);
             break;
         }
         case Inkscape::XML::NodeType::DOCUMENT_NODE: {
@@ -938,7 +1274,8 @@ void sp_repr_write_stream_element( Node * repr, Writer & out,
                                    const AttributeVector & attributes, 
                                    int inlineattrs, int indent,
                                    gchar const *old_href_base,
-                                   gchar const *new_href_base )
+                                   gchar const *new_href_base,
+                                   SerializationCache *cache )
 {
     Node *child = nullptr;
     bool loose = false;
@@ -1013,9 +1350,9 @@ void sp_repr_write_stream_element( Node * repr, Writer & out,
             out.writeChar('\n');
         }
         for (child = repr->firstChild(); child != nullptr; child = child->next()) {
-            sp_repr_write_stream(child, out, ( loose ? indent_level + 1 : 0 ),
-                                 add_whitespace, elide_prefix, inlineattrs, indent,
-                                 old_href_base, new_href_base);
+            sp_repr_write_stream_node(child, out, ( loose ? indent_level + 1 : 0 ),
+                                      add_whitespace, elide_prefix, inlineattrs, indent,
+                                      old_href_base, new_href_base, cache);
         }
 
         if (loose && add_whitespace && indent) {
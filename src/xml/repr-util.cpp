@@ -248,11 +248,13 @@ gchar const *sp_xml_ns_prefix_uri(gchar const *prefix)
  */
 int sp_repr_compare_position(Inkscape::XML::Node const *first, Inkscape::XML::Node const *second)
 {
-    int p1, p2;
+    // Siblings compare by their order keys, which unlike their positions need no recounting
+    // after the siblings are reordered.
+    std::uint64_t p1, p2;
     if (first->parent() == second->parent()) {
         /* Basic case - first and second have same parent */
-        p1 = first->position();
-        p2 = second->position();
+        p1 = first->orderKey();
+        p2 = second->orderKey();
     } else {
         /* Special case - the two objects have different parents.  They
            could be in different groups or on different layers for
@@ -270,8 +272,8 @@ int sp_repr_compare_position(Inkscape::XML::Node const *first, Inkscape::XML::No
             Inkscape::XML::Node const *to_first = find_containing_child(first, ancestor);
             Inkscape::XML::Node const *to_second = find_containing_child(second, ancestor);
             g_assert(to_second->parent() == to_first->parent());
-            p1 = to_first->position();
-            p2 = to_second->position();
+            p1 = to_first->orderKey();
+            p2 = to_second->orderKey();
         }
     }
 
@@ -15,6 +15,7 @@
 #ifndef SEEN_SP_REPR_H
 #define SEEN_SP_REPR_H
 
+#include <memory>
 #include <vector>
 #include <glibmm/quark.h>
 
@@ -38,6 +39,10 @@ namespace Inkscape {
 namespace IO {
 class Writer;
 } // namespace IO
+namespace XML {
+class SerializationCache;
+class SerializedDocument;
+} // namespace XML
 } // namespace Inkscape
 
 namespace Geom {
@@ -66,12 +71,19 @@ Glib::ustring sp_repr_save_buf(Inkscape::XML::Document *doc);
 void sp_repr_save_stream(Inkscape::XML::Document *doc, FILE *to_file,
                          char const *default_ns = nullptr, bool compress = false,
                          char const *old_href_base = nullptr,
-                         char const *new_href_base = nullptr);
+                         char const *new_href_base = nullptr,
+                         Inkscape::XML::SerializationCache *cache = nullptr);
 
 bool sp_repr_save_file(Inkscape::XML::Document *doc, char const *filename, char const *default_ns=nullptr);
 bool sp_repr_save_rebased_file(Inkscape::XML::Document *doc, char const *filename_utf8,
                                char const *default_ns,
-                               char const *old_base, char const *new_base_filename);
+                               char const *old_base, char const *new_base_filename,
+                               Inkscape::XML::SerializationCache *cache = nullptr);
+std::shared_ptr<Inkscape::XML::SerializedDocument const>
+sp_repr_save_snapshot(Inkscape::XML::Document *doc, char const *default_ns = nullptr,
+                      Inkscape::XML::SerializationCache *cache = nullptr);
+bool sp_repr_save_snapshot_file(Inkscape::XML::SerializedDocument const &snapshot, char const *filename_utf8,
+                                int num_threads = 1);
 
 
 /* CSS stuff */
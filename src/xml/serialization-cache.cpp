@@ -0,0 +1,209 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::XML::SerializationCache - reuse serialized XML of unchanged subtrees
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#include "xml/serialization-cache.h"
+
+#include <algorithm>
+
+#include "xml/document.h"
+#include "xml/node.h"
+
+namespace Inkscape {
+namespace XML {
+
+SerializationCache::SerializationCache(Document &doc)
+    : _doc(doc)
+{
+    _doc.addSubtreeObserver(*this);
+}
+
+SerializationCache::~SerializationCache()
+{
+    _doc.removeSubtreeObserver(*this);
+}
+
+void SerializationCache::begin(Settings const &settings)
+{
+    auto it = std::find_if(_generations.begin(), _generations.end(),
+                           [&] (Generation const &generation) { return generation.settings == settings; });
+    if (it == _generations.end()) {
+        if (_generations.size() >= MAX_SETTINGS) {
+            _generations.pop_back();
+        }
+        _generations.insert(_generations.begin(), Generation{settings, {}});
+    } else {
+        std::rotate(_generations.begin(), it, it + 1);
+    }
+}
+
+SerializationCache::Entries &SerializationCache::_current()
+{
+    if (_generations.empty()) {
+        _generations.emplace_back();
+    }
+    return _generations.front().entries;
+}
+
+SerializationCache::Entries const *SerializationCache::_current() const
+{
+    return _generations.empty() ? nullptr : &_generations.front().entries;
+}
+
+bool SerializationCache::_empty() const
+{
+    return std::all_of(_generations.begin(), _generations.end(),
+                       [] (Generation const &generation) { return generation.entries.empty(); });
+}
+
+std::shared_ptr<std::string const> SerializationCache::lookup(Node const &node, Context const &context) const
+{
+    auto entries = _current();
+    if (!entries) {
+        return nullptr;
+    }
+    auto it = entries->find(&node);
+    if (it == entries->end() || it->second.oversized || !(it->second.context == context)) {
+        return nullptr;
+    }
+    return it->second.bytes;
+}
+
+bool SerializationCache::isOversized(Node const &node, Context const &context) const
+{
+    auto entries = _current();
+    if (!entries) {
+        return false;
+    }
+    auto it = entries->find(&node);
+    return it != entries->end() && it->second.oversized && it->second.context == context;
+}
+
+void SerializationCache::store(Node &node, Context const &context, std::shared_ptr<std::string const> bytes)
+{
+    auto &entries = _current();
+    _purgeDescendants(entries, node);
+    auto &entry = entries[&node];
+    entry.context = context;
+    entry.oversized = false;
+    entry.bytes = std::move(bytes);
+}
+
+void SerializationCache::markOversized(Node const &node, Context const &context)
+{
+    auto &entry = _current()[&node];
+    entry.context = context;
+    entry.oversized = true;
+    entry.bytes.reset();
+}
+
+std::size_t SerializationCache::size() const
+{
+    std::size_t total = 0;
+    for (auto const &generation : _generations) {
+        for (auto const &[node, entry] : generation.entries) {
+            if (entry.bytes) {
+                total += entry.bytes->size();
+            }
+        }
+    }
+    return total;
+}
+
+/// Drop the entries of a changed node and of everything that contains it.
+void SerializationCache::_invalidate(Node &node)
+{
+    if (_empty()) {
+        return;
+    }
+    for (Node *n = &node; n; n = n->parent()) {
+        for (auto &generation : _generations) {
+            generation.entries.erase(n);
+        }
+    }
+}
+
+void SerializationCache::_purgeDescendants(Entries &entries, Node &node)
+{
+    for (Node *child = node.firstChild(); child; child = child->next()) {
+        _purgeSubtree(entries, *child);
+    }
+}
+
+void SerializationCache::_purgeSubtree(Entries &entries, Node &node)
+{
+    if (entries.empty()) {
+        return;
+    }
+    entries.erase(&node);
+    _purgeDescendants(entries, node);
+}
+
+/// Drop the entries of a subtree leaving or entering the document, as its nodes may be freed or
+/// may have been modified while they were not observed.
+void SerializationCache::_purgeSubtree(Node &node)
+{
+    for (auto &generation : _generations) {
+        _purgeSubtree(generation.entries, node);
+    }
+}
+
+void SerializationCache::notifyChildAdded(Node &node, Node &child, Node * /*prev*/)
+{
+    _purgeSubtree(child);
+    _invalidate(node);
+}
+
+void SerializationCache::notifyChildRemoved(Node &node, Node &child, Node * /*prev*/)
+{
+    _purgeSubtree(child);
+    _invalidate(node);
+}
+
+void SerializationCache::notifyChildOrderChanged(Node &node, Node & /*child*/, Node * /*old_prev*/,
+                                                 Node * /*new_prev*/)
+{
+    _invalidate(node);
+}
+
+void SerializationCache::notifyContentChanged(Node &node, Util::ptr_shared /*old_content*/,
+                                              Util::ptr_shared /*new_content*/)
+{
+    _invalidate(node);
+}
+
+void SerializationCache::notifyAttributeChanged(Node &node, GQuark /*name*/, Util::ptr_shared /*old_value*/,
+                                                Util::ptr_shared /*new_value*/)
+{
+    _invalidate(node);
+}
+
+void SerializationCache::notifyAttributesChanged(Node &node, std::span<AttributeChange const> /*changes*/)
+{
+    _invalidate(node);
+}
+
+void SerializationCache::notifyElementNameChanged(Node &node, GQuark /*old_name*/, GQuark /*new_name*/)
+{
+    _invalidate(node);
+}
+
+} // namespace XML
+} // namespace Inkscape
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
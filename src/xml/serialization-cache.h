@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Inkscape::XML::SerializationCache - reuse serialized XML of unchanged subtrees
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+
+#ifndef SEEN_INKSCAPE_XML_SERIALIZATION_CACHE_H
+#define SEEN_INKSCAPE_XML_SERIALIZATION_CACHE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "xml/node-observer.h"
+
+namespace Inkscape {
+namespace XML {
+
+struct Document;
+
+/**
+ * @brief Cache of the serialized form of clean element subtrees
+ *
+ * The cache watches the document through a subtree observer. Any change to a node makes the
+ * cached bytes of that node and of all its ancestors stale, so on the next save only the
+ * changed parts need to be serialized again; everything else is copied from the cache.
+ *
+ * To keep the memory use close to the size of the saved file, an element is only cached
+ * when its serialized form is at most MAX_ENTRY_SIZE bytes, and caching an element drops
+ * the entries of its descendants. Larger elements (layers, the root) are written
+ * structurally on every save, with their children coming from the cache.
+ *
+ * The cached bytes depend on the output settings, so entries are kept separately for the last
+ * MAX_SETTINGS different settings: saving to a file and autosaving, which don't rebase hrefs
+ * the same way, can alternate without dropping each other's entries. The bytes are immutable
+ * and shared with the SerializedDocument snapshots taken from them, so they can be written out
+ * by another thread.
+ */
+class SerializationCache : public NodeObserver
+{
+public:
+    /// Elements whose serialized size exceeds this are not cached as a whole.
+    static constexpr std::size_t MAX_ENTRY_SIZE = 32 * 1024;
+
+    /// Number of different settings whose entries are kept at the same time.
+    static constexpr std::size_t MAX_SETTINGS = 2;
+
+    /// Document-wide settings that the serialized bytes depend on.
+    struct Settings
+    {
+        int inlineattrs = 0;
+        int indent = 0;
+        std::string old_href_base;
+        std::string new_href_base;
+
+        bool operator==(Settings const &other) const = default;
+    };
+
+    /// Per-element context that the serialized bytes depend on.
+    struct Context
+    {
+        GQuark elide_prefix = 0;
+        int indent_level = 0;
+        bool add_whitespace = false;
+
+        bool operator==(Context const &other) const = default;
+    };
+
+    explicit SerializationCache(Document &doc);
+    ~SerializationCache() override;
+
+    SerializationCache(SerializationCache const &) = delete;
+    SerializationCache &operator=(SerializationCache const &) = delete;
+
+    Document &document() const { return _doc; }
+
+    /// Start a save with the given settings, dropping the entries of the least recently used
+    /// settings if these are new.
+    void begin(Settings const &settings);
+
+    /**
+     * Look up the serialized bytes of @a node.
+     * @return The bytes, or null if the node has to be serialized.
+     */
+    std::shared_ptr<std::string const> lookup(Node const &node, Context const &context) const;
+
+    /// Whether @a node was found to be too large to be cached during an earlier save.
+    bool isOversized(Node const &node, Context const &context) const;
+
+    /// Store the serialized bytes of @a node, replacing the entries of its descendants.
+    void store(Node &node, Context const &context, std::shared_ptr<std::string const> bytes);
+
+    /// Remember that @a node is too large to be cached, so that no capture is attempted.
+    void markOversized(Node const &node, Context const &context);
+
+    /// Drop all entries.
+    void clear() { _generations.clear(); }
+
+    /// Total number of cached bytes.
+    std::size_t size() const;
+
+    void notifyChildAdded(Node &node, Node &child, Node *prev) override;
+    void notifyChildRemoved(Node &node, Node &child, Node *prev) override;
+    void notifyChildOrderChanged(Node &node, Node &child, Node *old_prev, Node *new_prev) override;
+    void notifyContentChanged(Node &node, Util::ptr_shared old_content, Util::ptr_shared new_content) override;
+    void notifyAttributeChanged(Node &node, GQuark name, Util::ptr_shared old_value,
+                                Util::ptr_shared new_value) override;
+    void notifyAttributesChanged(Node &node, std::span<AttributeChange const> changes) override;
+    void notifyElementNameChanged(Node &node, GQuark old_name, GQuark new_name) override;
+
+private:
+    struct Entry
+    {
+        Context context;
+        bool oversized = false;
+        std::shared_ptr<std::string const> bytes;
+    };
+
+    using Entries = std::unordered_map<Node const *, Entry>;
+
+    /// The entries written with one set of settings.
+    struct Generation
+    {
+        Settings settings;
+        Entries entries;
+    };
+
+    /// The entries for the settings of the current save.
+    Entries &_current();
+    Entries const *_current() const;
+    bool _empty() const;
+
+    void _invalidate(Node &node);
+    void _purgeSubtree(Node &node);
+    static void _purgeDescendants(Entries &entries, Node &node);
+    static void _purgeSubtree(Entries &entries, Node &node);
+
+    Document &_doc;
+    /// Most recently used first.
+    std::vector<Generation> _generations;
+};
+
+/**
+ * @brief Immutable serialized form of a document
+ *
+ * A snapshot taken on the main thread, consisting of the bytes written for changed nodes and of
+ * the cached bytes of unchanged subtrees, which are shared rather than copied. It does not refer
+ * to the XML tree, so it can be written out by another thread while the document is edited.
+ */
+class SerializedDocument
+{
+public:
+    using Chunk = std::shared_ptr<std::string const>;
+
+    void append(Chunk chunk)
+    {
+        if (chunk && !chunk->empty()) {
+            _size += chunk->size();
+            _chunks.push_back(std::move(chunk));
+        }
+    }
+
+    std::vector<Chunk> const &chunks() const { return _chunks; }
+
+    /// Total number of bytes.
+    std::size_t size() const { return _size; }
+
+private:
+    std::vector<Chunk> _chunks;
+    std::size_t _size = 0;
+};
+
+} // namespace XML
+} // namespace Inkscape
+
+#endif // SEEN_INKSCAPE_XML_SERIALIZATION_CACHE_H
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -11,6 +11,8 @@
  */
 
 #include <glib.h> // g_assert()
+#include <span>
+#include <utility>
 
 #include "xml/simple-document.h"
 #include "xml/event-fns.h"
@@ -48,6 +50,35 @@ Inkscape::XML::Event *SimpleDocument::commitUndoable() {
     return _log_builder.detach();
 }
 
+void SimpleDocument::beginBulkAttributes() {
+    g_assert(!_in_bulk_attributes);
+    _in_bulk_attributes = true;
+}
+
+void SimpleDocument::endBulkAttributes() {
+    g_assert(_in_bulk_attributes);
+    _in_bulk_attributes = false;
+    auto nodes = std::exchange(_bulk_nodes, {});
+    auto changes = std::exchange(_bulk_changes, {});
+    if (changes.empty()) {
+        return;
+    }
+
+    if (_in_transaction) {
+        _log_builder.setAttributes(nodes, changes);
+    }
+
+    // Each run of changes to the same node goes to its observers at once.
+    auto const all = std::span<AttributeChange const>(changes);
+    for (std::size_t begin = 0, end = 0; begin < nodes.size(); begin = end) {
+        while (end < nodes.size() && nodes[end] == nodes[begin]) {
+            ++end;
+        }
+        auto &node = dynamic_cast<SimpleNode &>(*nodes[begin]);
+        node._observers.notifyAttributesChanged(node, all.subspan(begin, end - begin));
+    }
+}
+
 Node *SimpleDocument::createElement(char const *name) {
     return new ElementNode(g_quark_from_string(name), this);
 }
@@ -72,6 +103,7 @@ void SimpleDocument::notifyChildAdded(Node &parent,
                                       Node &child,
                                       Node *prev)
 {
+    g_assert(!_in_bulk_attributes);
     if (_in_transaction) {
         _log_builder.addChild(parent, child, prev);
     }
@@ -81,6 +113,7 @@ void SimpleDocument::notifyChildRemoved(Node &parent,
                                         Node &child,
                                         Node *prev)
 {
+    g_assert(!_in_bulk_attributes);
     if (_in_transaction) {
         _log_builder.removeChild(parent, child, prev);
     }
@@ -110,13 +143,17 @@ void SimpleDocument::notifyAttributeChanged(Node &node,
                                             Util::ptr_shared old_value,
                                             Util::ptr_shared new_value)
 {
-    if (_in_transaction) {
+    if (_in_bulk_attributes) {
+        _bulk_nodes.push_back(&node);
+        _bulk_changes.push_back({name, old_value, new_value});
+    } else if (_in_transaction) {
         _log_builder.setAttribute(node, name, old_value, new_value);
     }
 }
 
 void SimpleDocument::notifyElementNameChanged(Node& node, GQuark old_name, GQuark new_name)
 {
+    g_assert(!_in_bulk_attributes);
     if (_in_transaction) {
         _log_builder.setElementName(node, old_name, new_name);
     }
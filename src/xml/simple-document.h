@@ -40,6 +40,11 @@ public:
     void commit() override;
     Inkscape::XML::Event *commitUndoable() override;
 
+    bool inBulkAttributes() override { return _in_bulk_attributes; }
+
+    void beginBulkAttributes() override;
+    void endBulkAttributes() override;
+
     Node *createElement(char const *name) override;
     Node *createTextNode(char const *content) override;
     Node *createTextNode(char const *content, bool const is_CData) override;
@@ -78,6 +83,11 @@ protected:
 private:
     bool _in_transaction;
     LogBuilder _log_builder;
+
+    bool _in_bulk_attributes = false;
+    /// The attribute changes held back since beginBulkAttributes(), and the node of each
+    EventChgAttrs::Nodes _bulk_nodes;
+    EventChgAttrs::Changes _bulk_changes;
 };
 
 }
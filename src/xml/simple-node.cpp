@@ -20,6 +20,7 @@
 
 #include <algorithm>
 #include <cstring>
+#include <limits>
 #include <string>
 
 #include <glib.h>
@@ -208,6 +209,7 @@ SimpleNode::SimpleNode(SimpleNode const &node, Document *document)
             _first_child = child_copy;
         }
         _last_child = child_copy;
+        _assignOrderKey(child_copy);
 
         child_copy->release(); // release to avoid a leak
     }
@@ -240,6 +242,73 @@ gchar const *SimpleNode::attribute(gchar const *name) const {
     return nullptr;
 }
 
+namespace {
+
+/// Room left between the order keys of children appended one after the other.
+constexpr std::uint64_t ORDER_KEY_STEP = std::uint64_t(1) << 32;
+
+} // namespace
+
+/**
+ * Give \a child, just linked in among its siblings, an order key between theirs.
+ */
+void SimpleNode::_assignOrderKey(SimpleNode *child)
+{
+    std::uint64_t const lower = child->_prev ? child->_prev->_order_key : 0;
+    std::uint64_t const upper = child->_next ? child->_next->_order_key : std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t const gap = upper - lower;
+    if (gap < 2) {
+        _spreadOrderKeys(child);
+    } else if (child->_next) {
+        child->_order_key = lower + gap / 2;
+    } else {
+        child->_order_key = lower + std::min(gap / 2, ORDER_KEY_STEP);
+    }
+}
+
+/**
+ * Make room for the order key of \a child by giving a run of siblings around it evenly spaced
+ * keys. The run is doubled until the keys just outside it leave each node of the run a gap
+ * larger than the run's length, which keeps the cost amortised logarithmic per insertion
+ * (the order-maintenance scheme of Dietz and Sleator, as simplified by Bender et al.).
+ */
+void SimpleNode::_spreadOrderKeys(SimpleNode *child)
+{
+    SimpleNode *first = child;
+    SimpleNode *last = child;
+    std::uint64_t count = 1;
+    for (std::uint64_t grow = 1;; grow *= 2) {
+        for (std::uint64_t i = 0; i < grow && first->_prev; ++i, ++count) {
+            first = first->_prev;
+        }
+        for (std::uint64_t i = 0; i < grow && last->_next; ++i, ++count) {
+            last = last->_next;
+        }
+
+        std::uint64_t const lower = first->_prev ? first->_prev->_order_key : 0;
+        std::uint64_t const upper = last->_next ? last->_next->_order_key : std::numeric_limits<std::uint64_t>::max();
+        std::uint64_t step = (upper - lower) / (count + 1);
+        bool const all = !first->_prev && !last->_next;
+        if (step <= count && !all) {
+            continue;
+        }
+
+        if (!last->_next && count < ORDER_KEY_STEP) {
+            // Leave the room after the last child for appending.
+            step = std::min(step, ORDER_KEY_STEP);
+        }
+        std::uint64_t key = lower;
+        for (auto node = first;; node = node->_next) {
+            key += step;
+            node->_order_key = key;
+            if (node == last) {
+                break;
+            }
+        }
+        return;
+    }
+}
+
 unsigned SimpleNode::position() const {
     g_return_val_if_fail(_parent != nullptr, 0);
     return _parent->_childPosition(*this);
@@ -389,7 +458,9 @@ SimpleNode::setAttributeImpl(gchar const *name, gchar const *value)
 
     if ( new_value != old_value && (!old_value || !new_value || strcmp(old_value, new_value))) {
         _document->logger()->notifyAttributeChanged(*this, key, old_value, new_value);
-        _observers.notifyAttributeChanged(*this, key, old_value, new_value);
+        if (!_document->inBulkAttributes()) {
+            _observers.notifyAttributeChanged(*this, key, old_value, new_value);
+        }
         //g_warning( "setAttribute notified: %s: %s: %s: %s", name, element.c_str(), old_value, new_value ); 
     }
     g_free( cleaned_value );
@@ -453,6 +524,7 @@ void SimpleNode::addChild(Node *generic_child, Node *generic_ref) {
 
     child->_setParent(this);
     child->_next = next;
+    _assignOrderKey(child);
     _child_count++;
 
     _document->logger()->notifyChildAdded(*this, *child, ref);
@@ -544,6 +616,7 @@ void SimpleNode::changeOrder(Node *generic_child, Node *generic_ref) {
         _last_child = child;
     }
 
+    _assignOrderKey(child);
     _cached_positions_valid = false;
 
     _document->logger()->notifyChildOrderChanged(*this, *child, prev, ref);
@@ -557,6 +630,11 @@ void SimpleNode::setPosition(int pos) {
     // a negative position is the same as an infinitely large position
 
     SimpleNode *ref=nullptr;
+    if (pos < 0) {
+        // no need to walk the siblings to get to the end
+        ref = _parent->_last_child != this ? _parent->_last_child : _prev;
+        pos = 0;
+    }
     for ( SimpleNode *sibling = _parent->_first_child ;
           sibling && pos ; sibling = sibling->_next )
     {
@@ -79,6 +79,7 @@ public:
     void changeOrder(Node *child, Node *ref) override;
 
     unsigned position() const override;
+    std::uint64_t orderKey() const override { return _parent ? _order_key : 0; }
     void setPosition(int pos) override;
 
     char const *attribute(char const *key) const override;
@@ -121,16 +122,21 @@ protected:
     void setAttributeImpl(char const *key, char const *value) override;
 
 private:
+    friend class SimpleDocument; // to notify observers of attribute changes made in bulk
+
     void operator=(Node const &); // no assign
 
     void _setParent(SimpleNode *parent);
     unsigned _childPosition(SimpleNode const &child) const;
+    void _assignOrderKey(SimpleNode *child);
+    void _spreadOrderKeys(SimpleNode *child);
 
     SimpleNode *_parent;
     SimpleNode *_next;
     SimpleNode *_prev;
     Document *_document;
     mutable unsigned _cached_position;
+    std::uint64_t _order_key{0};
 
     int _name;
 
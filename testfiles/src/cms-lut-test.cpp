@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Colour transform lookup table test
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+
+#include "color/cms-lut.h"
+
+using Inkscape::CMSLut;
+
+namespace {
+
+using Function = std::function<void(double const *in, double *out)>;
+
+// Sample a function of colours with channels in [0, 1].
+CMSLut::Sampler sampler(Function const &f)
+{
+    return [f] (std::uint16_t const *in, std::uint16_t *out, unsigned count) {
+        for (unsigned i = 0; i < count; i++, in += 3, out += 3) {
+            double const x[3] = {in[0] / 65535.0, in[1] / 65535.0, in[2] / 65535.0};
+            double y[3];
+            f(x, y);
+            for (int c = 0; c < 3; c++) {
+                out[c] = std::lround(y[c] * 65535);
+            }
+        }
+    };
+}
+
+} // namespace
+
+TEST(CMSLutTest, Identity)
+{
+    auto const lut = CMSLut(sampler([] (double const *in, double *out) { std::copy_n(in, 3, out); }));
+
+    for (int v = 0; v < 256; v++) {
+        unsigned char px[4] = {(unsigned char)v, (unsigned char)(255 - v), (unsigned char)(v / 3), 42};
+        lut.apply(px, 1);
+        EXPECT_EQ(px[0], v);
+        EXPECT_EQ(px[1], 255 - v);
+        EXPECT_EQ(px[2], v / 3);
+        EXPECT_EQ(px[3], 42);
+    }
+}
+
+TEST(CMSLutTest, Interpolation)
+{
+    // Mixes channels and bends them, as a change of primaries and transfer curves would.
+    auto const f = [] (double const *in, double *out) {
+        out[0] = std::pow(0.7 * in[0] + 0.3 * in[1], 1.3);
+        out[1] = std::pow(in[1], 0.8);
+        out[2] = 0.5 * in[2] + 0.5 * in[0] * in[1];
+    };
+    auto const lut = CMSLut(sampler(f));
+
+    for (int r = 0; r < 256; r += 5) {
+        for (int g = 0; g < 256; g += 3) {
+            for (int b = 0; b < 256; b += 17) {
+                unsigned char px[4] = {(unsigned char)r, (unsigned char)g, (unsigned char)b, 255};
+                lut.apply(px, 1);
+
+                double const in[3] = {r / 255.0, g / 255.0, b / 255.0};
+                double out[3];
+                f(in, out);
+                for (int c = 0; c < 3; c++) {
+                    EXPECT_LE(std::abs(px[c] - std::lround(out[c] * 255)), 1) << r << " " << g << " " << b;
+                }
+            }
+        }
+    }
+}
+
+TEST(CMSLutTest, Buffer)
+{
+    auto const lut = CMSLut(sampler([] (double const *in, double *out) {
+        for (int c = 0; c < 3; c++) {
+            out[c] = 1 - in[c];
+        }
+    }), 9);
+
+    unsigned char px[3 * 4] = {0, 0, 0, 1, 255, 255, 255, 2, 10, 128, 200, 3};
+    lut.apply(px, 3);
+    unsigned char const expected[3 * 4] = {255, 255, 255, 1, 0, 0, 0, 2, 245, 127, 55, 3};
+    for (int i = 0; i < 3 * 4; i++) {
+        EXPECT_EQ(px[i], expected[i]) << i;
+    }
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
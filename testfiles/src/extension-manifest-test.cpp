@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Tests for extensions registered without being built
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ *
+ * Released under GNU GPL version 2 or later, read the file 'COPYING' for more information
+ */
+
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include <glib/gstdio.h>
+
+#include "extension/db.h"
+#include "extension/implementation/implementation.h"
+#include "extension/input.h"
+#include "extension/manifest.h"
+#include "extension/system.h"
+
+using namespace Inkscape::Extension;
+
+namespace {
+
+std::string input_description(std::string const &id)
+{
+    return "<inkscape-extension xmlns=\"" INKSCAPE_EXTENSION_URI "\">"
+           "<name>Deferred</name><id>" + id + "</id>"
+           "<input><extension>.deferred</extension><mimetype>text/x-deferred</mimetype></input>"
+           "</inkscape-extension>";
+}
+
+void write_file(std::string const &path, std::string const &content)
+{
+    ASSERT_TRUE(g_file_set_contents(path.c_str(), content.c_str(), content.size(), nullptr));
+}
+
+} // namespace
+
+TEST(ExtensionManifestTest, DeferredModuleIsBuiltOnFirstUse)
+{
+    std::string const id = "org.inkscape.test.deferred-input";
+    int builds = 0;
+    db.defer(id, MODULE_INPUT, [&] {
+        ++builds;
+        build_from_mem(input_description(id).c_str(), std::make_unique<Implementation::Implementation>());
+    });
+    EXPECT_EQ(builds, 0);
+
+    // Asking for the list of inputs builds it, and only once.
+    DB::InputList inputs;
+    db.get_input_list(inputs);
+    EXPECT_EQ(builds, 1);
+    auto input = db.get(id.c_str());
+    ASSERT_TRUE(input);
+    EXPECT_NE(std::find(inputs.begin(), inputs.end(), input), inputs.end());
+    EXPECT_EQ(builds, 1);
+
+    // A deferred module is also built when it is looked up by ID.
+    db.defer(id + "2", MODULE_INPUT, [&] {
+        ++builds;
+        build_from_mem(input_description(id + "2").c_str(), std::make_unique<Implementation::Implementation>());
+    });
+    EXPECT_TRUE(db.get((id + "2").c_str()));
+    EXPECT_EQ(builds, 2);
+}
+
+TEST(ExtensionManifestTest, EntriesFollowTheFiles)
+{
+    std::string const inx = "ExtensionManifestTest.inx";
+    std::string const cache = "ExtensionManifestTest.manifest";
+    write_file(inx, input_description("org.inkscape.test.manifest"));
+
+    {
+        Manifest manifest(cache);
+        auto entry = manifest.lookup(inx);
+        ASSERT_TRUE(entry);
+        EXPECT_EQ(entry->id, "org.inkscape.test.manifest");
+        EXPECT_EQ(entry->type, MODULE_INPUT);
+        manifest.save();
+    }
+    {
+        Manifest manifest(cache);
+        auto entry = manifest.lookup(inx);
+        ASSERT_TRUE(entry);
+        EXPECT_EQ(entry->id, "org.inkscape.test.manifest");
+    }
+
+    // A changed file is read again.
+    write_file(inx, input_description("org.inkscape.test.manifest.changed"));
+    {
+        Manifest manifest(cache);
+        auto entry = manifest.lookup(inx);
+        ASSERT_TRUE(entry);
+        EXPECT_EQ(entry->id, "org.inkscape.test.manifest.changed");
+    }
+
+    // Files that don't describe an extension have no entry.
+    write_file(inx, "<svg/>");
+    EXPECT_FALSE(Manifest(cache).lookup(inx));
+
+    g_remove(inx.c_str());
+    g_remove(cache.c_str());
+}
+
+/*
+  Local Variables:
+  mode:c++
+  c-file-style:"stroustrup"
+  c-file-offsets:((innamespace . 0)(inline-open . 0)(case-label . +))
+  indent-tabs-mode:nil
+  fill-column:99
+  End:
+*/
+// vim: filetype=cpp:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -0,0 +1,71 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Packed glyph outline test
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include "libnrtype/font-glyph.h"
+#include <2geom/pathvector.h>
+#include <2geom/transforms.h>
+
+namespace {
+
+using Verb = GlyphOutline::Verb;
+
+// Two contours in font units: a line, a quadratic and a cubic segment, then a triangle.
+GlyphOutline make_outline()
+{
+    return GlyphOutline({Verb::MOVE_TO, Verb::LINE_TO, Verb::QUAD_TO, Verb::CUBIC_TO, Verb::MOVE_TO, Verb::LINE_TO,
+                         Verb::LINE_TO},
+                        {0, 0, 1000, 0, 1500, 500, 1000, 1000, 700, 1400, 300, -400, 0, 1000, 200, 200, 400, 200, 300,
+                         300},
+                        1000);
+}
+
+} // namespace
+
+TEST(GlyphOutlineTest, UnpacksToPathVector)
+{
+    auto const pv = make_outline().toPathVector();
+    ASSERT_EQ(pv.size(), 2);
+    EXPECT_TRUE(pv[0].closed());
+    EXPECT_TRUE(pv[1].closed());
+    EXPECT_EQ(pv[0].size_open(), 3);
+    EXPECT_EQ(pv[0].initialPoint(), Geom::Point(0, 0));
+    EXPECT_EQ(pv[0][1].finalPoint(), Geom::Point(1, 1));
+    EXPECT_EQ(pv[1].size_open(), 2);
+
+    auto const moved = make_outline().toPathVector(Geom::Translate(1, 2));
+    EXPECT_EQ(moved[1].initialPoint(), Geom::Point(1.2, 2.2));
+}
+
+TEST(GlyphOutlineTest, ExactBounds)
+{
+    auto const outline = make_outline();
+    for (auto const &transform : {Geom::Affine(), Geom::Affine(Geom::Rotate(0.3) * Geom::Scale(2, 3))}) {
+        auto const bounds = outline.bounds(transform);
+        auto const expected = Geom::bounds_exact(outline.toPathVector(transform));
+        ASSERT_TRUE(bounds);
+        ASSERT_TRUE(expected);
+        for (auto d : {Geom::X, Geom::Y}) {
+            EXPECT_NEAR((*bounds)[d].min(), (*expected)[d].min(), 1e-9);
+            EXPECT_NEAR((*bounds)[d].max(), (*expected)[d].max(), 1e-9);
+        }
+    }
+    EXPECT_FALSE(GlyphOutline().bounds());
+}
+
+TEST(GlyphOutlineTest, QuantisesLargeCoordinates)
+{
+    auto const outline = GlyphOutline({Verb::MOVE_TO, Verb::LINE_TO, Verb::LINE_TO}, {0, 0, 100000, 0, 0, 50}, 1000);
+    auto const pv = outline.toPathVector();
+    EXPECT_NEAR(pv[0][0].finalPoint()[Geom::X], 100, 0.01);
+    EXPECT_NEAR(pv[0][1].finalPoint()[Geom::Y], 0.05, 0.01);
+}
+
+// vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
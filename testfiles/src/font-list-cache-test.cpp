@@ -0,0 +1,100 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Font list cache test
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <gtest/gtest.h>
+
+#include <glib/gstdio.h>
+#include <glibmm/miscutils.h>
+
+#include "libnrtype/font-factory.h"
+#include "libnrtype/font-list-cache.h"
+
+using Inkscape::FontListCache;
+
+namespace {
+
+class FontListCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        dir = Glib::build_filename(Glib::get_tmp_dir(), "inkscape-font-list-cache-test");
+        path = Glib::build_filename(dir, "font-list");
+        g_unlink(path.c_str());
+    }
+
+    void TearDown() override
+    {
+        g_unlink(path.c_str());
+        g_rmdir(dir.c_str());
+    }
+
+    // Save a cache with two families, one of them with styles whose names need escaping.
+    void save(std::string const &stamp)
+    {
+        auto cache = FontListCache(path);
+        cache.reset(stamp, {"Sans", "Odd\tFamily\nName"});
+        cache.set_styles("Odd\tFamily\nName", {{"Normal"}, {"Bold Italic", "Bold\\Italic"}});
+        cache.save();
+    }
+
+    std::string dir;
+    std::string path;
+};
+
+} // namespace
+
+TEST_F(FontListCacheTest, RoundTrip)
+{
+    save("stamp");
+
+    auto cache = FontListCache(path);
+    ASSERT_TRUE(cache.load("stamp"));
+    EXPECT_EQ(cache.get_families(), (std::vector<std::string>{"Sans", "Odd\tFamily\nName"}));
+    EXPECT_EQ(cache.get_styles("Sans"), nullptr);
+
+    auto const styles = cache.get_styles("Odd\tFamily\nName");
+    ASSERT_NE(styles, nullptr);
+    ASSERT_EQ(styles->size(), 2);
+    EXPECT_EQ((*styles)[0].css_name, "Normal");
+    EXPECT_EQ((*styles)[0].display_name, "Normal");
+    EXPECT_EQ((*styles)[1].css_name, "Bold Italic");
+    EXPECT_EQ((*styles)[1].display_name, "Bold\\Italic");
+}
+
+TEST_F(FontListCacheTest, OtherStampIsIgnored)
+{
+    save("stamp");
+
+    auto cache = FontListCache(path);
+    EXPECT_FALSE(cache.load("other stamp"));
+    EXPECT_TRUE(cache.get_families().empty());
+    EXPECT_EQ(cache.get_styles("Odd\tFamily\nName"), nullptr);
+
+    // Nothing was changed since loading, so saving doesn't overwrite the file.
+    cache.save();
+    EXPECT_TRUE(FontListCache(path).load("stamp"));
+}
+
+TEST_F(FontListCacheTest, FontConfigChangeInvalidates)
+{
+    auto &factory = FontFactory::get();
+    auto const stamp = factory.GetFontConfigStamp();
+    EXPECT_EQ(factory.GetFontConfigStamp(), stamp);
+    save(stamp);
+    ASSERT_TRUE(FontListCache(path).load(stamp));
+
+    // Adding a font changes the configuration the cache was made for.
+    factory.AddFontFile(INKSCAPE_TESTS_DIR "/rendering_tests/fonts/GeomTest-Regular.otf");
+    auto const new_stamp = factory.GetFontConfigStamp();
+    EXPECT_NE(new_stamp, stamp);
+    EXPECT_FALSE(FontListCache(path).load(new_stamp));
+}
+
+// vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
@@ -18,6 +18,7 @@
 #include <src/object/sp-use.h>
 #include <src/object/sp-root.h>
 #include <src/object/object-set.h>
+#include <src/svg/svg.h>
 #include <xml/node.h>
 #include <src/xml/text-node.h>
 #include <src/xml/simple-document.h>
@@ -640,6 +641,33 @@ TEST_F(ObjectSetTest, Moves) {
     set->deleteItems();
 }
 
+TEST_F(ObjectSetTest, MovesPathsInBulk) {
+    set->add(r1.get());
+    set->add(r2.get());
+    set->toCurves();
+    r1.release();
+    r2.release();
+    auto items = set->items();
+    auto const paths = std::vector<SPItem *>(items.begin(), items.end());
+    ASSERT_EQ(2, paths.size());
+    std::vector<Geom::OptRect> before;
+    for (auto item : paths) {
+        before.push_back(item->documentGeometricBounds());
+    }
+
+    set->moveRelative(5, 0);
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        auto path = cast<SPPath>(paths[i]);
+        ASSERT_NE(nullptr, path);
+        // Not read back from the repr, but the same as it.
+        EXPECT_EQ(sp_svg_read_pathv(path->getRepr()->attribute("d")), path->curve()->get_pathvector());
+        auto const after = path->documentGeometricBounds();
+        EXPECT_NEAR(before[i]->left() + 5, after->left(), 1e-6);
+        EXPECT_NEAR(before[i]->top(), after->top(), 1e-6);
+    }
+    set->deleteItems();
+}
+
 TEST_F(ObjectSetTest, toMarker) {
     r1->x = 12;
     r1->y = 34;
@@ -202,3 +202,73 @@ TEST_F(ObjectTest, Objects) {
     // Test hrefcount
     EXPECT_TRUE(path->isReferenced());
 }
+
+TEST_F(ObjectTest, FindByClassElementSelector) {
+    ASSERT_TRUE(doc != nullptr);
+
+    auto circle = doc->getObjectById("C");
+    auto ellipse = doc->getObjectById("E");
+    auto group = doc->getObjectById("G");
+    ASSERT_TRUE(circle && ellipse && group);
+
+    ellipse->setAttribute("class", "shape round");
+    circle->setAttribute("class", "round");
+    group->setAttribute("class", "round");
+
+    // Results are in document order, parents first.
+    auto round = doc->getObjectsByClass("round");
+    ASSERT_EQ(round.size(), 3u);
+    EXPECT_EQ(round[0], group);
+    EXPECT_EQ(round[1], circle);
+    EXPECT_EQ(round[2], ellipse);
+
+    ellipse->setAttribute("class", "shape");
+    round = doc->getObjectsByClass("round");
+    ASSERT_EQ(round.size(), 2u);
+    EXPECT_EQ(doc->getObjectsByClass("shape").size(), 1u);
+    EXPECT_TRUE(doc->getObjectsByClass("no-such-class").empty());
+
+    EXPECT_EQ(doc->getObjectsBySelector(".round").size(), 2u);
+    EXPECT_EQ(doc->getObjectsBySelector("g .round").size(), 1u);
+    ASSERT_EQ(doc->getObjectsBySelector("#C").size(), 1u);
+    EXPECT_EQ(doc->getObjectsBySelector("circle").size(), 1u);
+    // Type selectors match the element name in any namespace.
+    EXPECT_EQ(doc->getObjectsBySelector("namedview").size(), 1u);
+
+    // The clone of the path inside <use> is not an object of its own.
+    auto paths = doc->getObjectsByElement("path");
+    ASSERT_EQ(paths.size(), 1u);
+    EXPECT_EQ(paths[0], doc->getObjectById("P"));
+
+    circle->deleteObject();
+    EXPECT_EQ(doc->getObjectsByClass("round").size(), 1u);
+    EXPECT_TRUE(doc->getObjectsByElement("circle").empty());
+}
+
+TEST_F(ObjectTest, SelectorLookupsAgree) {
+    ASSERT_TRUE(doc != nullptr);
+    auto path = doc->getObjectById("P");
+    ASSERT_TRUE(path);
+    path->setAttribute("class", "star");
+
+    // The path is cloned by <use>; no lookup returns the clone.
+    auto const by_id = doc->getObjectsBySelector("#P");
+    ASSERT_EQ(by_id.size(), 1u);
+    EXPECT_EQ(by_id[0], path);
+    EXPECT_EQ(doc->getObjectsBySelector("path"), by_id);
+    EXPECT_EQ(doc->getObjectsBySelector(".star"), by_id);
+
+    // A duplicate id is renamed, so the id still finds one object, like the full walk does.
+    auto dup = doc->getReprDoc()->createElement("svg:path");
+    dup->setAttribute("id", "P");
+    dup->setAttribute("class", "star");
+    doc->getReprRoot()->appendChild(dup);
+    GC::release(dup);
+
+    EXPECT_EQ(doc->getObjectsBySelector("#P"), by_id);
+    EXPECT_EQ(doc->getObjectsBySelector("path#P"), by_id);
+    auto const all = doc->getObjectsBySelector("path");
+    ASSERT_EQ(all.size(), 2u);
+    EXPECT_EQ(all[0], path);
+    EXPECT_EQ(doc->getObjectsBySelector(".star"), all);
+}
@@ -8,10 +8,12 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <gtest/gtest.h>
 #include <string>
 
+#include "io/stream/bufferstream.h"
 #include "io/stream/gzipstream.h"
 #include "io/stream/inkscapestream.h"
 #include "io/stream/stringstream.h"
@@ -151,6 +153,68 @@ TEST(StreamTest, Gzip)
     ASSERT_EQ(sourceFile.getContents(), destFile.getContents());
 }
 
+TEST(StreamTest, GzipManyBlocks)
+{
+    // Several deflate blocks, with a flush in between, and more than a read-ahead chunk to inflate.
+    std::string content;
+    for (int i = 0; content.size() < 1000000; ++i) {
+        content += "<path id=\"path" + std::to_string(i) + "\" d=\"M " + std::to_string(i % 97) + " 0 L 10 10\"/>\n";
+    }
+
+    // Compress the blocks on worker threads, however many cores the machine has.
+    auto gzOuts = Inkscape::IO::BufferOutputStream();
+    {
+        auto gzipOuts = Inkscape::IO::GzipOutputStream(gzOuts, 4);
+        for (std::size_t i = 0; i < content.size(); ++i) {
+            gzipOuts.put(content[i]);
+            if (i == content.size() / 3) {
+                gzipOuts.flush();
+            }
+        }
+    }
+    ASSERT_LT(gzOuts.getBuffer().size(), content.size());
+
+    auto gzIns = Inkscape::IO::BufferInputStream(gzOuts.getBuffer());
+    auto gzipIns = Inkscape::IO::GzipInputStream(gzIns);
+    std::string result;
+    for (int ch; (ch = gzipIns.get()) >= 0;) {
+        result.push_back(static_cast<char>(ch));
+    }
+    ASSERT_EQ(result, content);
+}
+
+TEST(StreamTest, GzipBulkWrite)
+{
+    // Runs of bytes which straddle the deflate blocks, mixed with single bytes.
+    std::string content;
+    for (int i = 0; content.size() < 400000; ++i) {
+        content += "<rect id=\"rect" + std::to_string(i) + "\" width=\"" + std::to_string(i % 89) + "\"/>\n";
+    }
+
+    auto gzOuts = Inkscape::IO::BufferOutputStream();
+    {
+        auto gzipOuts = Inkscape::IO::GzipOutputStream(gzOuts, 2);
+        auto outs = Inkscape::IO::OutputStreamWriter(gzipOuts);
+        std::size_t pos = 0;
+        for (std::size_t run = 1; pos < content.size(); run = run * 7 % 100003) {
+            auto const n = std::min(run, content.size() - pos);
+            outs.write(content.data() + pos, n);
+            pos += n;
+            if (pos < content.size()) {
+                outs.put(content[pos++]);
+            }
+        }
+    }
+
+    auto gzIns = Inkscape::IO::BufferInputStream(gzOuts.getBuffer());
+    auto gzipIns = Inkscape::IO::GzipInputStream(gzIns);
+    std::string result;
+    for (int ch; (ch = gzipIns.get()) >= 0;) {
+        result.push_back(static_cast<char>(ch));
+    }
+    ASSERT_EQ(result, content);
+}
+
 TEST(StreamTest, GzipFExtraFComment)
 {
     auto inFile = MyFile(INKSCAPE_TESTS_DIR "/data/example-FEXTRA-FCOMMENT.gz");
@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/** @file
+ * Test the number formatting used for writing SVG
+ *//*
+ * Authors: see git history
+ *
+ * Copyright (C) 2026 Authors
+ * Released under GNU GPL v2+, read the file 'COPYING' for more information.
+ */
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <glib.h>
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+#include "svg/svg-number.h"
+#include "svg/svg.h"
+
+using namespace Inkscape::SVG;
+
+static std::string format(double val, int precision, int min_exp)
+{
+    std::string str;
+    append_number(str, val, precision, min_exp);
+    return str;
+}
+
+TEST(SvgNumberTest, testPrecision)
+{
+    EXPECT_EQ(format(761.92918978947023, 2, -8), "760");
+    EXPECT_EQ(format(761.92918978947023, 4, -8), "761.9");
+    EXPECT_EQ(format(761.92918978947023, 8, -8), "761.92919");
+    EXPECT_EQ(format(-3444.9083860107203, 3, -8), "-3440");
+    EXPECT_EQ(format(123456789, 8, -8), "123456790");
+    EXPECT_EQ(format(123456789, 4, -8), "1.235e8");
+    EXPECT_EQ(format(9.99999999, 8, -8), "10");
+    EXPECT_EQ(format(0.1, 8, -8), "0.1");
+    // Values below 1 keep 'precision' decimal places
+    EXPECT_EQ(format(0.00123456789, 8, -8), "0.00123457");
+    EXPECT_EQ(format(-0.0004, 8, -8), "-4e-4");
+    EXPECT_EQ(format(1.5e-9, 8, -8), "0");
+    EXPECT_EQ(format(-0.0017, 1, -8), "0");
+    EXPECT_EQ(format(0.0, 8, -8), "0");
+    EXPECT_EQ(format(-0.0, 8, -8), "0");
+}
+
+TEST(SvgNumberTest, testGeneral)
+{
+    char buf[NUMBER_BUFFER_SIZE];
+    auto general = [&] (double val, int precision) {
+        return std::string(buf, write_number_general(buf, val, precision));
+    };
+    EXPECT_EQ(general(-53.5, 8), "-53.5");
+    EXPECT_EQ(general(1.23456789, 8), "1.2345679");
+    EXPECT_EQ(general(1.234e-12, 8), "1.234e-12");
+    EXPECT_EQ(general(3e9, 8), "3e+09");
+    EXPECT_EQ(general(-2000000000, 8), "-2000000000");
+}
+
+TEST(SvgNumberTest, testRoundTrip)
+{
+    std::mt19937_64 rng(1);
+    char buf[NUMBER_BUFFER_SIZE + 1];
+
+    for (int i = 0; i < 100000; i++) {
+        double val;
+        do {
+            auto const bits = rng();
+            std::memcpy(&val, &bits, sizeof(val));
+        } while (!std::isfinite(val));
+
+        // Shortest representation reads back exactly
+        *write_number_shortest(buf, val) = '\0';
+        ASSERT_EQ(g_ascii_strtod(buf, nullptr), val) << buf;
+
+        // So does full precision SVG output
+        *write_number(buf, val, NUMBER_MAX_PRECISION, -400) = '\0';
+        ASSERT_EQ(g_ascii_strtod(buf, nullptr), val) << buf;
+
+        // Rounded output is within half a unit in the last place
+        double const small = std::ldexp(static_cast<double>(rng() >> 11), -static_cast<int>(rng() % 60));
+        for (int precision = 1; precision < NUMBER_MAX_PRECISION; precision++) {
+            *write_number(buf, small, precision, -400) = '\0';
+            double const read = g_ascii_strtod(buf, nullptr);
+            double const exponent = std::floor(std::log10(small));
+            double const ulp = std::pow(10.0, exponent - std::min(precision - 1, precision + static_cast<int>(exponent)));
+            ASSERT_LE(std::fabs(read - small), 0.5 * ulp + small * DBL_EPSILON) << buf << " precision " << precision;
+        }
+    }
+}
+
+TEST(SvgNumberTest, testLegacyWriter)
+{
+    // sp_svg_number_write_de() is now a wrapper
+    EXPECT_EQ(sp_svg_number_write_de(761.92918978947023, 4, -8), "761.9");
+    EXPECT_EQ(sp_svg_number_write_de(1e-5, 8, -8), "1e-5");
+}
+
+// vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
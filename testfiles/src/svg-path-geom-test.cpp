@@ -10,6 +10,7 @@
 #include <2geom/coord.h>
 #include <2geom/curves.h>
 #include <2geom/pathvector.h>
+#include <chrono>
 #include <glib.h>
 #include <gtest/gtest.h>
 #include <vector>
@@ -482,6 +483,59 @@ TEST_F(SvgPathGeomTest, testRoundTrip)
     ASSERT_TRUE(path_str == "M 2,3 L 22,3 L 32,3 L 32,13 C 65.33,19.67 78.67,28 72,38 C 65.33,48 88.67,56.33 142,63 L 142,73 C 147,79 152,78 152,83 C 152,88 162,103 157,89 Z");
 }
 
+TEST_F(SvgPathGeomTest, testReadNumbersExactly)
+{
+    // Numbers that do not fit the fast conversion path must still round exactly like strtod
+    char const *numbers[] = {"123456789012345678901234", "0.1", "-0.30000000000000004", "1.7976931348623157e308",
+                             "4.9e-324", "0.000000000000000000000000012345", "3.14159265358979323846264338",
+                             "9007199254740993", "2.2250738585072014e-308", "1e23"};
+    for (auto number : numbers) {
+        std::string path_str = std::string("M ") + number + ",0";
+        Geom::PathVector pv = sp_svg_read_pathv(path_str.c_str());
+        ASSERT_EQ(pv.size(), 1u) << path_str;
+        ASSERT_EQ(pv[0].initialPoint()[Geom::X], g_ascii_strtod(number, nullptr)) << path_str;
+    }
+}
+
+TEST_F(SvgPathGeomTest, testReadCompactArcFlags)
+{
+    // Arc flags are single characters and need no separator
+    Geom::PathVector pv = sp_svg_read_pathv("M0 0a10 10 0 0110 10A10,10,0,1,0,0,0");
+    ASSERT_EQ(pv.size(), 1u);
+    ASSERT_EQ(pv[0].size(), 2u);
+    auto arc = dynamic_cast<Geom::EllipticalArc const *>(&pv[0][0]);
+    ASSERT_TRUE(arc);
+    EXPECT_FALSE(arc->largeArc());
+    EXPECT_TRUE(arc->sweep());
+    EXPECT_EQ(arc->finalPoint(), Geom::Point(10, 10));
+}
+
+/*
+ * Throughput of the path data parser, run with --gtest_also_run_disabled_tests.
+ */
+TEST(SvgPathReadBenchmark, DISABLED_throughput)
+{
+    std::string path_str = "M 12.5,7.25";
+    for (int i = 0; i < 200000; i++) {
+        path_str += " c 1.2345,-6.789 10.1112,-13.1415 16.1718,-19.2021 l 22.2324,25.2627 h -2.8293 v 0.3031";
+        path_str += " q -3.2333,4.3536 -3.7383,9.4041 a 4.2434,4.4454 0 1 0 -46.4748,49.5051";
+    }
+    path_str += " z";
+
+    int const runs = 5;
+    auto const start = std::chrono::steady_clock::now();
+    size_t curves = 0;
+    for (int i = 0; i < runs; i++) {
+        curves += sp_svg_read_pathv(path_str.c_str()).curveCount();
+    }
+    std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+
+    double const megabytes = static_cast<double>(path_str.size()) * runs / (1024 * 1024);
+    printf("Parsed %.1f MB (%zu curves) in %.3f s: %.1f MB/s\n", megabytes, curves, elapsed.count(),
+           megabytes / elapsed.count());
+    ASSERT_GT(curves, 0u);
+}
+
 TEST(PathVectorToBeziersTest, random)
 {
     // Evil test will crash if not protected
@@ -13,10 +13,16 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
+#include "util/cached_map.h"
 #include "util/longest-common-suffix.h"
 #include "util/parse-int-range.h"
 #include "util/delete-with.h"
+#include "util/json.h"
 
 TEST(UtilTest, NearestCommonAncestor)
 {
@@ -145,4 +151,69 @@ TEST(UtilTest, DeleteWithTest)
     ASSERT_EQ(flag, false);
 }
 
+TEST(UtilTest, JsonTest)
+{
+    using Inkscape::Util::JsonValue;
+
+    auto job = JsonValue::parse(R"( {"id": 7, "open": "a \"b\".svg", "export": {"dpi": 96.5, "id-only": true},
+                                     "actions": ["select-all", "\u00e9\ud83d\ude00"], "close": null} )");
+    ASSERT_TRUE(job);
+    ASSERT_TRUE(job->isObject());
+    EXPECT_EQ(*job->find("id")->getNumber(), 7);
+    EXPECT_EQ(*job->find("open")->getString(), "a \"b\".svg");
+    EXPECT_EQ(*job->find("export")->find("dpi")->getNumber(), 96.5);
+    EXPECT_TRUE(*job->find("export")->find("id-only")->getBool());
+    EXPECT_EQ(job->find("actions")->getArray()->at(1).getString()->size(), 6); // UTF-8
+    EXPECT_TRUE(job->find("close")->isNull());
+    EXPECT_EQ(job->find("missing"), nullptr);
+
+    // Members are written sorted by name, without whitespace.
+    EXPECT_EQ(job->serialize(), R"({"actions":["select-all","é😀"],"close":null,)"
+                                R"("export":{"dpi":96.5,"id-only":true},"id":7,"open":"a \"b\".svg"})");
+    EXPECT_EQ(JsonValue(std::string("line\nbreak\x01")).serialize(), R"("line\nbreak\u0001")");
+
+    std::string error;
+    for (auto bad : {"", "{", "[1,]", "01", "{\"a\" 1}", "tru", "\"\\ud800\"", "1 2", "1.", "\"\t\""}) {
+        EXPECT_FALSE(JsonValue::parse(bad, &error)) << bad;
+        EXPECT_FALSE(error.empty());
+        error.clear();
+    }
+    EXPECT_FALSE(JsonValue::parse(std::string(100, '[') + std::string(100, ']')));
+}
+
+TEST(UtilTest, CachedMapThreads)
+{
+    static std::atomic<int> alive = 0;
+    struct Value
+    {
+        int key;
+        Value(int key) : key(key) { alive++; }
+        ~Value() { alive--; }
+    };
+
+    auto map = Inkscape::Util::cached_map<int, Value>(4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&map, t] {
+            for (int i = 0; i < 10000; i++) {
+                int const key = (i * 7 + t) % 16;
+                auto value = map.lookup(key);
+                if (!value) {
+                    value = map.add(key, std::make_unique<Value>(key));
+                }
+                EXPECT_EQ(value->key, key);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // add() keeps at most 4 unused values, then the one it returned becomes unused too.
+    map.add(100, std::make_unique<Value>(100));
+    EXPECT_LE(alive, 5);
+    map.clear();
+    EXPECT_EQ(alive, 0);
+}
+
 // vim: filetype=cpp:expandtab:shiftwidth=4:softtabstop=4:fileencoding=utf-8:textwidth=99 :
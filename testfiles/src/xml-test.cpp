@@ -12,11 +12,19 @@
  * Released under GNU GPL v2+, read the file 'COPYING' for more information.
  */
 
+#include <cstdio>
 #include <list>
 #include <memory>
+#include <span>
 #include <string>
+#include <vector>
 #include "gtest/gtest.h"
+#include "xml/event.h"
+#include "xml/event-fns.h"
+#include "xml/node-observer.h"
+#include "xml/packed-log.h"
 #include "xml/repr.h"
+#include "xml/serialization-cache.h"
 
 #include <list>
 
@@ -100,6 +108,325 @@ NODE
 )""");
 }
 
+static std::string save_to_string(Inkscape::XML::Document *doc, Inkscape::XML::SerializationCache *cache,
+                                  char const *old_href_base = nullptr, char const *new_href_base = nullptr)
+{
+    FILE *file = std::tmpfile();
+    sp_repr_save_stream(doc, file, SP_SVG_NS_URI, false, old_href_base, new_href_base, cache);
+    std::string result;
+    std::rewind(file);
+    for (int c; (c = std::fgetc(file)) != EOF;) {
+        result += static_cast<char>(c);
+    }
+    std::fclose(file);
+    return result;
+}
+
+TEST(XmlSerializationCacheTest, reusesCleanSubtrees)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(R"""(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <g id="layer1"><rect id="r1" width="1"/><text xml:space="preserve">a<tspan>b</tspan></text></g>
+  <g id="layer2"><circle id="c1" r="2"/><g><path id="p1" d="M 0,0 H 1"/></g></g>
+</svg>
+)""", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto const find = [&](char const *id) { return sp_repr_lookup_child(testdoc->root(), "id", id); };
+
+    Inkscape::XML::SerializationCache cache(*testdoc);
+
+    auto const full = save_to_string(testdoc.get(), nullptr);
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), full);
+    EXPECT_GT(cache.size(), 0u);
+    // The second save is served from the cache.
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), full);
+
+    find("layer1")->firstChild()->setAttribute("width", "5");
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), save_to_string(testdoc.get(), nullptr));
+
+    auto path = sp_repr_lookup_descendant(testdoc->root(), "id", "p1");
+    ASSERT_TRUE(path);
+    path->parent()->removeChild(path);
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), save_to_string(testdoc.get(), nullptr));
+
+    auto layer2 = find("layer2");
+    auto circle = layer2->firstChild();
+    layer2->changeOrder(circle, layer2->lastChild());
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), save_to_string(testdoc.get(), nullptr));
+
+    auto text = find("layer1")->lastChild()->firstChild();
+    text->setContent("changed");
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), save_to_string(testdoc.get(), nullptr));
+}
+
+TEST(XmlSerializationCacheTest, keepsEntriesForAlternatingSettings)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(R"""(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <g id="layer1"><rect id="r1" width="1"/><circle id="c1" r="2"/></g>
+</svg>
+)""", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+
+    Inkscape::XML::SerializationCache cache(*testdoc);
+
+    // Autosaves don't rebase hrefs, while saving to a file does.
+    save_to_string(testdoc.get(), &cache);
+    auto const size = cache.size();
+    ASSERT_GT(size, 0u);
+    save_to_string(testdoc.get(), &cache, "/old", "/new");
+    EXPECT_EQ(cache.size(), 2 * size);
+    save_to_string(testdoc.get(), &cache);
+    EXPECT_EQ(cache.size(), 2 * size);
+
+    // Further settings replace the least recently used ones.
+    save_to_string(testdoc.get(), &cache, "/old", "/other");
+    EXPECT_EQ(cache.size(), 2 * size);
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), save_to_string(testdoc.get(), nullptr));
+
+    // Changes invalidate the entries for all settings.
+    sp_repr_lookup_descendant(testdoc->root(), "id", "r1")->setAttribute("width", "2");
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache, "/old", "/other"),
+              save_to_string(testdoc.get(), nullptr, "/old", "/other"));
+    EXPECT_EQ(save_to_string(testdoc.get(), &cache), save_to_string(testdoc.get(), nullptr));
+}
+
+TEST(XmlSerializationCacheTest, snapshotMatchesSave)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf(R"""(
+<svg xmlns="http://www.w3.org/2000/svg">
+  <g id="layer1"><rect id="r1" width="1"/></g>
+</svg>
+)""", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+
+    Inkscape::XML::SerializationCache cache(*testdoc);
+    auto const to_string = [](Inkscape::XML::SerializedDocument const &snapshot) {
+        std::string result;
+        for (auto const &chunk : snapshot.chunks()) {
+            result += *chunk;
+        }
+        EXPECT_EQ(result.size(), snapshot.size());
+        return result;
+    };
+
+    auto const first = sp_repr_save_snapshot(testdoc.get(), SP_SVG_NS_URI, &cache);
+    EXPECT_EQ(to_string(*first), save_to_string(testdoc.get(), nullptr));
+
+    // Snapshots are not affected by later changes.
+    auto const saved = to_string(*first);
+    sp_repr_lookup_descendant(testdoc->root(), "id", "r1")->setAttribute("width", "2");
+    auto const second = sp_repr_save_snapshot(testdoc.get(), SP_SVG_NS_URI, &cache);
+    EXPECT_EQ(to_string(*first), saved);
+    EXPECT_EQ(to_string(*second), save_to_string(testdoc.get(), nullptr));
+}
+
+TEST(XmlTest, orderKeysFollowPositions)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(sp_repr_read_buf("<svg/>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto root = testdoc->root();
+
+    std::vector<Inkscape::XML::Node *> nodes;
+    for (int i = 0; i < 500; ++i) {
+        auto node = testdoc->createElement("svg:g");
+        root->appendChild(node);
+        Inkscape::GC::release(node);
+        nodes.push_back(node);
+    }
+
+    // Moving nodes to the front and into the same gap over and over uses up the room between keys.
+    for (int i = 0; i < 200; ++i) {
+        nodes[(i * 7) % nodes.size()]->setPosition(0);
+        root->changeOrder(nodes[(i * 13) % nodes.size()], root->firstChild());
+        nodes[(i * 11) % nodes.size()]->setPosition(-1);
+    }
+    root->removeChild(nodes[42]);
+
+    for (auto node = root->firstChild(); node && node->next(); node = node->next()) {
+        ASSERT_LT(node->orderKey(), node->next()->orderKey());
+    }
+    EXPECT_LT(sp_repr_compare_position(root->nthChild(10), root->nthChild(400)), 0);
+    EXPECT_GT(sp_repr_compare_position(root->lastChild(), root->firstChild()), 0);
+    EXPECT_EQ(sp_repr_compare_position(root->firstChild(), root->firstChild()), 0);
+}
+
+TEST(XmlTest, packedLogUndoes)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(
+        sp_repr_read_buf("<svg><path id=\"p\" d=\"M 0,0 L 10,10 L 20,0\" fill=\"red\"/>text</svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto path = sp_repr_lookup_descendant(testdoc->root(), "id", "p");
+    auto text = testdoc->root()->lastChild();
+    ASSERT_TRUE(path && text);
+
+    testdoc->beginTransaction();
+    path->setAttribute("d", "M 0,0 L 10,15 L 20,0");
+    path->setAttribute("fill", nullptr);
+    path->setAttribute("d", "M 0,0 L 10,15 L 20,0 Z");
+    path->setAttribute("stroke", "blue");
+    text->setContent("other text");
+    auto log = testdoc->commitUndoable();
+
+    Inkscape::XML::SpillFile spill;
+    Inkscape::XML::PackedLog packed(log, &spill);
+    EXPECT_GT(packed.size(), 0u);
+    packed.unpack(log);
+
+    sp_repr_undo_log(log);
+    EXPECT_STREQ(path->attribute("d"), "M 0,0 L 10,10 L 20,0");
+    EXPECT_STREQ(path->attribute("fill"), "red");
+    EXPECT_EQ(path->attribute("stroke"), nullptr);
+    EXPECT_STREQ(text->content(), "text");
+
+    sp_repr_replay_log(log);
+    EXPECT_STREQ(path->attribute("d"), "M 0,0 L 10,15 L 20,0 Z");
+    EXPECT_EQ(path->attribute("fill"), nullptr);
+    EXPECT_STREQ(text->content(), "other text");
+    sp_repr_free_log(log);
+}
+
+TEST(XmlTest, packedLogKeepsLaterValues)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(
+        sp_repr_read_buf("<svg><path id=\"p\" d=\"M 0,0 L 10,10\"/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto path = sp_repr_lookup_descendant(testdoc->root(), "id", "p");
+    ASSERT_TRUE(path);
+
+    testdoc->beginTransaction();
+    path->setAttribute("d", "M 0,0 L 10,20");
+    path->setAttribute("d", "M 0,0 L 10,30");
+    auto log = testdoc->commitUndoable();
+    Inkscape::XML::PackedLog packed(log);
+
+    // Changed without being logged, as under DocumentUndo::ScopedInsensitive.
+    testdoc->beginTransaction();
+    path->setAttribute("d", "M 5,5");
+    sp_repr_free_log(testdoc->commitUndoable());
+
+    packed.unpack(log);
+    sp_repr_replay_log(log);
+    EXPECT_STREQ(path->attribute("d"), "M 0,0 L 10,30");
+    sp_repr_undo_log(log);
+    EXPECT_STREQ(path->attribute("d"), "M 0,0 L 10,10");
+    sp_repr_free_log(log);
+}
+
+TEST(XmlTest, repeatedAttributeChangesAreCoalesced)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(
+        sp_repr_read_buf("<svg><rect id=\"a\" x=\"0\"/><rect id=\"b\" x=\"0\"/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto a = sp_repr_lookup_descendant(testdoc->root(), "id", "a");
+    auto b = sp_repr_lookup_descendant(testdoc->root(), "id", "b");
+
+    auto count_events = [](Inkscape::XML::Event const *log) {
+        int count = 0;
+        for (; log; log = log->next) {
+            ++count;
+        }
+        return count;
+    };
+
+    // Within a transaction, as during a drag.
+    testdoc->beginTransaction();
+    for (int i = 1; i <= 100; ++i) {
+        a->setAttributeInt("x", i);
+        b->setAttributeInt("x", -i);
+    }
+    auto log = testdoc->commitUndoable();
+    EXPECT_EQ(count_events(log), 2);
+
+    // Across transactions coalesced into one undo step, as for slider changes.
+    for (int i = 1; i <= 10; ++i) {
+        testdoc->beginTransaction();
+        a->setAttributeInt("y", i);
+        b->setAttributeInt("y", i);
+        log = sp_repr_coalesce_log(log, testdoc->commitUndoable());
+    }
+    EXPECT_EQ(count_events(log), 4);
+    EXPECT_STREQ(b->attribute("y"), "10");
+
+    sp_repr_undo_log(log);
+    EXPECT_STREQ(a->attribute("x"), "0");
+    EXPECT_STREQ(b->attribute("x"), "0");
+    EXPECT_EQ(a->attribute("y"), nullptr);
+    sp_repr_replay_log(log);
+    EXPECT_STREQ(a->attribute("x"), "100");
+    EXPECT_STREQ(b->attribute("x"), "-100");
+    EXPECT_STREQ(a->attribute("y"), "10");
+    sp_repr_free_log(log);
+}
+
+TEST(XmlTest, bulkAttributeChangesAreOneEvent)
+{
+    auto testdoc = std::shared_ptr<Inkscape::XML::Document>(
+        sp_repr_read_buf("<svg><rect id=\"a\" x=\"0\"/><rect id=\"b\" x=\"0\"/></svg>", SP_SVG_NS_URI));
+    ASSERT_TRUE(testdoc);
+    auto a = sp_repr_lookup_descendant(testdoc->root(), "id", "a");
+    auto b = sp_repr_lookup_descendant(testdoc->root(), "id", "b");
+
+    auto count_events = [](Inkscape::XML::Event const *log) {
+        int count = 0;
+        for (; log; log = log->next) {
+            ++count;
+        }
+        return count;
+    };
+
+    struct Observer : Inkscape::XML::NodeObserver
+    {
+        int calls = 0;
+        std::size_t changes = 0;
+        void notifyAttributesChanged(Inkscape::XML::Node &, std::span<Inkscape::XML::AttributeChange const> c) override
+        {
+            ++calls;
+            changes += c.size();
+        }
+    } observer;
+    a->addObserver(observer);
+
+    testdoc->beginTransaction();
+    testdoc->beginBulkAttributes();
+    a->setAttribute("x", "1");
+    a->setAttribute("y", "1");
+    b->setAttribute("x", "1");
+    EXPECT_EQ(observer.calls, 0);
+    testdoc->endBulkAttributes();
+    EXPECT_EQ(observer.calls, 1);
+    EXPECT_EQ(observer.changes, 2u);
+    auto log = testdoc->commitUndoable();
+    EXPECT_EQ(count_events(log), 1);
+
+    // Coalesced into the same undo step, as during a drag.
+    testdoc->beginTransaction();
+    testdoc->beginBulkAttributes();
+    a->setAttribute("x", "2");
+    b->setAttribute("x", "2");
+    testdoc->endBulkAttributes();
+    log = sp_repr_coalesce_log(log, testdoc->commitUndoable());
+    EXPECT_EQ(count_events(log), 1);
+    EXPECT_EQ(observer.calls, 2);
+
+    Inkscape::XML::PackedLog packed(log);
+    packed.unpack(log);
+
+    sp_repr_undo_log(log);
+    EXPECT_STREQ(a->attribute("x"), "0");
+    EXPECT_EQ(a->attribute("y"), nullptr);
+    EXPECT_STREQ(b->attribute("x"), "0");
+    EXPECT_EQ(observer.calls, 3);
+    sp_repr_replay_log(log);
+    EXPECT_STREQ(a->attribute("x"), "2");
+    EXPECT_STREQ(a->attribute("y"), "1");
+    EXPECT_STREQ(b->attribute("x"), "2");
+    EXPECT_EQ(observer.calls, 4);
+
+    a->removeObserver(observer);
+    sp_repr_free_log(log);
+}
+
 /*
   Local Variables:
   mode:c++